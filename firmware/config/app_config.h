@@ -33,6 +33,382 @@
 // </e>
 
 
+//==========================================================
+// <e> TIMER_SLACK - Coalesce wakeups of periodic timers
+// <i> Slack timers declare how late they can expire and share one app_timer.
+// <i> Reports and HV pump steady pause are served in RPW second tick wakeup
+// <i> instead of waking CPU by themselves.
+#ifndef TIMER_SLACK
+#define TIMER_SLACK 0
+#endif
+
+#if TIMER_SLACK
+
+// <o> TIMER_SLACK_HV_MS - HV pump steady pause can be delayed by (ms) <0-5000>
+#ifndef TIMER_SLACK_HV_MS
+#define TIMER_SLACK_HV_MS 1000
+#endif
+
+#endif // TIMER_SLACK
+// </e>
+
+
+//==========================================================
+// <e> PULSE_HW_COUNTER - Count pulses by TIMER2 through PPI at high pulse rate
+// <i> Interrupt per pulse stays for tiristor reset, but it doesn't count, so pulses
+// <i> merged while interrupt waits for radio are counted anyway.
+// <i> TIMER2 and two GPIOTE channels are shared with sound module.
+// <i> Counting returns to interrupt per pulse while sound plays
+#ifndef PULSE_HW_COUNTER
+#define PULSE_HW_COUNTER 0
+#endif
+
+#if PULSE_HW_COUNTER
+
+// <o> PULSE_HW_COUNTER_ON_CPS - Pulse rate to switch on hardware counting (pulses per second)
+#ifndef PULSE_HW_COUNTER_ON_CPS
+#define PULSE_HW_COUNTER_ON_CPS 200
+#endif
+
+// <o> PULSE_HW_COUNTER_OFF_CPS - Pulse rate to switch off hardware counting (pulses per second)
+#ifndef PULSE_HW_COUNTER_OFF_CPS
+#define PULSE_HW_COUNTER_OFF_CPS 50
+#endif
+
+#endif // PULSE_HW_COUNTER
+// </e>
+
+
+//==========================================================
+// <e> PULSE_TIMESTAMP_CAPTURE - Send RTC tick of every pulse over BLE
+// <i> Pulse interrupt stores RTC1 counter (1/32768 s) to a ring, main loop sends
+// <i> varint deltas by notifications. Link throughput limits sustainable rate:
+// <i> 15 bytes of deltas per notification, deltas above 127 ticks take 2 bytes, so
+// <i> about 225 cps at 50 ms connection interval with one notification per connection
+// <i> event (test_pulse_ts). Excess pulses are counted as lost. Pulses merged while
+// <i> the interrupt waits for radio aren't captured, about 1 % at 200 cps.
+#ifndef PULSE_TIMESTAMP_CAPTURE
+#define PULSE_TIMESTAMP_CAPTURE 0
+#endif
+
+#if PULSE_TIMESTAMP_CAPTURE
+
+// <o> PULSE_TS_RING_SIZE - Timestamps kept until sending
+// <32=> 32
+// <64=> 64
+// <128=> 128
+// <256=> 256
+#ifndef PULSE_TS_RING_SIZE
+#define PULSE_TS_RING_SIZE 128
+#endif
+
+#endif // PULSE_TIMESTAMP_CAPTURE
+// </e>
+
+
+//==========================================================
+// <o> RPW_WINDOW_S  - Realtime watcher sliding window for instant value and alarm
+// <i> Alarm thresholds are scaled from 40 sec window
+// <10=> 10 sec
+// <40=> 40 sec
+// <120=> 120 sec
+#ifndef RPW_WINDOW_S
+#define RPW_WINDOW_S 40
+#endif
+
+// <e> RPW_ADAPTIVE_WINDOW - Instant value by the shortest window giving target error
+// <i> Window shrinks down to one second at high rate and grows up to RPW_WINDOW_S
+// <i> at background. Instant value characteristic gets window and error.
+#ifndef RPW_ADAPTIVE_WINDOW
+#define RPW_ADAPTIVE_WINDOW 0
+#endif
+
+#if RPW_ADAPTIVE_WINDOW
+
+// <o> RPW_TARGET_ERR_PM - Target relative error in 1/1000 <30-500>
+#ifndef RPW_TARGET_ERR_PM
+#define RPW_TARGET_ERR_PM 100
+#endif
+
+#endif // RPW_ADAPTIVE_WINDOW
+// </e>
+
+
+//==========================================================
+// <e> ALARM_CUSUM - Sequential alarm detector instead of window sum thresholds
+// <i> Poisson CUSUM of pulses per second tests background rate against alarm rates
+// <i> chosen so that each sum grows only above its warning or danger threshold rate.
+// <i> Alarm comes in seconds after a step change
+// <i> instead of a window fill, false alarm rate is set by ALARM_ARL_DAYS.
+#ifndef ALARM_CUSUM
+#define ALARM_CUSUM 0
+#endif
+
+#if ALARM_CUSUM
+
+// <o> ALARM_ARL_DAYS - Mean time between false alarms at background (days) <1-10000>
+// <i> Longer time makes detection a bit slower
+#ifndef ALARM_ARL_DAYS
+#define ALARM_ARL_DAYS 365
+#endif
+
+// <o> ALARM_BG_SBM20_MCPS - SBM20 background rate in 1/1000 pulse per second <1-2000>
+#ifndef ALARM_BG_SBM20_MCPS
+#define ALARM_BG_SBM20_MCPS 400
+#endif
+
+// <o> ALARM_BG_J305_MCPS - J305 background rate in 1/1000 pulse per second <1-2000>
+#ifndef ALARM_BG_J305_MCPS
+#define ALARM_BG_J305_MCPS 300
+#endif
+
+#endif // ALARM_CUSUM
+// </e>
+
+
+//==========================================================
+// <e> HV_ADAPTIVE_PAUSE - Adapt HV pump pause to capacitor droop
+// <i> Steady pause grows while one pump cycle recharges capacitor and shrinks when
+// <i> more cycles are needed. Pump is kicked in advance by count rate, before pulses
+// <i> discharge capacitor below tube working voltage. Pulse budget of the kick is
+// <i> adapted the same way by cycles of kicked recharges.
+#ifndef HV_ADAPTIVE_PAUSE
+#define HV_ADAPTIVE_PAUSE 0
+#endif
+
+#if HV_ADAPTIVE_PAUSE
+
+// <o> HV_STEADY_PAUSE_MIN_MS - Minimal steady pause (ms) <100-60000>
+#ifndef HV_STEADY_PAUSE_MIN_MS
+#define HV_STEADY_PAUSE_MIN_MS 2000
+#endif
+
+// <o> HV_STEADY_PAUSE_MAX_MS - Maximal steady pause (ms) <1000-300000>
+#ifndef HV_STEADY_PAUSE_MAX_MS
+#define HV_STEADY_PAUSE_MAX_MS 60000
+#endif
+
+// <o> HV_PULSE_BUDGET - Initial pulses capacitor supplies without recharge <1-1000>
+#ifndef HV_PULSE_BUDGET
+#define HV_PULSE_BUDGET 10
+#endif
+
+// <o> HV_PULSE_BUDGET_MAX - Maximal adapted pulse budget <10-100000>
+#ifndef HV_PULSE_BUDGET_MAX
+#define HV_PULSE_BUDGET_MAX 5000
+#endif
+
+#endif // HV_ADAPTIVE_PAUSE
+// </e>
+
+
+//==========================================================
+// <e> HV_ON_PHASE_TUNING - Tune HV pump on phase by cycles needed for recharge
+// <i> On phase is shortened while capacitor is recharged by less cycles than target
+// <i> and lengthened when it needs more, so the coil is not overdriven with fresh
+// <i> battery and pump keeps up with sagged one.
+#ifndef HV_ON_PHASE_TUNING
+#define HV_ON_PHASE_TUNING 0
+#endif
+
+#if HV_ON_PHASE_TUNING
+
+// <o> HV_ON_PHASE_MIN_NS - Minimal on phase (ns) <1000-60000>
+#ifndef HV_ON_PHASE_MIN_NS
+#define HV_ON_PHASE_MIN_NS 5000
+#endif
+
+// <o> HV_ON_PHASE_MAX_NS - Maximal on phase (ns) <1000-60000>
+#ifndef HV_ON_PHASE_MAX_NS
+#define HV_ON_PHASE_MAX_NS 30000
+#endif
+
+// <o> HV_ON_PHASE_STEP_NS - Tuning step (ns) <1000-5000>
+#ifndef HV_ON_PHASE_STEP_NS
+#define HV_ON_PHASE_STEP_NS 1000
+#endif
+
+// <o> HV_TUNE_TARGET_CYCLES - Target pump cycles per recharge <1-10>
+#ifndef HV_TUNE_TARGET_CYCLES
+#define HV_TUNE_TARGET_CYCLES 2
+#endif
+
+// <o> HV_TUNE_WINDOW - Recharges averaged for one tuning step <1-64>
+#ifndef HV_TUNE_WINDOW
+#define HV_TUNE_WINDOW 8
+#endif
+
+#endif // HV_ON_PHASE_TUNING
+// </e>
+
+
+//==========================================================
+// <q> HV_PPI_CHAIN - HV pump cycle in one wakeup
+// <i> Pump pins are switched by PPI and TIMER1 stops itself by short. TIMER1 and LPCOMP
+// <i> interrupts are not used, app_timer callback starts the cycle and polls its events,
+// <i> so a pump cycle costs one wakeup instead of four.
+#ifndef HV_PPI_CHAIN
+#define HV_PPI_CHAIN 0
+#endif
+
+
+//==========================================================
+// <h> Dead time correction
+
+// <o> DEAD_TIME_CORRECTION  - Tube dead time model to restore lost pulses
+// <0=> Off
+// <1=> Non-paralyzable
+// <2=> Paralyzable
+#ifndef DEAD_TIME_CORRECTION
+#define DEAD_TIME_CORRECTION 0
+#endif
+
+// <o> DEAD_TIME_SBM20_US - SBM20 tube dead time including pulse interrupt latency (us)
+#ifndef DEAD_TIME_SBM20_US
+#define DEAD_TIME_SBM20_US 190
+#endif
+
+// <o> DEAD_TIME_J305_US - J305 tube dead time including pulse interrupt latency (us)
+#ifndef DEAD_TIME_J305_US
+#define DEAD_TIME_J305_US 100
+#endif
+
+// </h>
+
+
+//==========================================================
+// <e> EXT_FLASH_LOG - Persistent history log on external MX25V1635F SPI flash
+// <i> FLASH_xxx_PIN must be defined in pinmap.h
+#ifndef EXT_FLASH_LOG
+#define EXT_FLASH_LOG 0
+#endif
+
+#if EXT_FLASH_LOG
+
+// <o> FLASH_LOG_SECTORS - 4 KB sectors used by log ring <2-512>
+// <i> Each sector keeps 511 records
+#ifndef FLASH_LOG_SECTORS
+#define FLASH_LOG_SECTORS 512
+#endif
+
+#define SPI_ENABLED   1
+#define SPI0_ENABLED  1
+
+#endif // EXT_FLASH_LOG
+// </e>
+
+
+//==========================================================
+// <e> PULSE_SIMULATOR - Synthetic Poisson pulse train injected to the particle counter
+#ifndef PULSE_SIMULATOR
+#define PULSE_SIMULATOR 0
+#endif
+
+#if PULSE_SIMULATOR
+
+// <o> PULSE_SIM_MODE  - Pulse train shape
+// <0=> Constant rate
+// <1=> Step (source enters and leaves the field)
+// <2=> Burst
+#ifndef PULSE_SIM_MODE
+#define PULSE_SIM_MODE 0
+#endif
+
+// <o> PULSE_SIM_BASE_RATE_MCPS - Background rate in 1/1000 pulse per second <1-10000000>
+#ifndef PULSE_SIM_BASE_RATE_MCPS
+#define PULSE_SIM_BASE_RATE_MCPS 400
+#endif
+
+// <o> PULSE_SIM_HIGH_RATE_MCPS - Step or burst rate in 1/1000 pulse per second <1-10000000>
+#ifndef PULSE_SIM_HIGH_RATE_MCPS
+#define PULSE_SIM_HIGH_RATE_MCPS 5000
+#endif
+
+// <o> PULSE_SIM_BASE_TIME_S - Background phase duration in seconds
+#ifndef PULSE_SIM_BASE_TIME_S
+#define PULSE_SIM_BASE_TIME_S 300
+#endif
+
+// <o> PULSE_SIM_HIGH_TIME_MS - Step phase duration in milliseconds
+#ifndef PULSE_SIM_HIGH_TIME_MS
+#define PULSE_SIM_HIGH_TIME_MS 120000
+#endif
+
+// <o> PULSE_SIM_BURST_TIME_MS - Burst phase duration in milliseconds
+#ifndef PULSE_SIM_BURST_TIME_MS
+#define PULSE_SIM_BURST_TIME_MS 200
+#endif
+
+#endif // PULSE_SIMULATOR
+// </e>
+
+
+//==========================================================
+// <e> ENERGY_MODEL - Battery charge accounting and battery life estimation
+// <i> Charge is estimated from activity of consumers and currents below, so figures
+// <i> are as good as the currents measured on the board. With PULSE_SIMULATOR
+// <i> firmware changes can be compared at the same pulse rate.
+#ifndef ENERGY_MODEL
+#define ENERGY_MODEL 0
+#endif
+
+#if ENERGY_MODEL
+
+// <o> ENERGY_REPORT_PERIOD_S - Report period in seconds <1-3600>
+#ifndef ENERGY_REPORT_PERIOD_S
+#define ENERGY_REPORT_PERIOD_S 60
+#endif
+
+// <o> ENERGY_BATTERY_MAH - Battery capacity (mAh)
+#ifndef ENERGY_BATTERY_MAH
+#define ENERGY_BATTERY_MAH 1000
+#endif
+
+// <o> ENERGY_BASE_UA - Sleep floor current (uA)
+// <i> System ON sleep with RTC and LFXO, regulators and HV feedback divider
+#ifndef ENERGY_BASE_UA
+#define ENERGY_BASE_UA 5
+#endif
+
+// <o> ENERGY_CPU_UA - CPU running from flash at 16 MHz (uA)
+#ifndef ENERGY_CPU_UA
+#define ENERGY_CPU_UA 4400
+#endif
+
+// <o> ENERGY_WAKEUP_NC - Wakeup with HFCLK start and interrupt handler (nC)
+#ifndef ENERGY_WAKEUP_NC
+#define ENERGY_WAKEUP_NC 40
+#endif
+
+// <o> ENERGY_ADV_EVENT_NC - Advertising event on 3 channels (nC)
+#ifndef ENERGY_ADV_EVENT_NC
+#define ENERGY_ADV_EVENT_NC 12000
+#endif
+
+// <o> ENERGY_CONN_EVENT_NC - Connection event without data (nC)
+#ifndef ENERGY_CONN_EVENT_NC
+#define ENERGY_CONN_EVENT_NC 5000
+#endif
+
+// <o> ENERGY_HV_CYCLE_NC - HV pump cycle (nC)
+#ifndef ENERGY_HV_CYCLE_NC
+#define ENERGY_HV_CYCLE_NC 800
+#endif
+
+// <o> ENERGY_BUZZER_UA - Buzzer while tone plays (uA)
+#ifndef ENERGY_BUZZER_UA
+#define ENERGY_BUZZER_UA 3000
+#endif
+
+// <o> ENERGY_ADC_NC - Battery measurement (nC)
+#ifndef ENERGY_ADC_NC
+#define ENERGY_ADC_NC 50
+#endif
+
+#endif // ENERGY_MODEL
+// </e>
+
+
 //==========================================================
 // <e> USE_STATIC_PASSKEY  - Use 6-Digit static passkey
 #ifndef USE_STATIC_PASSKEY
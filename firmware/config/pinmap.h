@@ -48,4 +48,10 @@
 
 #endif
 
+// External log flash isn't wired on current boards. Set real pins to enable EXT_FLASH_LOG
+//#define FLASH_SCK_PIN                 xx
+//#define FLASH_MOSI_PIN                xx
+//#define FLASH_MISO_PIN                xx
+//#define FLASH_CS_PIN                  xx
+
 #endif // PIN_MAP_H
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include "app_timer.h"
 #include "Timer_anomaly_fix.h"
 #include "app_time_lib.h"
+#include "CPU_usage.h"
+#include "energy_model.h"
+#include "slack_timer.h"
+#include "app_util_platform.h"
 
 #include "HighVoltagePump.h"
 
@@ -43,6 +47,13 @@
 #define CYCTIMER_RANGE    (1 << CYC_TIMER_WIDTH_BITS) - 1
 #define CC0               1   //any value  more than 0
 
+#if defined(HV_PPI_CHAIN) && HV_PPI_CHAIN
+#define CYC_TIMER_INT_EN  false   // cycle is followed by polling in OnMainTmr()
+#define CYC_POLL_LIMIT(ticks)   ((uint32_t)(ticks) * 16)  // event check is longer than CPU clock, 16 of them per tick
+#else
+#define CYC_TIMER_INT_EN  true
+#endif
+
 
 // ----------------------------------------------------------------------------
 //   PRIVATE TYPES
@@ -88,10 +99,25 @@ typedef struct
 //   PRIVATE VARIABLE
 // ----------------------------------------------------------------------------
 APP_TIMER_DEF(mainHVtmr);
+#if defined(TIMER_SLACK) && TIMER_SLACK
+SLACK_TIMER_DEF(steadyHVtmr);   // steady pause shares wakeup with other slack timers
+#endif
 static const nrf_drv_timer_t cycCtrlTmr = NRF_DRV_TIMER_INSTANCE(1);
 static nrf_ppi_channel_t ppi_ch_tim1_gpiote_rising, ppi_ch_tim1_gpiote_falling;
 static nrf_ppi_channel_t ppi_ch_tim1_gpiote_risingDrv, ppi_ch_tim1_gpiote_fallingDrv;
 static bool enough_hv_fb;     //enough high voltage feedback
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+static uint32_t steady_pause;       // adapted steady pause in ticks
+static uint32_t pulses_since_full;  // pulses discharged capacitor after the last recharge
+static uint32_t pulse_budget;       // adapted pulses which start recharge in advance
+static bool     is_kicked;          // recharge was started by pulses, not by steady pause expiration
+#endif
+static uint32_t recharges;          // completed recharges
+static uint32_t recharge_cycles;    // pump cycles of completed recharges
+#if defined(HV_ON_PHASE_TUNING) && HV_ON_PHASE_TUNING
+static uint16_t tune_recharges;     // recharges in current tuning window
+static uint16_t tune_cycles;        // pump cycles in current tuning window
+#endif
 hv_params_t hv_params =
 {
   .cycTimer.on_phase      = PHASE_ON_NS,
@@ -147,33 +173,254 @@ static bool hvDataRefresh(hv_params_t *param)
   }
 }
 
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+/*! ---------------------------------------------------------------------------
+  \brief Adapt steady pause or pulse budget to capacitor droop after recharge is completed
+  \details Cycles needed to reach feedback show droop since the last recharge. One cycle
+           means capacitor was nearly full, so the limit which started recharge grows by
+           1/4. Three cycles and more mean it was discharged too much, so the limit is
+           halved. Recharge started by pause expiration adapts steady pause, the one
+           started by pulses adapts pulse budget. So at low count rate budget outgrows
+           pulses of the whole pause and kicks stop
+  \param cycles[in] - pump cycles of recharge
+  \return next steady pause in ticks
+ ----------------------------------------------------------------------------*/
+static uint32_t steady_pause_adapt(uint32_t cycles)
+{
+  if (is_kicked)
+  {
+    uint32_t budget = pulse_budget;
+    if (cycles <= 1)
+    {
+      budget += MAX(budget / 4, 1);
+    }
+    else if (cycles >= 3)
+    {
+      budget /= 2;
+    }
+    budget = MAX(budget, 1);
+    budget = MIN(budget, HV_PULSE_BUDGET_MAX);
+    CRITICAL_REGION_ENTER();
+    pulse_budget = budget;
+    CRITICAL_REGION_EXIT();
+    NRF_LOG_DEBUG("Kicked recharge by %d cycles, pulse budget %d\n", cycles, budget);
+  }
+  else
+  {
+    if (cycles <= 1)
+    {
+      steady_pause += steady_pause / 4;
+    }
+    else if (cycles >= 3)
+    {
+      steady_pause /= 2;
+    }
+    steady_pause = MAX(steady_pause, MS_TO_TICK(HV_STEADY_PAUSE_MIN_MS));
+    steady_pause = MIN(steady_pause, MS_TO_TICK(HV_STEADY_PAUSE_MAX_MS));
+    NRF_LOG_DEBUG("Recharge by %d cycles, steady pause %d ticks\n", cycles, steady_pause);
+  }
+  is_kicked = false;
+  CRITICAL_REGION_ENTER();
+  pulses_since_full = 0;
+  CRITICAL_REGION_EXIT();
+  return steady_pause;
+}
+#endif
+
+#if defined(HV_ON_PHASE_TUNING) && HV_ON_PHASE_TUNING
+/*! ---------------------------------------------------------------------------
+  \brief Tune on phase by average cycles of recharge in window
+  \details Short on phase needs more cycles, long one overdrives coil and capacitor is
+           recharged by the first cycle. On phase is changed by one step when average of
+           HV_TUNE_WINDOW recharges leaves target +-0.5 cycle. The first recharge after
+           power up is not taken into account. Runs when cycle timer is stopped
+  \param cycles[in] - pump cycles of recharge
+ ----------------------------------------------------------------------------*/
+static void on_phase_tune(uint32_t cycles)
+{
+  if (recharges == 1)
+  {
+    return;
+  }
+
+  tune_cycles += (uint16_t)MIN(cycles, UINT16_MAX / HV_TUNE_WINDOW);
+  if (++tune_recharges < HV_TUNE_WINDOW)
+  {
+    return;
+  }
+
+  uint16_t on_phase = hv_params.cycTimer.on_phase;
+  if (2 * tune_cycles < (2 * HV_TUNE_TARGET_CYCLES - 1) * HV_TUNE_WINDOW)
+  {
+    on_phase = MAX(on_phase - HV_ON_PHASE_STEP_NS, HV_ON_PHASE_MIN_NS);
+  }
+  else if (2 * tune_cycles > (2 * HV_TUNE_TARGET_CYCLES + 1) * HV_TUNE_WINDOW)
+  {
+    on_phase = MIN(on_phase + HV_ON_PHASE_STEP_NS, HV_ON_PHASE_MAX_NS);
+  }
+  tune_cycles = 0;
+  tune_recharges = 0;
+
+  if (on_phase != hv_params.cycTimer.on_phase)
+  {
+    hv_params_t params = hv_params;
+    params.cycTimer.on_phase = on_phase;
+    params.cycTimer.on_try_phase = on_phase;
+    if (hvDataRefresh(&params))
+    {
+      hv_params = params;
+      NRF_LOG_INFO("On phase %d ns\n", on_phase);
+    }
+  }
+}
+#endif
+
 // ---------------------------------------------------------------------------
 static void cycTimer_adjust(uint16_t cc1, uint16_t cc2, uint16_t cc3)
 {
   nrf_drv_timer_compare(&cycCtrlTmr, NRF_TIMER_CC_CHANNEL1, cc1, false); // fallig forming ---|___
-  nrf_drv_timer_compare(&cycCtrlTmr, NRF_TIMER_CC_CHANNEL2, cc2, true);  // enable recuperation if it needs
+  nrf_drv_timer_compare(&cycCtrlTmr, NRF_TIMER_CC_CHANNEL2, cc2, CYC_TIMER_INT_EN);  // enable recuperation if it needs
   nrf_drv_timer_extended_compare(&cycCtrlTmr, NRF_TIMER_CC_CHANNEL3, cc3,
                                   NRF_TIMER_SHORT_COMPARE3_STOP_MASK | TIMER_SHORTS_COMPARE3_CLEAR_Msk,
-                                  true);
+                                  CYC_TIMER_INT_EN);
 
 }
 
 
+// ---------------------------------------------------------------------------
+// pump cycle is over: plan the next one
+static void cycle_end(void)
+{
+  static uint32_t cnt = 0;
+  uint32_t interval;
+
+  if (enough_hv_fb)
+  {
+    nrf_gpio_pin_clear(DCRG);
+    recharges++;
+    recharge_cycles += cnt + 1;
+#if defined(HV_ON_PHASE_TUNING) && HV_ON_PHASE_TUNING
+    on_phase_tune(cnt + 1);
+#endif
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+    interval = steady_pause_adapt(cnt + 1);
+#else
+    interval = hv_data.workTimer.steady_pause;
+#endif
+    cnt = 0;
+    NRF_LOG_INFO("Enough HV\n");
+  }
+  else
+  {
+    interval = hv_data.workTimer.work_pause;
+    ++cnt;
+    NRF_LOG_INFO("NOT Enough (%d) HV\n", cnt);
+  }
+
+#if defined(TIMER_SLACK) && TIMER_SLACK
+  // work pause is kept precise, steady pause can be delayed
+  ret_code_t err_code = (enough_hv_fb) ? slack_timer_start(steadyHVtmr, interval, NULL)
+                                       : app_timer_start(mainHVtmr, interval, NULL);
+#else
+  ret_code_t err_code = app_timer_start(mainHVtmr, interval, NULL);
+#endif
+  ASSERT(err_code == NRF_SUCCESS);
+}
+
+#if defined(HV_PPI_CHAIN) && HV_PPI_CHAIN
+/*! ---------------------------------------------------------------------------
+  \brief Wait for compare event of cycle timer
+  \param limit[in] - event checks before giving up
+  \return false if event didn't come, so timer isn't running
+ ----------------------------------------------------------------------------*/
+static bool cycle_event_wait(nrf_timer_event_t event, uint32_t limit)
+{
+  while (nrf_timer_event_check(cycCtrlTmr.p_reg, event) == false)
+  {
+    if (limit-- == 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Follow pump cycle without TIMER1 and LPCOMP interrupts
+  \details Pump pins are switched by PPI and timer is stopped by short as usual. Feedback
+           comparator and timer compare events are polled, so the cycle costs one wakeup
+           instead of four. The cycle is CC3 long (27 us by default). Polling is limited
+           by several cycle lengths, cycle which didn't end is taken as not enough HV.
+           DCRG stays on CPU: all GPIOTE channels are taken by pump and pulse pins or sound
+ ----------------------------------------------------------------------------*/
+static void cycle_follow(void)
+{
+  uint32_t limit = CYC_POLL_LIMIT(hv_data.cycTimer.CC3_try);
+  bool is_done = cycle_event_wait(NRF_TIMER_EVENT_COMPARE2, limit);
+  if (is_done)
+  {
+    enough_hv_fb = nrf_lpcomp_event_check(NRF_LPCOMP_EVENT_UP);
+    if (enough_hv_fb)
+    {
+      nrf_gpio_pin_set(DCRG);
+    }
+    is_done = cycle_event_wait(NRF_TIMER_EVENT_COMPARE3, limit);
+  }
+
+  if (is_done)
+  {
+    enough_hv_fb = nrf_lpcomp_event_check(NRF_LPCOMP_EVENT_UP);
+  }
+  else
+  {
+    // timer is stopped or stalled. CC3 is set again by the next cycle, so it can take counter
+    nrf_drv_timer_disable(&cycCtrlTmr);
+    uint32_t cnt = nrf_drv_timer_capture(&cycCtrlTmr, NRF_TIMER_CC_CHANNEL3);
+    if ((cnt >= CC0) && (cnt < hv_data.cycTimer.CC1_try))
+    {
+      // mosfet is open, close it like CC1 does
+      nrf_drv_gpiote_out_task_trigger(PUMP_HV_PIN);
+      nrf_drv_gpiote_out_task_trigger(PUMP_HV_PIN_DRV);
+    }
+    enough_hv_fb = false;
+    nrf_gpio_pin_clear(DCRG);
+    nrf_drv_timer_clear(&cycCtrlTmr);
+    NRF_LOG_ERROR("Pump cycle didn't end\n");
+  }
+
+  nrf_timer_event_clear(cycCtrlTmr.p_reg, NRF_TIMER_EVENT_COMPARE2);
+  nrf_timer_event_clear(cycCtrlTmr.p_reg, NRF_TIMER_EVENT_COMPARE3);
+  nrf_drv_timer_disable(&cycCtrlTmr);
+  timer_anomaly_fix(cycCtrlTmr.p_reg, 0);
+  cycle_end();
+}
+#endif
+
 // ****************************************************************************
 static void OnMainTmr(void* context)
 {
+  PROF_ISR_ENTER();
   (void)context;
 
   cycTimer_adjust(hv_data.cycTimer.CC1_try, hv_data.cycTimer.CC2_try, hv_data.cycTimer.CC3_try);
   timer_anomaly_fix(cycCtrlTmr.p_reg, 1);
   enough_hv_fb = false;
+#if defined(HV_PPI_CHAIN) && HV_PPI_CHAIN
+  nrf_lpcomp_event_clear(NRF_LPCOMP_EVENT_UP);
+#endif
   nrf_drv_timer_enable(&cycCtrlTmr);
+  ENRG_CHARGE(ENRG_HV, ENERGY_HV_CYCLE_NC);
   NRF_LOG_DEBUG("Main timer\n");
+#if defined(HV_PPI_CHAIN) && HV_PPI_CHAIN
+  cycle_follow();
+#endif
+  PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
 }
 
 // ---------------------------------------------------------------------------
 static void OnLpcomp(nrf_lpcomp_event_t event)
 {
+  PROF_ISR_ENTER();
   if (event == NRF_LPCOMP_EVENT_UP)
   {
     enough_hv_fb = true;
@@ -182,14 +429,13 @@ static void OnLpcomp(nrf_lpcomp_event_t event)
   else
     NRF_LOG_WARNING("Another LPCOMP event\n");
 
+  PROF_ISR_EXIT(PROF_ISR_LPCOMP);
 }
 
 // ---------------------------------------------------------------------------
 static void OnCycCtrlTmr(nrf_timer_event_t event_type, void * p_context)
 {
-  static uint32_t cnt = 0;
-  uint32_t interval;
-
+  PROF_ISR_ENTER();
   if (event_type == NRF_TIMER_EVENT_COMPARE2)
   {
     if (enough_hv_fb)
@@ -203,24 +449,9 @@ static void OnCycCtrlTmr(nrf_timer_event_t event_type, void * p_context)
     nrf_drv_timer_disable(&cycCtrlTmr);
     timer_anomaly_fix(cycCtrlTmr.p_reg, 0);
     NRF_LOG_DEBUG("Stop timer\n");
-    
-    if (enough_hv_fb)
-    {
-      nrf_gpio_pin_clear(DCRG);
-      cnt = 0;
-      interval = hv_data.workTimer.steady_pause;
-      NRF_LOG_INFO("Enough HV\n");
-    }
-    else
-    {
-      interval = hv_data.workTimer.work_pause;
-      ++cnt;
-      NRF_LOG_INFO("NOT Enough (%d) HV\n", cnt);
-    }
-
-    ret_code_t err_code = app_timer_start(mainHVtmr, interval, NULL);
-    ASSERT(err_code == NRF_SUCCESS);
+    cycle_end();
   }
+  PROF_ISR_EXIT(PROF_ISR_HV_TIMER);
 }
 
 // ****************************************************************************
@@ -228,6 +459,11 @@ static void mainTimet_init(void)
 {
   ret_code_t err_code = app_timer_create(&mainHVtmr, APP_TIMER_MODE_SINGLE_SHOT, OnMainTmr);
   ASSERT(err_code == NRF_SUCCESS);
+#if defined(TIMER_SLACK) && TIMER_SLACK
+  err_code = slack_timer_create(&steadyHVtmr, APP_TIMER_MODE_SINGLE_SHOT, OnMainTmr,
+                                MS_TO_TICK(TIMER_SLACK_HV_MS));
+  ASSERT(err_code == NRF_SUCCESS);
+#endif
 }
 
 // ---------------------------------------------------------------------------
@@ -248,6 +484,9 @@ static void lpcomp_init(void)
   err_code = nrf_drv_lpcomp_init(&config, OnLpcomp);
   ASSERT(err_code == NRF_SUCCESS);
   nrf_drv_lpcomp_enable();
+#if defined(HV_PPI_CHAIN) && HV_PPI_CHAIN
+  nrf_lpcomp_int_disable(NRF_LPCOMP_INT_UP_MASK);   // UP event is polled by cycle_follow()
+#endif
 }
 
 // ---------------------------------------------------------------------------
@@ -348,6 +587,10 @@ void HV_pump_Init(void)
     ASSERT(false);
     return;
   }
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+  steady_pause = hv_data.workTimer.steady_pause;
+  pulse_budget = HV_PULSE_BUDGET;
+#endif
   mainTimet_init();
   hv_gpio_init();
   cycTimer_init();
@@ -387,7 +630,51 @@ void HV_instantKick(void)
     NRF_LOG_WARNING("Instant Kick HV pump\n");
     ret_code_t err_code = app_timer_stop(mainHVtmr);
     ASSERT(err_code == NRF_SUCCESS);
+#if defined(TIMER_SLACK) && TIMER_SLACK
+    err_code = slack_timer_stop(steadyHVtmr);
+    ASSERT(err_code == NRF_SUCCESS);
+#endif
     err_code = app_timer_start(mainHVtmr, interval, NULL);
     ASSERT(err_code == NRF_SUCCESS);
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+    is_kicked = true;
+#endif
+  }
+}
+
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+// ----------------------------------------------------------------------------
+void HV_RateUpdate(uint32_t cps)
+{
+  uint32_t pulses;
+  uint32_t budget;
+  CRITICAL_REGION_ENTER();
+  pulses_since_full += cps;
+  pulses = pulses_since_full;
+  budget = pulse_budget;
+  CRITICAL_REGION_EXIT();
+
+  // the next update comes in a second, so capacitor should hold pulses of one more second
+  if (pulses + cps >= budget)
+  {
+    HV_instantKick();
   }
 }
+#endif
+
+// ----------------------------------------------------------------------------
+void HV_GetReport(hv_report_t *p_report)
+{
+  ASSERT(p_report);
+  p_report->on_phase_ns   = hv_params.cycTimer.on_phase;
+  p_report->discharge_ns  = hv_params.cycTimer.discharge;
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+  p_report->steady_pause_ms = (uint32_t)((uint64_t)steady_pause * 1000 / APP_TIMER_CLOCK_FREQ);
+#else
+  p_report->steady_pause_ms = hv_params.workTimer.steady_pause;
+#endif
+  CRITICAL_REGION_ENTER();
+  p_report->recharges = recharges;
+  p_report->cycles    = recharge_cycles;
+  CRITICAL_REGION_EXIT();
+}
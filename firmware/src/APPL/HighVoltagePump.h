@@ -1,6 +1,18 @@
 #ifndef HIGH_VOLTAGE_PUMP_H
 #define HIGH_VOLTAGE_PUMP_H
 
+#include <stdint.h>
+
+// Pump parameters in use and recharge statistic from start
+typedef struct
+{
+  uint16_t  on_phase_ns;      // mosfet open phase
+  uint16_t  discharge_ns;     // recuperation phase
+  uint32_t  steady_pause_ms;  // pause after recharge
+  uint32_t  recharges;        // completed recharges
+  uint32_t  cycles;           // pump cycles of completed recharges
+} hv_report_t;
+
 /*! ---------------------------------------------------------------------------
   \brief High voltage module initialize 
  ----------------------------------------------------------------------------*/
@@ -18,6 +30,23 @@ void HV_pump_Init();
 void HV_pump_Startup(void);
 
 
+/*! ---------------------------------------------------------------------------
+  \brief Start pump cycle soon if capacitor is full now
+ ----------------------------------------------------------------------------*/
 void HV_instantKick(void);
 
+/*! ---------------------------------------------------------------------------
+  \brief Count rate feed for HV_ADAPTIVE_PAUSE option
+  \details Pulses discharge capacitor. Pump is kicked in advance when pulses counted after
+           the last recharge with pulses of the next second exceed pulse budget. Budget
+           starts from HV_PULSE_BUDGET and is adapted by cycles of kicked recharges
+  \param cps[in] - pulses of the last second
+ ----------------------------------------------------------------------------*/
+void HV_RateUpdate(uint32_t cps);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get pump parameters, tuned ones with HV_ON_PHASE_TUNING and HV_ADAPTIVE_PAUSE
+ ----------------------------------------------------------------------------*/
+void HV_GetReport(hv_report_t *p_report);
+
 #endif	// HIGH_VOLTAGE_PUMP_H
\ No newline at end of file
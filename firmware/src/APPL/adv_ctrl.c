@@ -3,7 +3,7 @@
 #include "softdevice_handler.h"
 #include "app_time_lib.h"
 #include "esm_lib.h"
-#include "sys_alive.h"
+#include "scheduler.h"
 #include "button.h"
 #include "conn.h"
 #include "adv.h"
@@ -65,7 +65,7 @@ APP_TIMER_DEF(to_tmr);
 static void OnTimerEvent(void * p_context)
 {
   adv_ctrl_ctx.isTimrEvt = 1;
-  sleepLock();
+  sched_Post(SCHED_BLE);
 }
 
 //------------------------------------------------------------------------------
@@ -82,7 +82,7 @@ static void button_cb(button_event_t event)
       adv_ctrl_ctx.isReleaseEvt = 1;
     }
 
-    sleepLock();
+    sched_Post(SCHED_BLE);
   }
 }
 
@@ -225,7 +225,7 @@ void adv_ctrl_Process(void)
 {
   if (esmProcess(&dbclick_esm, &dbclick_esm_ctx) == true)
   {
-    sleepLock();
+    sched_Post(SCHED_BLE);
   }
 
   if ((adv_ctrl_ctx.adv_en == 1) && (adv_ctrl_ctx.fds_busy == 0))
@@ -258,7 +258,7 @@ void ble_advertising_on_sys_evt(uint32_t sys_evt)
     case NRF_EVT_FLASH_OPERATION_SUCCESS: //FALLTHROUGH
     case NRF_EVT_FLASH_OPERATION_ERROR:
       adv_ctrl_ctx.fds_busy = 0;
-      sleepLock();
+      sched_Post(SCHED_BLE);
       break;
 
     default:
@@ -0,0 +1,95 @@
+#include "sdk_common.h"
+#include "nrf_assert.h"
+#include "fixmath.h"
+
+#include "dead_time.h"
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#ifdef J305
+#define DEAD_TIME_US          DEAD_TIME_J305_US
+#elif defined(SBM20)
+#define DEAD_TIME_US          DEAD_TIME_SBM20_US
+#else
+#error "Unknown configuration"
+#endif
+
+#define DTC_NON_PARALYZABLE   1
+#define DTC_PARALYZABLE       2
+
+// Loss fraction m*tau is limited to 0.9 for non-paralyzable model (10 times correction).
+// Beyond that the result depends only on counting noise
+#define NP_MAX_LOSS_Q16       58982u
+
+// Paralyzable tube shows maximal rate at n*tau = 1, m*tau = 1/e.
+// Measured rate above it hasn't a solution, so it's limited just below 1/e
+#define P_MAX_LOSS_Q16        24000u
+#define P_NEWTON_STEPS        8
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+#if (DEAD_TIME_CORRECTION == DTC_NON_PARALYZABLE)
+// returns 1 / (1 - x) in Q16
+static uint32_t gain_non_paralyzable(uint32_t x)
+{
+  x = MIN(x, NP_MAX_LOSS_Q16);
+  return (uint32_t)(((uint64_t)FX_Q16_ONE << 16) / (FX_Q16_ONE - x));
+}
+
+#elif (DEAD_TIME_CORRECTION == DTC_PARALYZABLE)
+// returns y / x where y = x * e^y, in Q16
+static uint32_t gain_paralyzable(uint32_t x)
+{
+  x = MIN(x, P_MAX_LOSS_Q16);
+  int32_t y = (int32_t)x;
+
+  // f(y) = y - x*e^y is concave and f(x) < 0, so Newton steps approach the root from below
+  for (uint8_t i = 0; i < P_NEWTON_STEPS; i++)
+  {
+    int32_t xe = (int32_t)(((uint64_t)x * fx_exp_q16((uint32_t)y)) >> 16);
+    int32_t step = (int32_t)(((int64_t)(xe - y) << 16) / ((int32_t)FX_Q16_ONE - xe));
+    if (step <= 0)
+    {
+      break;
+    }
+    y += step;
+  }
+  return (uint32_t)(((uint64_t)y << 16) / x);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+uint32_t DTC_Correct(uint32_t counts, uint32_t interval_ms)
+{
+#if defined(DEAD_TIME_CORRECTION) && DEAD_TIME_CORRECTION
+  ASSERT(interval_ms);
+  if (counts == 0)
+  {
+    return 0;
+  }
+
+  // x = m * tau, loss fraction in Q16
+  uint64_t x = ((uint64_t)counts * DEAD_TIME_US << 16) / ((uint64_t)interval_ms * 1000);
+  if (x == 0)
+  {
+    return counts;  // loss is less than Q16 resolution
+  }
+  x = MIN(x, FX_Q16_ONE);
+
+#if (DEAD_TIME_CORRECTION == DTC_NON_PARALYZABLE)
+  uint64_t n = ((uint64_t)counts * gain_non_paralyzable((uint32_t)x)) >> 16;
+#elif (DEAD_TIME_CORRECTION == DTC_PARALYZABLE)
+  uint64_t n = ((uint64_t)counts * gain_paralyzable((uint32_t)x)) >> 16;
+#else
+#error "Unknown DEAD_TIME_CORRECTION model"
+#endif
+  return (n > UINT32_MAX) ? UINT32_MAX : (uint32_t)n;
+#else
+  (void)interval_ms;
+  return counts;
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef DEAD_TIME_H
+#define DEAD_TIME_H
+
+#include <stdint.h>
+
+/*! ---------------------------------------------------------------------------
+  \brief Dead time correction of counted pulses
+  \details Geiger tube doesn't register particles during the dead time after
+           each discharge, so counter loses more and more pulses with rate.
+           Model is selected by DEAD_TIME_CORRECTION option:
+           non-paralyzable  n = m / (1 - m*tau)
+           paralyzable      m = n * exp(-n*tau), solved by Newton iterations
+           Where m is measured and n is true rate. Only integer math is used.
+           With DEAD_TIME_CORRECTION == 0 counts are returned unchanged.
+
+  \param counts[in]       - pulses counted during interval
+  \param interval_ms[in]  - interval in milliseconds, must be not zero
+
+  \return estimated true amount of particles during interval
+ ----------------------------------------------------------------------------*/
+uint32_t DTC_Correct(uint32_t counts, uint32_t interval_ms);
+
+#endif	// DEAD_TIME_H
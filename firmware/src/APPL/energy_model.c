@@ -0,0 +1,174 @@
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_log_ctrl.h"
+#include "app_util_platform.h"
+#include "app_time_lib.h"
+#include "slack_timer.h"
+
+#include "energy_model.h"
+
+#if defined(ENERGY_MODEL) && ENERGY_MODEL
+
+#define NRF_LOG_MODULE_NAME   "ENRG"
+#define NRF_LOG_LEVEL         3
+#include "nrf_log.h"
+
+// ----------------------------------------------------------------------------
+#define TICK_PER_SEC          APP_TIMER_CLOCK_FREQ
+#define US_PER_SEC            1000000ull
+#define ADV_DELAY_AVG_US      5000      // advertising event is delayed by random 0...10 ms
+#define UAH_PER_DAY(na)       ((na) * 24 / 1000)
+#define REPORT_SLACK_MS       1000
+
+// ----------------------------------------------------------------------------
+SLACK_TIMER_DEF(report_tmr);
+static uint64_t     charge_nc[ENRG_CONSUMERS_TOTAL];  // event charges, time based ones are calculated on read
+static uint64_t     cpu_ticks;
+static uint32_t     cpu_wakeups;
+static enrg_radio_t radio_state;
+static uint32_t     radio_interval_us;
+static uint64_t     radio_since;        // system time of the last radio accounting
+static uint64_t     radio_rem_us;       // time not covered by whole radio intervals
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+// charges radio events passed from the last call. Runs in critical region
+static void radio_account(void)
+{
+  uint64_t now = app_time_Get_sys_time();
+  uint64_t elapsed_us = (now - radio_since) * US_PER_SEC / TICK_PER_SEC;
+  radio_since = now;
+
+  if (radio_state == ENRG_RADIO_IDLE)
+  {
+    radio_rem_us = 0;
+    return;
+  }
+
+  radio_rem_us += elapsed_us;
+  uint64_t events = radio_rem_us / radio_interval_us;
+  radio_rem_us -= events * radio_interval_us;
+  uint32_t event_nc = (radio_state == ENRG_RADIO_ADV) ? ENERGY_ADV_EVENT_NC : ENERGY_CONN_EVENT_NC;
+  charge_nc[ENRG_RADIO] += events * event_nc;
+}
+
+// ----------------------------------------------------------------------------
+static uint64_t charge_get(enrg_consumer_t consumer, uint64_t uptime)
+{
+  uint64_t charge;
+  CRITICAL_REGION_ENTER();
+  switch (consumer)
+  {
+    case ENRG_BASE:
+      charge = uptime * ENERGY_BASE_UA * 1000 / TICK_PER_SEC;
+      break;
+
+    case ENRG_CPU:
+      charge = cpu_ticks * ENERGY_CPU_UA * 1000 / TICK_PER_SEC + (uint64_t)cpu_wakeups * ENERGY_WAKEUP_NC;
+      break;
+
+    case ENRG_RADIO:
+      radio_account();
+      charge = charge_nc[consumer];
+      break;
+
+    default:
+      charge = charge_nc[consumer];
+      break;
+  }
+  CRITICAL_REGION_EXIT();
+  return charge;
+}
+
+// ----------------------------------------------------------------------------
+static void OnTmr(void* context)
+{
+  (void)context;
+  uint32_t avg[ENRG_CONSUMERS_TOTAL];
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < ENRG_CONSUMERS_TOTAL; i++)
+  {
+    avg[i] = ENRG_GetAverage((enrg_consumer_t)i);
+    total += avg[i];
+  }
+  NRF_LOG_INFO("nA: base %d cpu %d radio %d hv %d sound %d adc %d\n",
+               avg[ENRG_BASE], avg[ENRG_CPU], avg[ENRG_RADIO], avg[ENRG_HV], avg[ENRG_SOUND], avg[ENRG_ADC]);
+
+  uint32_t uah_day = UAH_PER_DAY(total);
+  uint32_t days = (uah_day > 0) ? (ENERGY_BATTERY_MAH * 1000ul / uah_day) : 0;
+  NRF_LOG_INFO("total %d nA, %d uAh/day, battery life %d days\n", total, uah_day, days);
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void ENRG_Init(void)
+{
+  ret_code_t err_code = slack_timer_create(&report_tmr, APP_TIMER_MODE_REPEATED, OnTmr,
+                                          MS_TO_TICK(REPORT_SLACK_MS));
+  APP_ERROR_CHECK(err_code);
+}
+
+// ----------------------------------------------------------------------------
+void ENRG_Startup(void)
+{
+  ret_code_t err_code = slack_timer_start(report_tmr, MS_TO_TICK(ENERGY_REPORT_PERIOD_S * 1000ul), NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+// ----------------------------------------------------------------------------
+void ENRG_Charge(enrg_consumer_t consumer, uint32_t nc)
+{
+  ASSERT(consumer < ENRG_CONSUMERS_TOTAL);
+  CRITICAL_REGION_ENTER();
+  charge_nc[consumer] += nc;
+  CRITICAL_REGION_EXIT();
+}
+
+// ----------------------------------------------------------------------------
+void ENRG_CpuWork(uint32_t ticks)
+{
+  CRITICAL_REGION_ENTER();
+  cpu_ticks += ticks;
+  cpu_wakeups++;
+  CRITICAL_REGION_EXIT();
+}
+
+// ----------------------------------------------------------------------------
+void ENRG_RadioSet(enrg_radio_t state, uint32_t interval_us)
+{
+  ASSERT((state == ENRG_RADIO_IDLE) || (interval_us > 0));
+  CRITICAL_REGION_ENTER();
+  radio_account();
+  radio_state = state;
+  radio_interval_us = (state == ENRG_RADIO_ADV) ? interval_us + ADV_DELAY_AVG_US : interval_us;
+  radio_rem_us = 0;
+  CRITICAL_REGION_EXIT();
+}
+
+// ----------------------------------------------------------------------------
+uint32_t ENRG_GetAverage(enrg_consumer_t consumer)
+{
+  uint64_t uptime = app_time_Get_sys_time();
+  if (uptime == 0)
+  {
+    return 0;
+  }
+
+  uint64_t charge = 0;
+  if (consumer == ENRG_CONSUMERS_TOTAL)
+  {
+    for (uint8_t i = 0; i < ENRG_CONSUMERS_TOTAL; i++)
+    {
+      charge += charge_get((enrg_consumer_t)i, uptime);
+    }
+  }
+  else
+  {
+    charge = charge_get(consumer, uptime);
+  }
+  return (uint32_t)(charge * TICK_PER_SEC / uptime);
+}
+
+#endif // ENERGY_MODEL
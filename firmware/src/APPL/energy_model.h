@@ -0,0 +1,77 @@
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stdint.h>
+
+// Battery charge consumers
+typedef enum
+{
+  ENRG_BASE,      // sleep floor: RTC, LFXO, regulators, HV divider
+  ENRG_CPU,       // CPU active time and wakeups
+  ENRG_RADIO,     // advertising and connection events
+  ENRG_HV,        // HV pump cycles
+  ENRG_SOUND,     // buzzer
+  ENRG_ADC,       // battery measurements
+  ENRG_CONSUMERS_TOTAL
+} enrg_consumer_t;
+
+// Radio activity
+typedef enum
+{
+  ENRG_RADIO_IDLE,
+  ENRG_RADIO_ADV,
+  ENRG_RADIO_CONN,
+} enrg_radio_t;
+
+#if defined(ENERGY_MODEL) && ENERGY_MODEL
+#define ENRG_CHARGE(consumer, nc)         ENRG_Charge((consumer), (nc))
+#define ENRG_CPU_WORK(ticks)              ENRG_CpuWork(ticks)
+#define ENRG_RADIO_SET(state, interval)   ENRG_RadioSet((state), (interval))
+#else
+#define ENRG_CHARGE(consumer, nc)
+#define ENRG_CPU_WORK(ticks)
+#define ENRG_RADIO_SET(state, interval)
+#endif
+
+/*! ---------------------------------------------------------------------------
+  \brief Energy model init
+  \details Module is compiled in only with ENERGY_MODEL option. Charge drawn from battery
+           is estimated from activity of consumers and their modelled currents from
+           app_config.h. Average current of each consumer, daily consumption and battery life
+           are logged every ENERGY_REPORT_PERIOD_S. With PULSE_SIMULATOR the same build
+           gives comparable figures for a given pulse rate.
+ ----------------------------------------------------------------------------*/
+void ENRG_Init(void);
+
+void ENRG_Startup(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Add charge of consumer event. Use by ENRG_CHARGE(), can be invoked from interrupt
+  \param consumer[in] - consumer
+  \param nc[in]       - charge in nC (uA * ms)
+ ----------------------------------------------------------------------------*/
+void ENRG_Charge(enrg_consumer_t consumer, uint32_t nc);
+
+/*! ---------------------------------------------------------------------------
+  \brief Add CPU active time of one wakeup. Use by ENRG_CPU_WORK()
+  \param ticks[in] - active time in RTC ticks (1/32768 s)
+ ----------------------------------------------------------------------------*/
+void ENRG_CpuWork(uint32_t ticks);
+
+/*! ---------------------------------------------------------------------------
+  \brief Set radio activity. Use by ENRG_RADIO_SET()
+  \details Radio events are charged by time in the previous state
+  \param state[in]        - new state
+  \param interval_us[in]  - advertising or connection interval in us
+ ----------------------------------------------------------------------------*/
+void ENRG_RadioSet(enrg_radio_t state, uint32_t interval_us);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get average current from start
+  \param consumer[in] - consumer or ENRG_CONSUMERS_TOTAL for the sum
+
+  \return current in nA
+ ----------------------------------------------------------------------------*/
+uint32_t ENRG_GetAverage(enrg_consumer_t consumer);
+
+#endif	// ENERGY_MODEL_H
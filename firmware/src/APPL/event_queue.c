@@ -2,8 +2,10 @@
 #include "app_error.h"
 #include "nrf_log_ctrl.h"
 #include "app_time_lib.h"
-#include "particle_cnt.h"
 #include "ringbuf.h"
+#include "varint.h"
+#include "flash_log.h"
+#include "particle_watcher.h"
 
 #include "event_queue.h"
 
@@ -13,87 +15,137 @@
 
 // ----------------------------------------------------------------------------
 #define PERIOD_1H           3600u
+#define BARS_PER_HOUR       (PERIOD_1H / PWT_BAR_S)
 #define RB_SIZE_ELEM        1100
+#define RAW_RECORD_SIZE     3       // RAM budget is kept the same as for 1100 raw 3 byte records
 
 
 // ----------------------------------------------------------------------------
+// Position of the next record to sync
 typedef struct
 {
-  uint8_t msb;
-  uint8_t mid;
-  uint8_t lsb;
-} event_t;
+  uint32_t  seq;
+  size_t    offset;   // from the oldest byte in ring buffer
+  uint32_t  prev;     // value of the record before seq
+} sync_cursor_t;
 
 // ----------------------------------------------------------------------------
-APP_TIMER_DEF(tmr);
-RING_BUF_DEF(m_rb, RB_SIZE_ELEM * sizeof(event_t));
-static uint32_t cnt_prev;
-static uint32_t diff_cnt;
+RING_BUF_DEF(m_rb, RB_SIZE_ELEM * RAW_RECORD_SIZE);
+static uint32_t hour_cnt;       // pulses of finished bars in the current hour
+static uint16_t hour_bars;
 static uint16_t events_cnt;
+static uint32_t first_seq;      // sequence number of the oldest record in queue
+static uint32_t base_prev;      // value of the record before the oldest one, decoding base
+static uint32_t last_value;     // value of the newest record, encoding base
+static sync_cursor_t sync;
 static uint64_t last_timeframe_timestamp;
 
 // ----------------------------------------------------------------------------
-static void refresh(bool finalize_period)
+// copies stored bytes from offset, ring buffer end is handled
+static size_t rb_read(size_t offset, uint8_t *dst, size_t len)
 {
-  CRITICAL_REGION_ENTER();
-  uint32_t cnt_now = particle_cnt_Get();
-  diff_cnt = cnt_now - cnt_prev;
-  if (finalize_period)
+  size_t copied = 0;
+  uint8_t *p_data;
+  size_t size;
+
+  while ((copied < len) && (ringbufPeek(&m_rb, offset + copied, &p_data, &size) == NRF_SUCCESS) && size)
   {
-    cnt_prev = cnt_now;
-    last_timeframe_timestamp = app_time_Get_UTC();
+    size = MIN(size, len - copied);
+    memcpy(dst + copied, p_data, size);
+    copied += size;
   }
-  CRITICAL_REGION_EXIT();
+  return copied;
 }
 
 // ----------------------------------------------------------------------------
-static uint32_t  get_event(void)
+static void sync_reset(void)
 {
-  uint32_t e;
-  size_t size = sizeof(event_t);
-  ret_code_t err_code = ringbufGet(&m_rb, (uint8_t*)&e, &size);
-  ASSERT((err_code == NRF_SUCCESS) && (size == sizeof(event_t)));
+  sync.seq = first_seq;
+  sync.offset = 0;
+  sync.prev = base_prev;
+}
+
+// ----------------------------------------------------------------------------
+// removes the oldest record and returns its value
+static uint32_t drop_oldest(void)
+{
+  uint8_t buf[VARINT_MAX_LEN];
+  uint32_t zz;
+  size_t len = rb_read(0, buf, sizeof(buf));
+  len = varint_decode(buf, len, &zz);
+  ASSERT(len);
+
+  ret_code_t err_code = ringbufGet(&m_rb, buf, &len);
+  ASSERT(err_code == NRF_SUCCESS);
+  base_prev += zigzag_decode(zz);
   events_cnt--;
-  return e;
+  first_seq++;
+
+  if ((int32_t)(sync.seq - first_seq) < 0)
+  {
+    sync_reset();
+  }
+  else
+  {
+    sync.offset -= len;
+  }
+  return base_prev;
 }
 
 // ----------------------------------------------------------------------------
-static void OnTmr(void* context)
+// record is stored as zig-zag varint of difference with previous one.
+// Hourly background about 1500 pulses takes 1-2 bytes, ~2.4 times more records than raw 3 bytes ones.
+// Poisson noise of such counts is ~7.5 bits of entropy, so even ideal coder can't keep more than ~3.2 times
+static void put_event(uint32_t value)
 {
-  refresh(true);
+  uint8_t buf[VARINT_MAX_LEN];
+  uint8_t len = varint_encode(zigzag_encode((int32_t)(value - last_value)), buf);
 
-  if (ringbufGetFree(&m_rb) < sizeof(event_t))
+  while (ringbufGetFree(&m_rb) < len)
   {
-  /*  Throw one event out for release place.
+  /*  Throw the oldest events out for release place.
       This case is occured if Event Queue is completelly full
   */
     NRF_LOG_INFO("Get event rid\n");
-    get_event();
+    drop_oldest();
   }
 
-  if (ringbufPut(&m_rb, (uint8_t*)&diff_cnt, sizeof(event_t)) != sizeof(event_t))
+  if (ringbufPut(&m_rb, buf, len) != len)
   {
     ASSERT(false);
   }
+  last_value = value;
   events_cnt++;
 }
 
 // ----------------------------------------------------------------------------
 //    PUBLIC FUNCTION
 // ----------------------------------------------------------------------------
-void EVQ_Init(void)
+void EVQ_Startup(void)
 {
-  ret_code_t ret_code = app_timer_create(&tmr, APP_TIMER_MODE_REPEATED, OnTmr);
-  APP_ERROR_CHECK(ret_code);
+  ringbufInit(&m_rb);
+  last_timeframe_timestamp = app_time_Get_UTC();
 }
 
 // ----------------------------------------------------------------------------
-void EVQ_Startup(void)
+// runs every PWT_BAR_S from timer interrupt
+void EVQ_Tick(uint32_t bar)
 {
-  ret_code_t ret_code = app_timer_start(tmr, MS_TO_TICK(PERIOD_1H * 1000), NULL);
-  APP_ERROR_CHECK(ret_code);
-  ringbufInit(&m_rb);
+  hour_cnt += bar;
+  if (++hour_bars < BARS_PER_HOUR)
+  {
+    return;
+  }
+  hour_bars = 0;
+  uint32_t value = hour_cnt;
+  CRITICAL_REGION_ENTER();
+  put_event(value);
+  hour_cnt = 0;
   last_timeframe_timestamp = app_time_Get_UTC();
+  CRITICAL_REGION_EXIT();
+#if defined(EXT_FLASH_LOG) && EXT_FLASH_LOG
+  FLOG_Append(value);
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -108,26 +160,129 @@ uint64_t EVQ_GetCurrentEventTimestamp(void)
   return last_timeframe_timestamp;
 }
 
+// ----------------------------------------------------------------------------
+uint32_t EVQ_GetUncomplete(void)
+{
+  // all stages are taken at the same base tick
+  uint32_t cnt;
+  CRITICAL_REGION_ENTER();
+  cnt = hour_cnt + PWT_GetPending();
+  CRITICAL_REGION_EXIT();
+
+  if (last_timeframe_timestamp)
+  {
+    return cnt | 0x80000000;
+  }
+  else
+  {
+    return 0x80000000;
+  }
+}
+
 // ----------------------------------------------------------------------------
 uint32_t EVQ_GetEvt(void)
 {
   if (events_cnt == 0)
   {
     NRF_LOG_INFO("Uncomplete event\n");
-    refresh(false);
-
-    if (last_timeframe_timestamp)
-    {
-      return diff_cnt | 0x80000000;
-    }
-    else
-    {
-      return 0x80000000;
-    }
+    return EVQ_GetUncomplete();
   }
   else
   {
     NRF_LOG_INFO("Complete event\n");
-    return get_event() & 0x7FFFFFFF;
+    uint32_t value;
+    CRITICAL_REGION_ENTER();
+    value = drop_oldest();
+    CRITICAL_REGION_EXIT();
+    return value & 0x7FFFFFFF;
   }
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------------------------------
+uint32_t EVQ_GetFirstSeq(void)
+{
+  return first_seq;
+}
+
+// ----------------------------------------------------------------------------
+uint32_t EVQ_GetNextSeq(void)
+{
+  return first_seq + events_cnt;
+}
+
+// ----------------------------------------------------------------------------
+void EVQ_SyncStart(void)
+{
+  CRITICAL_REGION_ENTER();
+  sync_reset();
+  CRITICAL_REGION_EXIT();
+}
+
+// ----------------------------------------------------------------------------
+uint32_t EVQ_SyncGetSeq(void)
+{
+  return sync.seq;
+}
+
+// ----------------------------------------------------------------------------
+bool EVQ_SyncPeek(uint16_t max_len, evq_batch_handler_t handler, void *ctx)
+{
+  ASSERT(handler);
+  ASSERT(max_len <= EVQ_BATCH_MAX_LEN);
+  uint8_t data[EVQ_BATCH_MAX_LEN];
+  sync_cursor_t from;
+  size_t len;
+
+  // handler can take long time to send, so records are copied and queue is unlocked.
+  // Direct read isn't used: full queue reuses the oldest bytes while handler runs,
+  // and batch can cross the buffer end while handler takes one piece
+  CRITICAL_REGION_ENTER();
+  len = rb_read(sync.offset, data, max_len);
+  from = sync;
+  CRITICAL_REGION_EXIT();
+
+  size_t used = 0;
+  uint16_t records = 0;
+  uint32_t value = from.prev;
+  uint32_t zz;
+  uint8_t  vlen;
+
+  // only whole records go out
+  while ((vlen = varint_decode(&data[used], len - used, &zz)) > 0)
+  {
+    value += zigzag_decode(zz);
+    used += vlen;
+    records++;
+  }
+
+  if ((records == 0) || !handler(from.seq, from.prev, data, used, ctx))
+  {
+    return false;
+  }
+
+  // EVQ_Tick could throw sent records out meanwhile, then sync continues from the oldest one
+  CRITICAL_REGION_ENTER();
+  if (sync.seq == from.seq)
+  {
+    sync.seq += records;
+    sync.offset += used;
+    sync.prev = value;
+  }
+  CRITICAL_REGION_EXIT();
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+void EVQ_Release(uint32_t seq)
+{
+  CRITICAL_REGION_ENTER();
+  if ((int32_t)(seq - sync.seq) > 0)
+  {
+    seq = sync.seq;   // client can't acknowledge not sent records
+  }
+  while (((int32_t)(seq - first_seq) > 0) && events_cnt)
+  {
+    drop_oldest();
+  }
+  CRITICAL_REGION_EXIT();
+}
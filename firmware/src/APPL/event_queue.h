@@ -3,15 +3,89 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
-void EVQ_Init(void);
+#define EVQ_BATCH_MAX_LEN   32  // longest records batch for handler
+
+/*! ---------------------------------------------------------------------------
+  \brief Handler to pass records batch out
+  \details It's invoked from main context with queue unlocked and must not keep p_data
+           after return. New records can come and old ones be thrown out meanwhile.
+           Each record is zig-zag varint (see varint.h) of difference with previous one.
+           Decoding: value[0] = prev + zigzag_decode(varint[0]), value[i] = value[i-1] + ...
+
+  \param seq[in]     - sequence number of the first record in batch
+  \param prev[in]    - value of the record before the first one, decoding base
+  \param p_data[in]  - whole encoded records
+  \param len[in]     - length in bytes
+  \param ctx[in]     - context given to EVQ_SyncPeek
+
+  \return true if records are sent
+ ----------------------------------------------------------------------------*/
+typedef bool (*evq_batch_handler_t)(uint32_t seq, uint32_t prev, const uint8_t *p_data, uint16_t len, void *ctx);
 
 void EVQ_Startup(void);
 
+/*! ---------------------------------------------------------------------------
+  \brief Feed finished bar of PWT_BAR_S
+  \details The last stage of pulse aggregation, invoked by PWT_Tick() from timer
+           interrupt. Every hour the sum of bars is put in queue as a record
+
+  \param bar[in] - pulses of the bar
+ ----------------------------------------------------------------------------*/
+void EVQ_Tick(uint32_t bar);
+
 uint16_t EVQ_GetEventsAmount(void);
 
 uint64_t EVQ_GetCurrentEventTimestamp(void);
 
+/*! ---------------------------------------------------------------------------
+  \brief Get pulses of the current not finished hour
+  \return pulses amount with 0x80000000 flag
+ ----------------------------------------------------------------------------*/
+uint32_t EVQ_GetUncomplete(void);
+
 uint32_t EVQ_GetEvt(void);
 
+/*! ---------------------------------------------------------------------------
+  \brief Get sequence number of the oldest record in queue
+  \details Every complete record gets the next sequence number. Sequence isn't
+           reset while device works, so a client can continue sync after reconnect.
+ ----------------------------------------------------------------------------*/
+uint32_t EVQ_GetFirstSeq(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get sequence number the next complete record will have
+ ----------------------------------------------------------------------------*/
+uint32_t EVQ_GetNextSeq(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Start sync from the oldest record in queue
+ ----------------------------------------------------------------------------*/
+void EVQ_SyncStart(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get sequence number of the next record to sync
+  \details Sync is finished when it's equal to EVQ_GetNextSeq()
+ ----------------------------------------------------------------------------*/
+uint32_t EVQ_SyncGetSeq(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Pass the next records to handler without removing them from queue
+  \details If sync position was thrown out by queue overflow it continues from the oldest record
+
+  \param max_len[in]  - batch length limit, not more than EVQ_BATCH_MAX_LEN
+  \param handler[in]  - records receiver
+  \param ctx[in]      - handler context
+
+  \return true if handler sent records, sync position is moved after them
+ ----------------------------------------------------------------------------*/
+bool EVQ_SyncPeek(uint16_t max_len, evq_batch_handler_t handler, void *ctx);
+
+/*! ---------------------------------------------------------------------------
+  \brief Remove records acknowledged by client
+  \param seq[in] - records before this sequence number are removed, not later than sync position
+ ----------------------------------------------------------------------------*/
+void EVQ_Release(uint32_t seq);
+
 #endif	// EVENT_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_log_ctrl.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "ext_flash.h"
+
+#include "flash_log.h"
+
+#if defined(EXT_FLASH_LOG) && EXT_FLASH_LOG
+
+#define NRF_LOG_MODULE_NAME   "FLOG"
+#define NRF_LOG_LEVEL         3
+#include "nrf_log.h"
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#define LOG_SECTORS         FLASH_LOG_SECTORS
+#define SLOT_SIZE           sizeof(slot_t)
+#define SLOTS_PER_SECTOR    (EXT_FLASH_SECTOR_SIZE / SLOT_SIZE)
+#define SLOTS_PER_PAGE      (EXT_FLASH_PAGE_SIZE / SLOT_SIZE)
+#define HEADER_SLOT         0
+#define SECTOR_MAGIC        0x474F4C4Eul  // "NLOG"
+#define VALUE_MASK          0x00FFFFFFul
+#define CRC_SHIFT           24
+#define PEND_MAX            SLOTS_PER_PAGE  // RAM page buffer
+#define PROGRAM_POLL_MS     2             // page program is 0.85 ms typical
+#define ERASE_POLL_MS       30            // sector erase is 30 ms typical
+
+STATIC_ASSERT(LOG_SECTORS <= EXT_FLASH_SIZE / EXT_FLASH_SECTOR_SIZE);
+
+// ----------------------------------------------------------------------------
+//   PRIVATE TYPES
+// ----------------------------------------------------------------------------
+/*  Both sector header and entry take one slot:
+    header: {SECTOR_MAGIC, sector sequence | crc}
+    entry:  {entry sequence, value | crc}
+    crc8 covers 7 bytes. Erased slot is all 0xFF and is checked before crc
+*/
+typedef struct
+{
+  uint32_t  id;
+  uint32_t  info;
+} slot_t;
+
+typedef enum
+{
+  FLOG_IDLE,
+  FLOG_ERASE,
+  FLOG_WRITE,
+} flog_state_t;
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+APP_TIMER_DEF(poll_tmr);
+static bool         is_ready;
+static bool         is_poll_evt;
+static flog_state_t state;
+static uint16_t     head_sector;    // sector is written now
+static uint32_t     head_seq;       // its sequence number
+static uint16_t     wr_slot;        // next free slot of head sector
+static uint32_t     next_seq;       // sequence number of the next entry
+static slot_t       pend[PEND_MAX];
+static uint8_t      pend_rd;
+static uint8_t      pend_cnt;
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+static uint8_t crc8(const slot_t *p_slot)
+{
+  const uint8_t *p = (const uint8_t*)p_slot;
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < SLOT_SIZE - 1; i++)
+  {
+    crc ^= p[i];
+    for (uint8_t b = 0; b < 8; b++)
+    {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// ---------------------------------------------------------------------------
+static void slot_make(slot_t *p_slot, uint32_t id, uint32_t data)
+{
+  p_slot->id = id;
+  p_slot->info = data & VALUE_MASK;
+  p_slot->info |= (uint32_t)crc8(p_slot) << CRC_SHIFT;
+}
+
+// ---------------------------------------------------------------------------
+static bool slot_is_erased(const slot_t *p_slot)
+{
+  return (p_slot->id == UINT32_MAX) && (p_slot->info == UINT32_MAX);
+}
+
+// ---------------------------------------------------------------------------
+static bool slot_is_valid(const slot_t *p_slot)
+{
+  return !slot_is_erased(p_slot) && ((p_slot->info >> CRC_SHIFT) == crc8(p_slot));
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t slot_addr(uint16_t sector, uint16_t slot)
+{
+  return (uint32_t)sector * EXT_FLASH_SECTOR_SIZE + slot * SLOT_SIZE;
+}
+
+// ---------------------------------------------------------------------------
+static void slot_read(uint16_t sector, uint16_t slot, slot_t *p_slot)
+{
+  extFlash_Read(slot_addr(sector, slot), p_slot, SLOT_SIZE);
+}
+
+// ---------------------------------------------------------------------------
+static bool header_read(uint16_t sector, uint32_t *p_seq)
+{
+  slot_t hdr;
+  slot_read(sector, HEADER_SLOT, &hdr);
+  *p_seq = hdr.info & VALUE_MASK;
+  return (hdr.id == SECTOR_MAGIC) && slot_is_valid(&hdr);
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Restore write position after reset
+  \details The head is the sector with the biggest sequence. Its first erased slot
+           is write position. Entries torn by power cut have wrong crc and are skipped.
+           Sector which erase or header write was interrupted has no valid header,
+           it is erased again when log comes to it
+ ----------------------------------------------------------------------------*/
+static void recover(void)
+{
+  uint32_t seq;
+  bool is_found = false;
+
+  for (uint16_t s = 0; s < LOG_SECTORS; s++)
+  {
+    if (header_read(s, &seq) && (!is_found || ((int32_t)((seq - head_seq) << 8) > 0)))
+    {
+      is_found = true;
+      head_sector = s;
+      head_seq = seq;
+    }
+  }
+
+  if (!is_found)
+  {
+    NRF_LOG_INFO("Empty log\n");
+    head_sector = LOG_SECTORS - 1;
+    wr_slot = SLOTS_PER_SECTOR;   // the first entry erases sector 0
+    return;
+  }
+
+  // the last entry can be in previous sector if head has only header
+  uint16_t sector = (head_sector + LOG_SECTORS - 1) % LOG_SECTORS;
+  if (header_read(sector, &seq) && (seq == ((head_seq - 1) & VALUE_MASK)))
+  {
+    for (uint16_t i = HEADER_SLOT + 1; i < SLOTS_PER_SECTOR; i++)
+    {
+      slot_t entry;
+      slot_read(sector, i, &entry);
+      if (slot_is_valid(&entry))
+      {
+        next_seq = entry.id + 1;
+      }
+    }
+  }
+
+  wr_slot = SLOTS_PER_SECTOR;
+  for (uint16_t i = HEADER_SLOT + 1; i < SLOTS_PER_SECTOR; i++)
+  {
+    slot_t entry;
+    slot_read(head_sector, i, &entry);
+    if (slot_is_erased(&entry))
+    {
+      wr_slot = i;
+      break;
+    }
+    if (slot_is_valid(&entry))
+    {
+      next_seq = entry.id + 1;
+    }
+  }
+  NRF_LOG_INFO("Head sector %d slot %d, next entry %d\n", head_sector, wr_slot, next_seq);
+}
+
+// ---------------------------------------------------------------------------
+static void poll_start(uint32_t ms)
+{
+  ret_code_t err_code = app_timer_start(poll_tmr, MS_TO_TICK(ms), NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+// ---------------------------------------------------------------------------
+static void OnPollTmr(void* context)
+{
+  (void)context;
+  is_poll_evt = true;
+  sched_Post(SCHED_FLOG);
+}
+
+// ---------------------------------------------------------------------------
+// programs pending entries up to page or sector end by one operation
+static void pending_write(void)
+{
+  slot_t buf[SLOTS_PER_PAGE];
+  uint8_t n;
+
+  CRITICAL_REGION_ENTER();
+  n = MIN(pend_cnt, SLOTS_PER_PAGE - (wr_slot % SLOTS_PER_PAGE));
+  n = MIN(n, SLOTS_PER_SECTOR - wr_slot);
+  for (uint8_t i = 0; i < n; i++)
+  {
+    buf[i] = pend[pend_rd];
+    pend_rd = (pend_rd + 1) % PEND_MAX;
+  }
+  pend_cnt -= n;
+  CRITICAL_REGION_EXIT();
+
+  extFlash_Program(slot_addr(head_sector, wr_slot), buf, n * SLOT_SIZE);
+  wr_slot += n;
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void FLOG_Init(void)
+{
+  ret_code_t err_code = app_timer_create(&poll_tmr, APP_TIMER_MODE_SINGLE_SHOT, OnPollTmr);
+  APP_ERROR_CHECK(err_code);
+
+  if (extFlash_Init() != NRF_SUCCESS)
+  {
+    NRF_LOG_WARNING("External flash isn't found\n");
+    return;
+  }
+  recover();
+  extFlash_Sleep();
+  is_ready = true;
+}
+
+// ---------------------------------------------------------------------------
+void FLOG_Append(uint32_t value)
+{
+  if (!is_ready)
+  {
+    return;
+  }
+
+  CRITICAL_REGION_ENTER();
+  if (pend_cnt < PEND_MAX)
+  {
+    slot_make(&pend[(pend_rd + pend_cnt) % PEND_MAX], next_seq++, value);
+    pend_cnt++;
+  }
+  else
+  {
+    NRF_LOG_WARNING("Page buffer is full\n");
+  }
+  CRITICAL_REGION_EXIT();
+  sched_Post(SCHED_FLOG);
+}
+
+// ---------------------------------------------------------------------------
+void FLOG_Process(void)
+{
+  if (!is_ready || ((state != FLOG_IDLE) && !is_poll_evt))
+  {
+    return;
+  }
+  is_poll_evt = false;
+
+  switch (state)
+  {
+    case FLOG_IDLE:
+      if (pend_cnt == 0)
+      {
+        break;
+      }
+      if (wr_slot >= SLOTS_PER_SECTOR)
+      {
+        // the oldest sector is reused, so all sectors are erased equally
+        head_sector = (head_sector + 1) % LOG_SECTORS;
+        head_seq = (head_seq + 1) & VALUE_MASK;
+        extFlash_SectorErase(slot_addr(head_sector, HEADER_SLOT));
+        state = FLOG_ERASE;
+        poll_start(ERASE_POLL_MS);
+      }
+      else
+      {
+        pending_write();
+        state = FLOG_WRITE;
+        poll_start(PROGRAM_POLL_MS);
+      }
+      break;
+
+    case FLOG_ERASE:
+      if (extFlash_IsBusy())
+      {
+        poll_start(ERASE_POLL_MS);
+      }
+      else
+      {
+        slot_t hdr;
+        slot_make(&hdr, SECTOR_MAGIC, head_seq);
+        extFlash_Program(slot_addr(head_sector, HEADER_SLOT), &hdr, SLOT_SIZE);
+        wr_slot = HEADER_SLOT + 1;
+        state = FLOG_WRITE;
+        poll_start(PROGRAM_POLL_MS);
+      }
+      break;
+
+    case FLOG_WRITE:
+      if (extFlash_IsBusy())
+      {
+        poll_start(PROGRAM_POLL_MS);
+      }
+      else
+      {
+        state = FLOG_IDLE;
+        if (pend_cnt)
+        {
+          sched_Post(SCHED_FLOG);
+        }
+        else
+        {
+          extFlash_Sleep();
+        }
+      }
+      break;
+  }
+}
+
+// ---------------------------------------------------------------------------
+uint32_t FLOG_GetNextSeq(void)
+{
+  return next_seq;
+}
+
+// ---------------------------------------------------------------------------
+bool FLOG_IsBusy(void)
+{
+  return (state != FLOG_IDLE);
+}
+
+// ---------------------------------------------------------------------------
+void FLOG_CursorInit(flog_cursor_t *p_cursor)
+{
+  ASSERT(p_cursor);
+  // sectors after head are older, not written ones are skipped by header check
+  p_cursor->sector = (head_sector + 1) % LOG_SECTORS;
+  p_cursor->slot = HEADER_SLOT;
+  p_cursor->left = is_ready ? LOG_SECTORS : 0;
+}
+
+// ---------------------------------------------------------------------------
+bool FLOG_Read(flog_cursor_t *p_cursor, uint32_t *p_seq, uint32_t *p_value)
+{
+  ASSERT(p_cursor && p_seq && p_value);
+  bool is_found = false;
+
+  // chip doesn't answer reads while it programs or erases, and must stay awake for it
+  if (!is_ready || (state != FLOG_IDLE))
+  {
+    return false;
+  }
+
+  while (!is_found && p_cursor->left)
+  {
+    bool next_sector = false;
+    if (p_cursor->slot == HEADER_SLOT)
+    {
+      uint32_t seq;
+      next_sector = !header_read(p_cursor->sector, &seq);
+      p_cursor->slot++;
+    }
+    else if ((p_cursor->sector == head_sector) && (p_cursor->slot >= wr_slot))
+    {
+      p_cursor->left = 0;   // the newest programmed entry is passed
+    }
+    else
+    {
+      slot_t entry;
+      slot_read(p_cursor->sector, p_cursor->slot, &entry);
+      p_cursor->slot++;
+      if (slot_is_valid(&entry))
+      {
+        *p_seq = entry.id;
+        *p_value = entry.info & VALUE_MASK;
+        is_found = true;
+      }
+      else if (slot_is_erased(&entry))
+      {
+        next_sector = true;
+      }
+      // torn entry is skipped
+    }
+
+    if (next_sector || (p_cursor->slot >= SLOTS_PER_SECTOR))
+    {
+      p_cursor->sector = (p_cursor->sector + 1) % LOG_SECTORS;
+      p_cursor->slot = HEADER_SLOT;
+      p_cursor->left--;
+    }
+  }
+  extFlash_Sleep();
+  return is_found;
+}
+
+#endif // EXT_FLASH_LOG
@@ -0,0 +1,66 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Position to read log from
+ */
+typedef struct
+{
+  uint16_t  sector;     // sector index inside log area
+  uint16_t  slot;       // entry slot inside sector
+  uint16_t  left;       // sectors left to read
+} flog_cursor_t;
+
+/*! ---------------------------------------------------------------------------
+  \brief Flash log module init
+  \details Module is compiled in only with EXT_FLASH_LOG option. It keeps interval
+           counts in the external SPI flash, so history survives reset and battery change.
+           Log is a ring of 4K sectors, each one starts with header holding sector sequence
+           number. Write position is restored by scan of headers and entries, torn entries
+           after power cut are detected by CRC and skipped.
+ ----------------------------------------------------------------------------*/
+void FLOG_Init(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Put entry to RAM page buffer
+  \details Can be invoked from interrupt. Flash is written in FLOG_Process().
+           Entry is dropped if flash wasn't found
+
+  \param value[in] - interval pulses count, 24 bit are kept
+ ----------------------------------------------------------------------------*/
+void FLOG_Append(uint32_t value);
+
+void FLOG_Process(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get sequence number the next entry will have
+ ----------------------------------------------------------------------------*/
+uint32_t FLOG_GetNextSeq(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Check that program or erase is in progress, so FLOG_Read() can't be done
+ ----------------------------------------------------------------------------*/
+bool FLOG_IsBusy(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Set cursor to the oldest entry in log
+ ----------------------------------------------------------------------------*/
+void FLOG_CursorInit(flog_cursor_t *p_cursor);
+
+/*! ---------------------------------------------------------------------------
+  \brief Read entry from cursor and move it to the next one
+  \details Reading is blocking SPI transfer and should be done from main context
+
+  \param p_cursor[in-out] - read position
+  \param p_seq[out]       - entry sequence number
+  \param p_value[out]     - interval pulses count
+
+  \return false if there is no more written entries or flash is busy,
+          cursor isn't moved in the last case
+ ----------------------------------------------------------------------------*/
+bool FLOG_Read(flog_cursor_t *p_cursor, uint32_t *p_seq, uint32_t *p_value);
+
+#endif	// FLASH_LOG_H
@@ -1,9 +1,20 @@
 #include <sdk_common.h>
 #include "nrf_log_ctrl.h"
 #include "nrf_drv_gpiote.h"
+#include "nrf_drv_timer.h"
+#include "nrf_drv_ppi.h"
 #include "nrf_gpio_adds.h"
-#include "sys_alive.h"
+#include "Timer_anomaly_fix.h"
+#include "scheduler.h"
+#include "CPU_usage.h"
 #include "ble_main.h"
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+#include "app_time_lib.h"
+#include "ringbuf.h"
+#include "varint.h"
+#endif
+
+#include "particle_cnt.h"
 
 #define NRF_LOG_MODULE_NAME "pcnt"
 #define NRF_LOG_LEVEL       4
@@ -12,6 +23,21 @@
 // ----------------------------------------------------------------------------
 //  DEFINE MODULE PARAMETER
 // ----------------------------------------------------------------------------
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+#define HW_COUNTER_TIMER_ID     2   // shared with sound module. Sound blocks counter when plays
+#if defined(PULSE_HW_COUNTER_PER_PULSE_EVT) && !PULSE_HW_COUNTER_PER_PULSE_EVT
+// tiristor is reset by pull switching from pulse interrupt, PPI can't change pin pull
+#error "PULSE_HW_COUNTER needs interrupt per pulse, PULSE_HW_COUNTER_PER_PULSE_EVT=0 isn't supported"
+#endif
+#endif
+
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+#define TS_ENTRY_SIZE           sizeof(uint32_t)
+#define TS_TICK_MASK            0x00FFFFFFul  // RTC1 counter width
+#define TS_LOST_SHIFT           24            // lost pulses before entry are kept in free bits
+#define TS_PKT_HEADER           (sizeof(uint32_t) + sizeof(uint8_t))
+#define TS_PKT_DATA             (IOS_NOTIFY_MAX_LEN - TS_PKT_HEADER)
+#endif
 
 // ----------------------------------------------------------------------------
 //   PRIVATE TYPES
@@ -24,26 +50,262 @@
 // ----------------------------------------------------------------------------
 static uint32_t pulse_cnt;
 static bool isNewData;
+
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+static const nrf_drv_timer_t cntTmr = NRF_DRV_TIMER_INSTANCE(HW_COUNTER_TIMER_ID);
+static nrf_ppi_channel_t ppi_ch_pulse_count;
+static uint16_t hw_last;          // counter timer value was added to pulse_cnt last time
+static uint32_t notified_cnt;     // pulse_cnt value was sent over BLE last time
+static bool     hw_active;        // pulses are counted by timer
+static bool     hw_wanted;        // pulse rate is high enough to count by timer
+static bool     hw_blocked;       // timer is borrowed by sound module
+static bool     hw_switching;     // timer, pin and PPI are being reconfigured
+#endif
+
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+// filled by pulse interrupt, drained by main loop
+SPSC_RING_BUF_DEF(ts_rb, PULSE_TS_RING_SIZE * TS_ENTRY_SIZE);
+static uint8_t ts_lost;   // pulses weren't stored because ring is full
+#endif
+
 // ----------------------------------------------------------------------------
 //    PRIVATE FUNCTION
 // ----------------------------------------------------------------------------
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+// pulse interrupt context
+static void ts_capture(void)
+{
+  uint32_t entry = (app_timer_cnt_get() & TS_TICK_MASK) | ((uint32_t)ts_lost << TS_LOST_SHIFT);
+  if (spscRingbufPut(&ts_rb, (uint8_t*)&entry, TS_ENTRY_SIZE) == TS_ENTRY_SIZE)
+  {
+    ts_lost = 0;
+  }
+  else if (ts_lost < UINT8_MAX)
+  {
+    ts_lost++;
+  }
+  sched_Post(SCHED_PULSE);
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Send captured timestamps while BLE has free TX buffers
+  \details Notification is [uint32 tick of the first pulse][uint8 lost pulses before it]
+           [varint tick deltas of next pulses]. Tick is the low part of app_time system time.
+           Packet is closed before entry with lost pulses, so deltas are always exact.
+           Timestamps wait in ring while TX buffers are busy, main loop is woken
+           by BLE_EVT_TX_COMPLETE.
+ ----------------------------------------------------------------------------*/
+static void ts_process(void)
+{
+  uint32_t entry;
+  while (spscRingbufPeek(&ts_rb, 0, (uint8_t*)&entry, TS_ENTRY_SIZE) == TS_ENTRY_SIZE)
+  {
+    struct
+    {
+      uint32_t  tick;
+      uint8_t   lost;
+      uint8_t   data[TS_PKT_DATA];
+    } __PACKED pkt;
+    size_t   offset = TS_ENTRY_SIZE;
+    uint32_t prev = entry & TS_TICK_MASK;
+    uint8_t  len = 0;
+
+    // pulse can't wait in ring longer than RTC1 counter period, so it is extended by current time
+    uint32_t now = (uint32_t)app_time_Get_sys_time();
+    pkt.tick = now - ((now - prev) & TS_TICK_MASK);
+    pkt.lost = (uint8_t)(entry >> TS_LOST_SHIFT);
+
+    for (; spscRingbufPeek(&ts_rb, offset, (uint8_t*)&entry, TS_ENTRY_SIZE) == TS_ENTRY_SIZE; offset += TS_ENTRY_SIZE)
+    {
+      uint8_t buf[VARINT_MAX_LEN];
+      if (entry >> TS_LOST_SHIFT)
+      {
+        break;
+      }
+      uint8_t size = varint_encode((entry - prev) & TS_TICK_MASK, buf);
+      if (len + size > sizeof(pkt.data))
+      {
+        break;
+      }
+      memcpy(&pkt.data[len], buf, size);
+      len += size;
+      prev = entry;
+    }
+
+    if (ble_ios_pulse_ts_transfer(&pkt, TS_PKT_HEADER + len) == false)
+    {
+      break;
+    }
+    spscRingbufRelease(&ts_rb, offset);
+  }
+}
+#endif
+
+// ---------------------------------------------------------------------------
 static void OnPulsePinEvt(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
 {
+  PROF_ISR_ENTER();
   if ((pin == PULSE_PIN) && (action == NRF_GPIOTE_POLARITY_LOTOHI))
   {
     nrf_gpio_pull_set(PULSE_PIN, NRF_GPIO_PIN_PULLUP);  // go tiristor to OFF state
-    pulse_cnt++;
-    isNewData = true;
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+    ts_capture();
+#endif
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+    if (hw_active == false)
+#endif
+    {
+      pulse_cnt++;
+      isNewData = true;
+    }
     __asm("nop");
     __asm("nop");
     __asm("nop");
     __asm("nop");
     __asm("nop");
     __asm("nop");
-    sleepLock();
+    if (isNewData)
+    {
+      sched_Post(SCHED_PULSE);
+    }
     nrf_gpio_pull_set(PULSE_PIN, NRF_GPIO_PIN_PULLDOWN);
   }
+  PROF_ISR_EXIT(PROF_ISR_PULSE);
+}
+
+// ---------------------------------------------------------------------------
+static void pulse_pin_init(bool hi_accuracy)
+{
+  nrf_drv_gpiote_in_config_t pulse_conf = GPIOTE_CONFIG_IN_SENSE_LOTOHI(false);
+  pulse_conf.pull = NRF_GPIO_PIN_PULLDOWN;
+  pulse_conf.hi_accuracy = hi_accuracy;
+  ret_code_t err_code;
+
+  err_code = nrf_drv_gpiote_in_init(PULSE_PIN, &pulse_conf, OnPulsePinEvt);
+  ASSERT(err_code == NRF_SUCCESS);
+}
+
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+// ---------------------------------------------------------------------------
+static void OnCntTmr(nrf_timer_event_t event_type, void * p_context)
+{
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Move pulses counted by timer to pulse_cnt
+  \details should be invoked at least every 65535 pulses and inside critical region
+ ----------------------------------------------------------------------------*/
+static void hw_collect(void)
+{
+  if (hw_active)
+  {
+    uint16_t now = (uint16_t)nrf_drv_timer_capture(&cntTmr, NRF_TIMER_CC_CHANNEL0);
+    pulse_cnt += (uint16_t)(now - hw_last);
+    hw_last = now;
+  }
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Switch pulse pin from GPIOTE PORT event with interrupt per pulse
+         to GPIOTE IN channel which increments the counter timer through PPI
+  \details Interrupt per pulse is kept for tiristor reset only. It doesn't count
+           and doesn't wake main loop, so merged interrupts don't lose pulses
+ ----------------------------------------------------------------------------*/
+static void hw_counter_start(void)
+{
+  nrf_drv_timer_config_t timer_cfg =
+  {
+    .frequency          = NRF_TIMER_FREQ_16MHz,
+    .mode               = NRF_TIMER_MODE_COUNTER,
+    .bit_width          = NRF_TIMER_BIT_WIDTH_16,
+    .interrupt_priority = TIMER_DEFAULT_CONFIG_IRQ_PRIORITY,
+    .p_context          = NULL
+  };
+  ret_code_t err_code = nrf_drv_timer_init(&cntTmr, &timer_cfg, OnCntTmr);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  nrf_drv_gpiote_in_uninit(PULSE_PIN);
+  pulse_pin_init(true);
+
+  err_code = nrf_drv_ppi_channel_assign(ppi_ch_pulse_count,
+                                        nrf_drv_gpiote_in_event_addr_get(PULSE_PIN),
+                                        nrf_drv_timer_task_address_get(&cntTmr, NRF_TIMER_TASK_COUNT));
+  ASSERT(err_code == NRF_SUCCESS);
+  err_code = nrf_drv_ppi_channel_enable(ppi_ch_pulse_count);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  nrf_drv_timer_clear(&cntTmr);
+  timer_anomaly_fix(cntTmr.p_reg, 1);
+  nrf_drv_timer_enable(&cntTmr);
+
+  // counting is handed over to timer before the pin event is enabled
+  CRITICAL_REGION_ENTER();
+  hw_last = 0;
+  hw_active = true;
+  CRITICAL_REGION_EXIT();
+  nrf_drv_gpiote_in_event_enable(PULSE_PIN, true);
+  NRF_LOG_INFO("HW counter ON\n");
+}
+
+// ---------------------------------------------------------------------------
+static void hw_counter_stop(void)
+{
+  // the last timer pulses are handed over to pulse_cnt before interrupt counting starts
+  CRITICAL_REGION_ENTER();
+  ret_code_t err_code = nrf_drv_ppi_channel_disable(ppi_ch_pulse_count);
+  ASSERT(err_code == NRF_SUCCESS);
+  hw_collect();
+  hw_active = false;
+  CRITICAL_REGION_EXIT();
+
+  nrf_drv_gpiote_in_uninit(PULSE_PIN);
+  pulse_pin_init(false);
+  nrf_drv_gpiote_in_event_enable(PULSE_PIN, true);
+
+  nrf_drv_timer_disable(&cntTmr);
+  timer_anomaly_fix(cntTmr.p_reg, 0);
+  nrf_drv_timer_uninit(&cntTmr);
+  NRF_LOG_INFO("HW counter OFF\n");
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Switch counting method to the wanted one
+  \details Runs from app_timer interrupt like the sound module which takes the timer,
+           so they don't preempt each other. Only count hand-over is done in critical
+           region. A caller which finds switching in progress returns, and the one
+           doing it checks the wanted method again when it's done
+ ----------------------------------------------------------------------------*/
+static void hw_counter_refresh(void)
+{
+  bool need;
+  bool is_busy;
+  for (;;)
+  {
+    CRITICAL_REGION_ENTER();
+    need = hw_wanted && !hw_blocked;
+    is_busy = hw_switching || (need == hw_active);
+    if (!is_busy)
+    {
+      hw_switching = true;
+    }
+    CRITICAL_REGION_EXIT();
+    if (is_busy)
+    {
+      return;
+    }
+
+    if (need)
+    {
+      hw_counter_start();
+    }
+    else
+    {
+      hw_counter_stop();
+    }
+    hw_switching = false;
+  }
 }
+#endif
 
 
 // ----------------------------------------------------------------------------
@@ -51,12 +313,16 @@ static void OnPulsePinEvt(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action
 // ----------------------------------------------------------------------------
 void particle_cnt_Init(void)
 {
-  nrf_drv_gpiote_in_config_t pulse_conf = GPIOTE_CONFIG_IN_SENSE_LOTOHI(false);
-  pulse_conf.pull = NRF_GPIO_PIN_PULLDOWN;
-  ret_code_t err_code;
+  pulse_pin_init(false);
 
-  err_code = nrf_drv_gpiote_in_init(PULSE_PIN, &pulse_conf, OnPulsePinEvt);
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  ret_code_t err_code = nrf_drv_ppi_channel_alloc(&ppi_ch_pulse_count);
   ASSERT(err_code == NRF_SUCCESS);
+#endif
+
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+  spscRingbufInit(&ts_rb);
+#endif
 }
 
 // ---------------------------------------------------------------------------
@@ -68,16 +334,91 @@ void particle_cnt_Startup()
 // ---------------------------------------------------------------------------
 void particle_cnt_Process()
 {
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  if (hw_active)
+  {
+    // there is no event per pulse. Notify once per rate update if anything was counted
+    uint32_t cnt = particle_cnt_Get();
+    if (cnt != notified_cnt)
+    {
+      isNewData = true;
+    }
+  }
+#endif
+
   if (isNewData)
   {
     isNewData = false;
     NRF_LOG_DEBUG("total pulses %d\n", pulse_cnt);
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+    notified_cnt = pulse_cnt;
+#endif
     ble_ios_pulse_transfer(pulse_cnt);
   }
+
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+  ts_process();
+#endif
 }
 
 // ---------------------------------------------------------------------------
 uint32_t particle_cnt_Get()
 {
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  uint32_t retval;
+  CRITICAL_REGION_ENTER();
+  hw_collect();
+  retval = pulse_cnt;
+  CRITICAL_REGION_EXIT();
+  return retval;
+#else
   return pulse_cnt;
+#endif
+}
+
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+// ---------------------------------------------------------------------------
+void particle_cnt_RateUpdate(uint32_t cps)
+{
+  bool wanted = hw_wanted;
+  if (cps >= PULSE_HW_COUNTER_ON_CPS)
+  {
+    wanted = true;
+  }
+  else if (cps <= PULSE_HW_COUNTER_OFF_CPS)
+  {
+    wanted = false;
+  }
+
+  hw_wanted = wanted;
+  hw_counter_refresh();       // also gives timer back after sound module
+  if (hw_active)
+  {
+    sched_Post(SCHED_PULSE);  // counted pulses are notified once per rate update
+  }
+}
+
+// ---------------------------------------------------------------------------
+void particle_cnt_HwCounterBlock(bool block)
+{
+  hw_blocked = block;
+  if (block)
+  {
+    // owner of the timer needs it right now
+    hw_counter_refresh();
+  }
+  // else timer is taken back by the next rate update
+}
+#endif
+
+#if defined(PULSE_SIMULATOR) && PULSE_SIMULATOR
+// ---------------------------------------------------------------------------
+void particle_cnt_Inject(uint32_t pulses)
+{
+  CRITICAL_REGION_ENTER();
+  pulse_cnt += pulses;
+  CRITICAL_REGION_EXIT();
+  isNewData = true;
+  sched_Post(SCHED_PULSE);
 }
+#endif
@@ -21,4 +21,34 @@ void particle_cnt_Process();
 
 uint32_t particle_cnt_Get();
 
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+/*! ---------------------------------------------------------------------------
+  \brief Report current pulse rate to choose counting method
+  \details Above PULSE_HW_COUNTER_ON_CPS pulses are counted by TIMER2 in counter
+           mode through PPI, interrupt per pulse only resets tiristor. Below
+           PULSE_HW_COUNTER_OFF_CPS module returns to counting by interrupt because
+           GPIOTE IN channel and running TIMER keep HFCLK active and cost more than
+           rare interrupts. Method is switched here, so it must be invoked from
+           app_timer interrupt like sound module
+  \param cps[in] - pulses per last second
+ ----------------------------------------------------------------------------*/
+void particle_cnt_RateUpdate(uint32_t cps);
+
+/*! ---------------------------------------------------------------------------
+  \brief Release TIMER2 and GPIOTE channel for sound module
+  \details Counter falls back to interrupt per pulse immediately if block is requested.
+           Timer is taken back by the next particle_cnt_RateUpdate() after release
+  \param block[in] - true to take resources from counter, false to give them back
+ ----------------------------------------------------------------------------*/
+void particle_cnt_HwCounterBlock(bool block);
+#endif
+
+#if defined(PULSE_SIMULATOR) && PULSE_SIMULATOR
+/*! ---------------------------------------------------------------------------
+  \brief Add pulses from the pulse simulator like they came from the tube
+  \param pulses[in] - amount of pulses
+ ----------------------------------------------------------------------------*/
+void particle_cnt_Inject(uint32_t pulses);
+#endif
+
 #endif	// PARTICLE_CNT_H
\ No newline at end of file
@@ -1,10 +1,10 @@
 #include "sdk_common.h"
 #include "app_error.h"
 #include "nrf_log_ctrl.h"
-#include "app_time_lib.h"
-#include "particle_cnt.h"
-#include "sys_alive.h"
-#include "sound.h"
+#include "scheduler.h"
+#include "typed_queue.h"
+#include "dead_time.h"
+#include "event_queue.h"
 
 #include "particle_watcher.h"
 
@@ -13,20 +13,22 @@
 #define NRF_LOG_DEBUG_COLOR   5
 #include "nrf_log.h"
 
-#define PERIOD_10S    10
+#define PERIOD_10S    PWT_BAR_S
 #define PERIOD_40S    40    //the base timeframe
 #define PERIOD_4M     240
 #define PERIOD_20M    1200
 #define PERIOD_2H     7200
 #define PERIOD_8H    (8*3600)
 
-#define TIMEFRAMES_TOTAL      5
+#define TIMEFRAMES_TOTAL      PWT_TIMEFRAMES_TOTAL
+#define BAR_QUEUE_SIZE        4     // finished bars waiting for PWT_Process, 40 s of main loop delay
 
 typedef struct
 {
-  uint32_t  *accum;
+  uint32_t  *accum;     // ring of bars
   uint32_t  size;
-  uint32_t  volume;
+  uint32_t  volume;     // running sum of all bars
+  uint8_t   head;       // the oldest bar, next one to be overwritten
   uint8_t   shift_cnt;
 } particle_time_frame_t;
 
@@ -36,6 +38,7 @@ typedef struct
   .accum = (uint32_t*)&(uint32_t[_size]){0},  \
   .size = _size,                              \
   .volume = 0,                                \
+  .head = 0,                                  \
   .shift_cnt = 0,                             \
  }
 
@@ -51,96 +54,112 @@ static particle_time_frame_t frames[TIMEFRAMES_TOTAL]=
   CNT_FRAME_DEF(PERIOD_8H   / PERIOD_2H),
 };
 
-static bool is_timer_evt;
 static uint8_t active_tf = 0;
-static uint16_t particle_danger = 42;   //42*4 = 168uRh/h ~10 times over
-static uint16_t particle_alarm  = 15;   //14*4 = 60uRh/h  ~3.3 times over
+static uint32_t bar_acc;            // pulses of not finished 10 sec bar
+static uint8_t  bar_ticks;
 
-APP_TIMER_DEF(tmr);
+// finished bars before dead time correction
+TQUEUE_DEF(bar_q, uint32_t, BAR_QUEUE_SIZE);
 
 // ----------------------------------------------------------------------------
 //    PRIVATE FUNCTION
 // ----------------------------------------------------------------------------
-static void frame_serv(uint8_t fr_num, uint32_t val)
+/*! ---------------------------------------------------------------------------
+  \brief Put new 10 sec bar and cascade full frame volumes to longer timeframes
+  \details Every frame is a ring, so insert costs the same for any frame size
+ ----------------------------------------------------------------------------*/
+static void frame_serv(uint32_t val)
 {
-  NRF_LOG_DEBUG("frame %d val %d\n", fr_num, val);
-  if (fr_num < TIMEFRAMES_TOTAL)
+  for (uint8_t fr_num = 0; fr_num < TIMEFRAMES_TOTAL; fr_num++)
   {
+    NRF_LOG_DEBUG("frame %d val %d\n", fr_num, val);
     particle_time_frame_t *fr = &frames[fr_num];
 
-    fr->volume = 0;
-    for (uint8_t i=0; i<fr->size - 1; i++)
+    fr->volume -= fr->accum[fr->head];
+    fr->accum[fr->head] = val;
+    fr->volume += val;
+    if (++fr->head >= fr->size)
     {
-      fr->accum[i] = fr->accum[i+1];
-      fr->volume +=  fr->accum[i];
+      fr->head = 0;
     }
-    fr->accum[fr->size - 1] = val;
-    fr->volume += val;
 
-    if (++fr->shift_cnt >= fr->size)
+    if (++fr->shift_cnt < fr->size)
     {
-      fr->shift_cnt = 0;
-      frame_serv(fr_num + 1, fr->volume); // recursive call
+      break;
     }
+    fr->shift_cnt = 0;
+    val = fr->volume;
   }
 }
 
-
 // ----------------------------------------------------------------------------
-static void OnTmr(void* context)
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void PWT_Tick(uint32_t cnt)
 {
-  (void)context;
-  is_timer_evt = true;
-  sleepLock();
+  bar_acc += cnt;
+  if (++bar_ticks < PERIOD_10S)
+  {
+    return;
+  }
+  bar_ticks = 0;
+  uint32_t bar = bar_acc;
+  bar_acc = 0;
+  if (!bar_q_push(&bar))
+  {
+    NRF_LOG_WARNING("Bar is lost\n");
+  }
+  sched_Post(SCHED_PWT);
+  EVQ_Tick(bar);
 }
 
-static void alarm(uint16_t particle_cnt_10s)
+// ----------------------------------------------------------------------------
+uint32_t PWT_GetPending(void)
 {
-    if (particle_cnt_10s > particle_danger)
-    {
-      sound_danger();
-    }
-    else if (particle_cnt_10s > particle_alarm)
-    {
-      sound_alarm();
-    }
+  return bar_acc;
 }
 
 // ----------------------------------------------------------------------------
-//    PUBLIC FUNCTION
-// ----------------------------------------------------------------------------
-void PWT_Init(void)
+// runs every PERIOD_10S, or later for all bars finished meanwhile
+void PWT_Process(void)
 {
-  ret_code_t ret_code = app_timer_create(&tmr, APP_TIMER_MODE_REPEATED, OnTmr);
-  APP_ERROR_CHECK(ret_code);
+  uint32_t bar;
+  while (bar_q_pop(&bar))
+  {
+    frame_serv(DTC_Correct(bar, PERIOD_10S * 1000));
+  }
 }
 
 // ----------------------------------------------------------------------------
-void PWT_Startup(void)
+uint32_t  PWT_GetBarVol()
 {
-  ret_code_t ret_code = app_timer_start(tmr, MS_TO_TICK(PERIOD_10S * 1000), NULL);
-  APP_ERROR_CHECK(ret_code);
+  return frames[active_tf].volume;
 }
 
 // ----------------------------------------------------------------------------
-void PWT_Process(void)
+uint8_t PWT_GetBars(uint8_t tf, uint32_t *dst, uint8_t size)
 {
-  static uint32_t pr_old = 0;
-  if (is_timer_evt)
+  ASSERT(tf < TIMEFRAMES_TOTAL);
+  particle_time_frame_t *fr = &frames[tf];
+  uint8_t cnt = MIN(size, fr->size);
+
+  // the newest bars are taken if dst is shorter than frame
+  uint8_t idx = (fr->head + fr->size - cnt) % fr->size;
+  for (uint8_t i = 0; i < cnt; i++)
   {
-    is_timer_evt = false;
-    uint32_t pr_new = particle_cnt_Get();
-    uint16_t delta = pr_new - pr_old;
-    pr_old = pr_new;
-    alarm(delta);
-    frame_serv(0, delta);
+    dst[i] = fr->accum[idx];
+    if (++idx >= fr->size)
+    {
+      idx = 0;
+    }
   }
+  return cnt;
 }
 
 // ----------------------------------------------------------------------------
-uint32_t  PWT_GetBarVol()
+uint8_t PWT_Get_active_tf(void)
 {
-  return frames[active_tf].volume;
+  return active_tf;
 }
 
 // ----------------------------------------------------------------------------
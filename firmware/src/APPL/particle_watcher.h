@@ -1,14 +1,47 @@
 #ifndef PARTICLE_WATCHER_H
 #define PARTICLE_WATCHER_H
 
-void PWT_Init(void);
+#include <stdint.h>
 
-void PWT_Startup(void);
+#define PWT_TIMEFRAMES_TOTAL  5
+#define PWT_BARS_MAX          6   // the longest timeframe size
+#define PWT_BAR_S             10  // the shortest bar in base ticks (seconds)
+
+/*! ---------------------------------------------------------------------------
+  \brief Feed pulses of one base tick
+  \details Second stage of pulse aggregation, invoked by RPW every second from
+           timer interrupt. Every PWT_BAR_S ticks the bar is finished: it's passed
+           to EVQ_Tick() and SCHED_PWT is posted to put it in timeframes
+
+  \param cnt[in] - pulses of the last second
+ ----------------------------------------------------------------------------*/
+void PWT_Tick(uint32_t cnt);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get pulses of the not finished bar
+  \details Must be read in critical region together with the following stages
+ ----------------------------------------------------------------------------*/
+uint32_t PWT_GetPending(void);
 
 void PWT_Process(void);
 
 uint32_t  PWT_GetBarVol();
 
+/*! ---------------------------------------------------------------------------
+  \brief Copy bars history of timeframe
+  \details Bars are placed from the oldest to the newest one.
+           Timeframes are 0: 4x10s, 1: 6x40s, 2: 5x4m, 3: 6x20m, 4: 4x2h
+
+  \param tf[in]    - timeframe number
+  \param dst[out]  - buffer for bars
+  \param size[in]  - dst capacity in bars
+
+  \return amount of bars copied
+ ----------------------------------------------------------------------------*/
+uint8_t PWT_GetBars(uint8_t tf, uint32_t *dst, uint8_t size);
+
+uint8_t PWT_Get_active_tf(void);
+
 void PWT_Set_active_tf(uint8_t tf);
 
 #endif	// PARTICLE_WATCHER_H
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_log_ctrl.h"
+#include "app_time_lib.h"
+#include "particle_cnt.h"
+#include "fixmath.h"
+
+#include "pulse_sim.h"
+
+#if defined(PULSE_SIMULATOR) && PULSE_SIMULATOR
+
+#define NRF_LOG_MODULE_NAME   "PSIM"
+#define NRF_LOG_LEVEL         3
+#include "nrf_log.h"
+
+// ----------------------------------------------------------------------------
+#define SIM_MODE_CONSTANT     0
+#define SIM_MODE_STEP         1
+#define SIM_MODE_BURST        2
+
+#define MIN_INTERVAL_TICK     APP_TIMER_MIN_TIMEOUT_TICKS
+#define TICK_PER_SEC          APP_TIMER_CLOCK_FREQ
+#define LOG2_U32_RANGE_Q16    (32ul << 16)   // log2(2^32) in Q16
+#define BASE_TIME_TICK        ((uint64_t)PULSE_SIM_BASE_TIME_S * TICK_PER_SEC)
+#define HIGH_TIME_TICK        ((uint64_t)PULSE_SIM_HIGH_TIME_MS * TICK_PER_SEC / 1000)
+#define BURST_TIME_TICK       ((uint64_t)PULSE_SIM_BURST_TIME_MS * TICK_PER_SEC / 1000)
+
+// ----------------------------------------------------------------------------
+typedef enum
+{
+  PHASE_BASE,
+  PHASE_HIGH,
+} sim_phase_t;
+
+// ----------------------------------------------------------------------------
+APP_TIMER_DEF(tmr);
+static uint32_t   rnd_state = 0x2545F491;
+static uint64_t   mean_interval_q16;    // mean interval between pulses in RTC ticks Q16
+static uint64_t   pending_q16;          // time to the next pulse after timer expiration in RTC ticks Q16
+static uint64_t   phase_end;            // system time when current phase finishes
+static uint64_t   cycle_start;          // nominal start of current base and high phases
+static sim_phase_t phase;
+static uint32_t   generated;
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+static uint32_t xorshift32(void)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Draw exponential distributed interval
+  \details -ln(U) = (32 - log2(U32)) * ln2, where U32 is uniform in (0...2^32)
+
+  \return interval to the next pulse in RTC ticks Q16
+ ----------------------------------------------------------------------------*/
+static uint64_t next_interval_q16(void)
+{
+  uint32_t u = xorshift32() | 1;
+  uint32_t exp_q16 = (uint32_t)(((uint64_t)(LOG2_U32_RANGE_Q16 - fx_log2_q16(u)) * FX_LN2_Q16) >> 16);
+  return (mean_interval_q16 * exp_q16) >> 16;
+}
+
+// ----------------------------------------------------------------------------
+static void rate_set(uint32_t mcps)
+{
+  ASSERT(mcps);
+  mean_interval_q16 = ((uint64_t)TICK_PER_SEC * 1000 << 16) / mcps;
+  NRF_LOG_INFO("phase %d rate %d mcps\n", phase, mcps);
+}
+
+// ----------------------------------------------------------------------------
+static void phase_check(void)
+{
+#if (PULSE_SIM_MODE != SIM_MODE_CONSTANT)
+  uint64_t now = app_time_Get_sys_time();
+  if (now < phase_end)
+  {
+    return;
+  }
+
+  // phase is switched by the first pulse after its end. High phase lasts full time
+  // from the switch, cycles are counted from nominal start, so schedule doesn't drift
+  if (phase == PHASE_BASE)
+  {
+    phase = PHASE_HIGH;
+  #if (PULSE_SIM_MODE == SIM_MODE_STEP)
+    phase_end = now + HIGH_TIME_TICK;
+  #else
+    phase_end = now + BURST_TIME_TICK;
+  #endif
+    rate_set(PULSE_SIM_HIGH_RATE_MCPS);
+  }
+  else
+  {
+    phase = PHASE_BASE;
+  #if (PULSE_SIM_MODE == SIM_MODE_STEP)
+    cycle_start += BASE_TIME_TICK + HIGH_TIME_TICK;
+  #else
+    cycle_start += BASE_TIME_TICK + BURST_TIME_TICK;
+  #endif
+    phase_end = MAX(cycle_start + BASE_TIME_TICK, now);
+    rate_set(PULSE_SIM_BASE_RATE_MCPS);
+  }
+  pending_q16 = next_interval_q16();
+#endif
+}
+
+// ----------------------------------------------------------------------------
+static void timer_restart(void)
+{
+  uint32_t interval = MAX((uint32_t)(pending_q16 >> 16), MIN_INTERVAL_TICK);
+  uint64_t elapsed_q16 = (uint64_t)interval << 16;
+  // keep a fraction of tick to the next pulse so the mean rate isn't biased
+  pending_q16 = (pending_q16 > elapsed_q16) ? pending_q16 - elapsed_q16 : 0;
+  ret_code_t ret_code = app_timer_start(tmr, interval, NULL);
+  APP_ERROR_CHECK(ret_code);
+}
+
+// ----------------------------------------------------------------------------
+static void OnTmr(void* context)
+{
+  (void)context;
+  uint32_t pulses = 1;  // the pulse which is due now
+
+  // all pulses closer than app_timer can resolve are delivered together
+  pending_q16 += next_interval_q16();
+  while ((pending_q16 >> 16) < MIN_INTERVAL_TICK)
+  {
+    pulses++;
+    pending_q16 += next_interval_q16();
+  }
+
+  generated += pulses;
+  particle_cnt_Inject(pulses);
+
+  phase_check();
+  timer_restart();
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void PSIM_Init(void)
+{
+  ret_code_t ret_code = app_timer_create(&tmr, APP_TIMER_MODE_SINGLE_SHOT, OnTmr);
+  APP_ERROR_CHECK(ret_code);
+}
+
+// ----------------------------------------------------------------------------
+void PSIM_Startup(void)
+{
+  phase = PHASE_BASE;
+  cycle_start = app_time_Get_sys_time();
+  phase_end = cycle_start + BASE_TIME_TICK;
+  rate_set(PULSE_SIM_BASE_RATE_MCPS);
+  pending_q16 = next_interval_q16();
+  timer_restart();
+}
+
+// ----------------------------------------------------------------------------
+uint32_t PSIM_GetGenerated(void)
+{
+  return generated;
+}
+
+#endif // PULSE_SIMULATOR
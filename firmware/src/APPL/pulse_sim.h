@@ -0,0 +1,29 @@
+#ifndef PULSE_SIM_H
+#define PULSE_SIM_H
+
+#include <stdint.h>
+
+/*! ---------------------------------------------------------------------------
+  \brief Pulse simulator module init
+  \details Module is compiled in only with PULSE_SIMULATOR option.
+           It feeds a synthetic Poisson pulse train to the particle counter
+           the same way as the geiger tube does, so alarm latency and counting
+           can be checked without a radiation source.
+ ----------------------------------------------------------------------------*/
+void PSIM_Init(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Pulse simulator start
+  \details One app_timer instance is used. Pulses closer than the minimal
+           app_timer timeout are delivered together in one timer callback
+ ----------------------------------------------------------------------------*/
+void PSIM_Startup(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get amount of pulses generated from the simulator start
+
+  \return total generated pulses
+ ----------------------------------------------------------------------------*/
+uint32_t PSIM_GetGenerated(void);
+
+#endif	// PULSE_SIM_H
@@ -1,19 +1,52 @@
+#include "sdk_common.h"
+#include "app_util_platform.h"
 #include "particle_cnt.h"
+#include "CPU_usage.h"
 #include "app_time_lib.h"
+#include "slack_timer.h"
 #include "sound.h"
 #include "HighVoltagePump.h"
+#include "dead_time.h"
+#include "particle_watcher.h"
+#if (defined(ALARM_CUSUM) && ALARM_CUSUM) || (defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW)
+#include "fixmath.h"
+#endif
+
+#include "realtime_particle_watcher.h"
 
 #define NRF_LOG_MODULE_NAME "RPW"
 #define NRF_LOG_LEVEL       3
 #include "nrf_log.h"
 
 #define   ONE_SEC_TICK            MS_TO_TICK(1000)
-#define   DOSE_DURATION           40    // 40 sec measurement according to sensor sensivity
+#define   DOSE_DURATION           RPW_WINDOW_S
 #define   ALART_REPEAT_PERIOD     1800  // 30 min
-#define   WARNING_THRESHOLD       85
-#define   DANGER_THRESHOLD        170
+#define   BASE_DOSE_DURATION      40    // thresholds are given for 40 sec measurement according to sensor sensivity
+#define   WARNING_THRESHOLD       (85  * DOSE_DURATION / BASE_DOSE_DURATION)
+#define   DANGER_THRESHOLD        (170 * DOSE_DURATION / BASE_DOSE_DURATION)
 #define   CRITICAL_DISCHARCE_CNT  15    //15 pulses per second usually discharge capacitor too low. New pump cycle is required
 
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+#ifdef J305
+#define   BACKGROUND_MCPS         ALARM_BG_J305_MCPS
+#elif defined(SBM20)
+#define   BACKGROUND_MCPS         ALARM_BG_SBM20_MCPS
+#else
+#error "Unknown sensor type"
+#endif
+// rates of the window thresholds in 1/1000 pulse per second
+#define   WARNING_MCPS            (85  * 1000 / BASE_DOSE_DURATION)
+#define   DANGER_MCPS             (170 * 1000 / BASE_DOSE_DURATION)
+#define   ARL_SEC                 (ALARM_ARL_DAYS * 86400ul)
+#define   MAX_CNT_PER_SEC         1000  // enough to cross any threshold at once, keeps sum in 32 bits
+
+STATIC_ASSERT(WARNING_MCPS > BACKGROUND_MCPS);
+#endif
+
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+#define   TARGET_CNT              ((1000ul * 1000) / (RPW_TARGET_ERR_PM * RPW_TARGET_ERR_PM))  // relative error is 1/sqrt(N)
+#endif
+
 
 typedef enum
 {
@@ -22,27 +55,170 @@ typedef enum
   DANGER_ALARM,
 } alarm_level_t;
 
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+// one sided Poisson CUSUM, values in Q16
+typedef struct
+{
+  uint32_t  llr;      // log likelihood ratio per pulse: ln(alarm rate / background rate)
+  uint32_t  drift;    // rates difference per second, equal to threshold rate * llr
+  uint32_t  sum;
+} cusum_t;
+#endif
+
 
-APP_TIMER_DEF(tmr);
-static uint8_t  slide_array[DOSE_DURATION];
+SLACK_TIMER_DEF(tmr);
+static uint16_t slide_array[DOSE_DURATION];
 static uint8_t  pointer;
 static uint32_t last_cnt;
-static uint16_t realtime_summ;
+static uint32_t realtime_summ;    // running sum of slide_array
+static uint32_t realtime_corr;    // realtime_summ after dead time correction
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+static uint8_t        filled;     // seconds in slide_array after start
+static uint8_t        win_len;    // the newest seconds of adaptive window
+static uint32_t       win_sum;    // running sum of adaptive window
+static rpw_estimate_t estimate;
+#endif
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+static cusum_t  cusum_warning;
+static cusum_t  cusum_danger;
+static uint32_t cusum_h;          // decision threshold in Q16
+#endif
+
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+// ----------------------------------------------------------------------------
+static uint32_t ln_q16(uint32_t x)
+{
+  return (uint32_t)(((uint64_t)fx_log2_q16(x) * FX_LN2_Q16) >> 16);
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Set CUSUM to grow only above threshold rate
+  \details Background b is tested against alarm rate a. Sum grows on average when rate
+           is above (a - b) / ln(a / b), so a is found for this reference to be the
+           threshold rate. Then drift = threshold * llr
+ ----------------------------------------------------------------------------*/
+static void cusum_init(cusum_t *p_cusum, uint32_t threshold_mcps)
+{
+  uint32_t lo = threshold_mcps;
+  uint32_t hi = threshold_mcps * 64;
+  while (hi - lo > 1)
+  {
+    uint32_t alarm_mcps = (lo + hi) / 2;
+    uint64_t ref = (uint64_t)(alarm_mcps - BACKGROUND_MCPS) * FX_Q16_ONE / (ln_q16(alarm_mcps) - ln_q16(BACKGROUND_MCPS));
+    if (ref < threshold_mcps)
+    {
+      lo = alarm_mcps;
+    }
+    else
+    {
+      hi = alarm_mcps;
+    }
+  }
+  p_cusum->llr = ln_q16(hi) - ln_q16(BACKGROUND_MCPS);
+  p_cusum->drift = (uint32_t)((uint64_t)threshold_mcps * p_cusum->llr / 1000);
+  p_cusum->sum = 0;
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Add pulses of one second to CUSUM
+  \details S = max(0, S + n * llr - drift). S is kept not above threshold, so it
+           falls below in a few seconds after rate returns to background
+  \return true if the alarm rate is detected
+ ----------------------------------------------------------------------------*/
+static bool cusum_update(cusum_t *p_cusum, uint32_t cnt)
+{
+  uint32_t gain = MIN(cnt, MAX_CNT_PER_SEC) * p_cusum->llr;
+  uint32_t sum = p_cusum->sum + MIN(gain, cusum_h + p_cusum->drift);   // one second can cross threshold
+  sum = (sum > p_cusum->drift) ? sum - p_cusum->drift : 0;
+  p_cusum->sum = MIN(sum, cusum_h);
+  return (p_cusum->sum >= cusum_h);
+}
+#endif
+
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+/*! ---------------------------------------------------------------------------
+  \brief Estimate by the shortest span of the newest seconds holding TARGET_CNT pulses
+  \details At high rate window shrinks to a few seconds, so a step is followed fast.
+           At background it is the whole slide_array. Window sum is kept running:
+           the newest second comes in, then the oldest ones leave while the rest
+           holds TARGET_CNT, or older ones come back while it doesn't.
+           Runs after the newest second is put in slide_array
+  \param dropped[in] - pulses of the second overwritten in slide_array
+ ----------------------------------------------------------------------------*/
+static void estimate_update(uint16_t dropped)
+{
+  if (win_len == DOSE_DURATION)
+  {
+    win_sum -= dropped;
+    win_len--;
+  }
+  win_sum += slide_array[(pointer + DOSE_DURATION - 1) % DOSE_DURATION];
+  win_len++;
+
+  // the oldest second of window
+  uint8_t oldest = (pointer + DOSE_DURATION - win_len) % DOSE_DURATION;
+  while ((win_len > 1) && (win_sum - slide_array[oldest] >= TARGET_CNT))
+  {
+    win_sum -= slide_array[oldest];
+    win_len--;
+    oldest = (oldest + 1) % DOSE_DURATION;
+  }
+  while ((win_sum < TARGET_CNT) && (win_len < filled))
+  {
+    oldest = (oldest == 0) ? DOSE_DURATION - 1 : oldest - 1;
+    win_sum += slide_array[oldest];
+    win_len++;
+  }
+
+  // not corrected for dead time, as RPW_GetInstant() without the option
+  uint32_t value = win_sum * DOSE_DURATION / win_len;
+  uint32_t root = fx_isqrt(win_sum);
+  uint32_t rel_err = (root) ? 1000 / root : 1000;
+
+  CRITICAL_REGION_ENTER();
+  estimate.value = (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+  estimate.window_s = win_len;
+  estimate.rel_err_pm = (uint16_t)rel_err;
+  CRITICAL_REGION_EXIT();
+}
+#endif
 
 // ----------------------------------------------------------------------------
-static void alarmer(uint16_t cnt)
+static alarm_level_t detect(uint32_t cnt)
+{
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+  // both sums are updated every second
+  bool is_warning = cusum_update(&cusum_warning, cnt);
+  bool is_danger  = cusum_update(&cusum_danger, cnt);
+  NRF_LOG_DEBUG("CUSUM %d %d\n", cusum_warning.sum, cusum_danger.sum);
+  if (is_danger)
+  {
+    return DANGER_ALARM;
+  }
+  return is_warning ? WARNING_ALARM : NO_ALARM;
+#else
+  (void)cnt;
+  if (realtime_corr > DANGER_THRESHOLD)
+  {
+    return DANGER_ALARM;
+  }
+  return (realtime_corr > WARNING_THRESHOLD) ? WARNING_ALARM : NO_ALARM;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+static void alarmer(alarm_level_t detected, uint32_t cnt)
 {
   static uint16_t alarm_repeat_counter = 0;
   static alarm_level_t level = NO_ALARM;
-NRF_LOG_INFO("cnt=%d\n", cnt);
-  if ((cnt > DANGER_THRESHOLD) && ((level < DANGER_ALARM) || (alarm_repeat_counter == 0)))
+  if ((detected == DANGER_ALARM) && ((level < DANGER_ALARM) || (alarm_repeat_counter == 0)))
   {
     alarm_repeat_counter = ALART_REPEAT_PERIOD;
     level = DANGER_ALARM;
     sound_danger();
     NRF_LOG_INFO("Danger due to cnt=%d\n", cnt);
   }
-  else if ((cnt > WARNING_THRESHOLD) && ((level < WARNING_ALARM) || (alarm_repeat_counter == 0)))
+  else if ((detected >= WARNING_ALARM) && ((level < WARNING_ALARM) || (alarm_repeat_counter == 0)))
   {
     alarm_repeat_counter = ALART_REPEAT_PERIOD;
     level = WARNING_ALARM;
@@ -61,44 +237,93 @@ NRF_LOG_INFO("cnt=%d\n", cnt);
 
 
 // ----------------------------------------------------------------------------
+// the base tick of pulse aggregation: 1 s here -> 10 s bars -> hourly records
 static void OnTmr(void* context)
 {
+  PROF_ISR_ENTER();
   uint32_t after = particle_cnt_Get();
   uint32_t diff = after - last_cnt;
+#if defined(HV_ADAPTIVE_PAUSE) && HV_ADAPTIVE_PAUSE
+  HV_RateUpdate(diff);
+#else
   if (diff > CRITICAL_DISCHARCE_CNT)
   {
     HV_instantKick();
   }
+#endif
   last_cnt = after;
-  diff = (diff > UINT8_MAX) ? UINT8_MAX : diff;
-  slide_array[pointer] = (uint8_t)diff;
-  pointer = ++pointer % DOSE_DURATION;
-  realtime_summ = 0;
-  for (uint8_t i=0; i<DOSE_DURATION; i++)
+  PWT_Tick(diff);
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  particle_cnt_RateUpdate(diff);
+#endif
+  diff = (diff > UINT16_MAX) ? UINT16_MAX : diff;
+  // the oldest second leaves window, the newest comes in
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+  uint16_t dropped = slide_array[pointer];
+#endif
+  realtime_summ -= slide_array[pointer];
+  realtime_summ += diff;
+  slide_array[pointer] = (uint16_t)diff;
+  pointer = (pointer + 1) % DOSE_DURATION;
+  realtime_corr = DTC_Correct(realtime_summ, DOSE_DURATION * 1000);
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+  if (filled < DOSE_DURATION)
   {
-    realtime_summ += slide_array[i];
+    filled++;
   }
-  alarmer(realtime_summ);
+  estimate_update(dropped);
+#endif
+  alarmer(detect(diff), realtime_corr);
+  PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
 }
 
 
 // ----------------------------------------------------------------------------
 void RPW_Init(void)
 {
-  ret_code_t ret_code = app_timer_create(&tmr, APP_TIMER_MODE_REPEATED, OnTmr);
+  // no slack: the tick is the shared wakeup other slack timers are served in
+  ret_code_t ret_code = slack_timer_create(&tmr, APP_TIMER_MODE_REPEATED, OnTmr, 0);
   APP_ERROR_CHECK(ret_code);
+#if defined(ALARM_CUSUM) && ALARM_CUSUM
+  // false alarm comes about once in ARL at background when threshold is ln(ARL)
+  cusum_h = ln_q16(ARL_SEC);
+  cusum_init(&cusum_warning, WARNING_MCPS);
+  cusum_init(&cusum_danger, DANGER_MCPS);
+#endif
 }
 
 // ----------------------------------------------------------------------------
 void RPW_Startup(void)
 {
-  ret_code_t ret_code = app_timer_start(tmr, ONE_SEC_TICK, NULL);
+  ret_code_t ret_code = slack_timer_start(tmr, ONE_SEC_TICK, NULL);
   APP_ERROR_CHECK(ret_code);
 }
 
 // ----------------------------------------------------------------------------
 uint16_t RPW_GetInstant(void)
 {
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+  NRF_LOG_INFO("RPW=%d in %d s\n", estimate.value, estimate.window_s);
+  return estimate.value;
+#else
   NRF_LOG_INFO("RPW=%d\n", realtime_summ);
-  return realtime_summ;
+  return (realtime_summ > UINT16_MAX) ? UINT16_MAX : (uint16_t)realtime_summ;
+#endif
+}
+
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+// ----------------------------------------------------------------------------
+void RPW_GetEstimate(rpw_estimate_t *p_estimate)
+{
+  ASSERT(p_estimate);
+  CRITICAL_REGION_ENTER();
+  *p_estimate = estimate;
+  CRITICAL_REGION_EXIT();
+}
+#endif
+
+// ----------------------------------------------------------------------------
+uint32_t RPW_GetCorrected(void)
+{
+  return realtime_corr;
 }
\ No newline at end of file
@@ -6,6 +6,28 @@
 
 void RPW_Init(void);
 void RPW_Startup(void);
+/*! ---------------------------------------------------------------------------
+  \brief Pulses of window. With RPW_ADAPTIVE_WINDOW it is estimate of adaptive window
+         scaled to RPW_WINDOW_S. Both are not dead time corrected, see RPW_GetCorrected()
+ ----------------------------------------------------------------------------*/
 uint16_t RPW_GetInstant(void);
 
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+// instant value of adaptive window
+typedef struct
+{
+  uint16_t  value;        // pulses scaled to RPW_WINDOW_S, not dead time corrected
+  uint8_t   window_s;     // integration window
+  uint16_t  rel_err_pm;   // relative statistical error (1/1000)
+} rpw_estimate_t;
+
+/*! ---------------------------------------------------------------------------
+  \brief Get instant value with its window and error
+  \details Window is the shortest span of the newest seconds holding enough pulses
+           for RPW_TARGET_ERR_PM error. It is RPW_WINDOW_S when pulses are too few
+ ----------------------------------------------------------------------------*/
+void RPW_GetEstimate(rpw_estimate_t *p_estimate);
+#endif
+uint32_t RPW_GetCorrected(void);
+
 #endif	// REALTIME_PARTICLE_WATCHER_H
\ No newline at end of file
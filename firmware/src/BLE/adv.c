@@ -4,6 +4,7 @@
 #include "ble_advertising.h"
 #include "peer_manager.h"
 #include "fstorage.h"
+#include "energy_model.h"
 
 #include "adv.h"
 
@@ -251,6 +252,7 @@ ret_code_t advertising_start(void)
 
   ret = sd_ble_gap_adv_start(&adv_params);
   APP_ERROR_CHECK(ret);
+  ENRG_RADIO_SET(ENRG_RADIO_ADV, adv_params.interval * UNIT_0_625_MS);
   return NRF_SUCCESS;
 }
 
@@ -261,4 +263,5 @@ void advertising_stop(void)
   m_advertising_start_pending = false;
   ret_code_t ret = sd_ble_gap_adv_stop();
   NRF_LOG_DEBUG("Stop Code %d\n", ret);
+  ENRG_RADIO_SET(ENRG_RADIO_IDLE, 0);
 }
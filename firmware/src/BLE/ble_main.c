@@ -18,6 +18,11 @@
 #include "ble_ios.h"
 #include "event_queue.h"
 #include "realtime_particle_watcher.h"
+#include "particle_watcher.h"
+#include "HighVoltagePump.h"
+#include "scheduler.h"
+#include "CPU_usage.h"
+#include "energy_model.h"
 
 
 #include "ble_main.h"
@@ -36,21 +41,33 @@
 #define CENTRAL_LINK_COUNT              0      //Number of central links used by the application. When changing this number remember to adjust the RAM settings
 #define PERIPHERAL_LINK_COUNT           1      //Number of peripheral links used by the application. When changing this number remember to adjust the RAM settings
 #define BATTERY_LOW_INDICATED_REF       1500    // A minimal voltage reference to indicate
+#define EVQ_STREAM_HEADER               (2 * sizeof(uint32_t))  // seq and prev value
+#define EVQ_STREAM_DATA                 (BLE_GATT_ATT_MTU_DEFAULT - 3 - EVQ_STREAM_HEADER)  // records bytes per notification
 //------------------------------------------------------------------------------
 //        PRIVATE FUNCTIONS PROTOTYPES
 //------------------------------------------------------------------------------
 static void ios_set_sys_time(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data);
 static void ios_sys_time_request(uint16_t conn_handle);
 static void ios_instant_value_request(uint16_t conn_handle);
+static void ios_corrected_value_request(uint16_t conn_handle);
+static void ios_set_bars_tf(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data);
+static void ios_bars_request(uint16_t conn_handle);
+static void ios_evq_stream_ctrl(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data);
+static void retCodeCheck(ret_code_t ret_code);
 static void ios_evq_request(uint16_t conn_handle);
 static void ios_evq_status_request(uint16_t conn_handle);
 static void ios_temperature_request(uint16_t conn_handle);
 static void ios_battery_request(uint16_t conn_handle);
+static void ios_hw_param_request(uint16_t conn_handle);
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+static void ios_set_diag_sel(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data);
+static void ios_diag_request(uint16_t conn_handle);
+#endif
 
 //------------------------------------------------------------------------------
 //        PRIVATE VARIABLES
 //------------------------------------------------------------------------------
-// 5d51fdfX-06c2-11ed-aa05-0800200c9a66 x=0...A
+// 5d51fdfX-06c2-11ed-aa05-0800200c9a66 x=0...D
 static uuid_128_t base_uuid=
 {
   .field.low= 0x0800200c9a66,
@@ -83,7 +100,11 @@ static const char_desc_t ios_chars[] =
   },
   {
     .uuid = IOS_INSTANT_VALUE_CHAR,
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+    .len =  {.init = 2, .max = 5, .var = true},
+#else
     .len =  {.init = 2, .max = 2, .var = false},
+#endif
     .prop = {.read = 1},
     .rd_access = SEC_JUST_WORKS,
     .cccd_wr_access = SEC_JUST_WORKS,
@@ -122,6 +143,61 @@ static const char_desc_t ios_chars[] =
     .rdCb = ios_battery_request,
     .is_defered_read = true,
   },
+  {
+    .uuid = IOS_HW_PARAM_CHAR,
+    .len =  {.init = sizeof(hv_report_t), .max = sizeof(hv_report_t), .var = false},
+    .prop = {.read = 1},
+    .rd_access = SEC_JUST_WORKS,
+    .rdCb = ios_hw_param_request,
+    .is_defered_read = true,
+  },
+  {
+    .uuid = IOS_CORRECTED_VALUE_CHAR,
+    .len =  {.init = 4, .max = 4, .var = false},
+    .prop = {.read = 1},
+    .rd_access = SEC_JUST_WORKS,
+    .rdCb = ios_corrected_value_request,
+    .is_defered_read = true,
+  },
+  {
+    .uuid = IOS_BARS_CHAR,
+    .len =  {.init = 2, .max = 2 + PWT_BARS_MAX * sizeof(uint32_t), .var = true},
+    .prop = {.read = 1, .write = 1},
+    .rd_access = SEC_JUST_WORKS,
+    .wr_access = SEC_JUST_WORKS,
+    .wrCb = ios_set_bars_tf,
+    .rdCb = ios_bars_request,
+    .is_defered_read = true,
+    .is_long_read = true,
+  },
+  {
+    .uuid = IOS_EVQ_STREAM_CHAR,
+    .len =  {.init = 0, .max = EVQ_STREAM_HEADER + EVQ_STREAM_DATA, .var = true},
+    .prop = {.write = 1, .notify = 1},
+    .wr_access = SEC_JUST_WORKS,
+    .cccd_wr_access = SEC_JUST_WORKS,
+    .wrCb = ios_evq_stream_ctrl,
+  },
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+  {
+    .uuid = IOS_PULSE_TS_CHAR,
+    .len =  {.init = 0, .max = IOS_NOTIFY_MAX_LEN, .var = true},
+    .prop = {.notify = 1},
+    .cccd_wr_access = SEC_JUST_WORKS,
+  },
+#endif
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+  {
+    .uuid = IOS_DIAG_CHAR,
+    .len =  {.init = 1, .max = 1 + CPU_USAGE_RECORD_MAX, .var = true},
+    .prop = {.read = 1, .write = 1},
+    .rd_access = SEC_JUST_WORKS,
+    .wr_access = SEC_JUST_WORKS,
+    .wrCb = ios_set_diag_sel,
+    .rdCb = ios_diag_request,
+    .is_defered_read = true,
+  },
+#endif
 };
 
 BLE_IOS_DEF(main_ios, &base_uuid, INPUT_OUTPUT_SERV, ios_chars, sizeof(ios_chars)/sizeof(char_desc_t));
@@ -133,6 +209,11 @@ static ble_ctx_t ble_ctx =
   .auth_rd_conn_handle = BLE_CONN_HANDLE_INVALID,
 };
 
+static bool evq_stream_on;
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+static uint8_t diag_sel = CPU_USAGE_SEL_TOTAL;
+#endif
+
 //------------------------------------------------------------------------------
 //        PRIVATE FUNCTIONS
 //------------------------------------------------------------------------------
@@ -178,6 +259,97 @@ static void ios_evq_status_request(uint16_t conn_handle)
   APP_ERROR_CHECK(ret_code);
 }
 
+// ---------------------------------------------------------------------------
+// 1 byte: 1 - start event queue sync by notifications, 0 - stop it
+// 4 bytes: acknowledge, all records before this sequence number are received
+static void ios_evq_stream_ctrl(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data)
+{
+  if (datalen == sizeof(uint8_t))
+  {
+    evq_stream_on = (p_data[0] != 0);
+    if (evq_stream_on)
+    {
+      // sync always starts from the oldest not acknowledged record
+      EVQ_SyncStart();
+      sched_Post(SCHED_BLE);
+    }
+  }
+  else if (datalen == sizeof(uint32_t))
+  {
+    uint32_t ack;
+    memcpy(&ack, p_data, sizeof(ack));
+    EVQ_Release(ack);
+  }
+}
+
+// ---------------------------------------------------------------------------
+static bool evq_stream_send(uint32_t seq, uint32_t prev, const uint8_t *p_data, uint16_t len, void *ctx)
+{
+  struct
+  {
+    uint32_t  seq;
+    uint32_t  prev;
+    uint8_t   data[EVQ_STREAM_DATA];
+  } __PACKED pkt;
+
+  ASSERT(len <= sizeof(pkt.data));
+  pkt.seq = seq;
+  pkt.prev = prev;
+  memcpy(pkt.data, p_data, len);
+
+  ret_code_t ret_code = ble_ios_on_output_change(ble_ctx.conn_handle, &main_ios, IOS_EVQ_STREAM_CHAR, &pkt, EVQ_STREAM_HEADER + len);
+  if (ret_code == NRF_SUCCESS)
+  {
+    return true;
+  }
+  if (ret_code != BLE_ERROR_NO_TX_PACKETS)
+  {
+    // notification isn't enabled or link is lost
+    retCodeCheck(ret_code);
+    evq_stream_on = false;
+  }
+  return false;
+}
+
+/*! ---------------------------------------------------------------------------
+ * \brief Fill all free SoftDevice TX buffers by event queue records.
+ * \details Notification is [seq][prev][whole varint records up to EVQ_STREAM_DATA bytes], seq is the
+ *          first record number, prev is the value before it. See evq_batch_handler_t for decoding.
+ *          Records stay in queue until client acknowledges them, so a sync broken by link loss
+ *          is started again from the first not acknowledged record. Client drops already known
+ *          sequence numbers and sees a gap if queue overflow threw records out.
+ *          The last notification is 8 bytes [next seq][uncomplete current event] like IOS_EVQ_CHAR gives.
+ *          Pumping continues on BLE_EVT_TX_COMPLETE.
+ */
+static void evq_stream_pump(void)
+{
+  while (evq_stream_on && (ble_ctx.conn_handle != BLE_CONN_HANDLE_INVALID))
+  {
+    if (EVQ_SyncGetSeq() == EVQ_GetNextSeq())
+    {
+      struct
+      {
+        uint32_t  seq;
+        uint32_t  uncomplete;
+      } end_marker = {EVQ_SyncGetSeq(), EVQ_GetUncomplete()};
+
+      ret_code_t ret_code = ble_ios_on_output_change(ble_ctx.conn_handle, &main_ios, IOS_EVQ_STREAM_CHAR, &end_marker, sizeof(end_marker));
+      if (ret_code != BLE_ERROR_NO_TX_PACKETS)
+      {
+        retCodeCheck(ret_code);
+        NRF_LOG_INFO("EVQ stream finished\n");
+        evq_stream_on = false;
+      }
+      break;
+    }
+
+    if (EVQ_SyncPeek(EVQ_STREAM_DATA, evq_stream_send, NULL) == false)
+    {
+      break;    // no TX buffers, continue on BLE_EVT_TX_COMPLETE
+    }
+  }
+}
+
 // ---------------------------------------------------------------------------
 static void bat_mea_cb(uint16_t mv, void *ctx)
 {
@@ -231,10 +403,103 @@ static void OnTimerEvent(void * p_context)
 }
 
 // ---------------------------------------------------------------------------
+// with adaptive window: [value, window s, relative error 1/1000], value is first as before
 static void ios_instant_value_request(uint16_t conn_handle)
 {
+#if defined(RPW_ADAPTIVE_WINDOW) && RPW_ADAPTIVE_WINDOW
+  rpw_estimate_t estimate;
+  struct
+  {
+    uint16_t  value;
+    uint8_t   window_s;
+    uint16_t  rel_err_pm;
+  } __PACKED answer;
+
+  RPW_GetEstimate(&estimate);
+  answer.value = estimate.value;
+  answer.window_s = estimate.window_s;
+  answer.rel_err_pm = estimate.rel_err_pm;
+  ret_code_t ret_code = ble_ios_rd_reply(conn_handle, &answer, sizeof(answer));
+#else
   uint16_t val = RPW_GetInstant();
   ret_code_t ret_code = ble_ios_rd_reply(conn_handle, &val, sizeof(val));
+#endif
+  APP_ERROR_CHECK(ret_code);
+}
+
+// ---------------------------------------------------------------------------
+// selects timeframe for bars read
+static void ios_set_bars_tf(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data)
+{
+  if ((datalen == sizeof(uint8_t)) && (p_data[0] < PWT_TIMEFRAMES_TOTAL))
+  {
+    PWT_Set_active_tf(p_data[0]);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// whole bars history of the active timeframe: [tf, count, bars from the oldest one]
+// Answer is longer than ATT MTU, so client gets the tail by read blob
+static void ios_bars_request(uint16_t conn_handle)
+{
+  struct
+  {
+    uint8_t   tf;
+    uint8_t   count;
+    uint32_t  bars[PWT_BARS_MAX];
+  } __PACKED answer;
+
+  uint32_t bars[PWT_BARS_MAX];   // answer is packed, so bars are copied from aligned buffer
+
+  answer.tf = PWT_Get_active_tf();
+  answer.count = PWT_GetBars(answer.tf, bars, PWT_BARS_MAX);
+  memcpy(answer.bars, bars, answer.count * sizeof(uint32_t));
+
+  uint16_t len = sizeof(answer) - (PWT_BARS_MAX - answer.count) * sizeof(uint32_t);
+  ret_code_t ret_code = ble_ios_rd_reply(conn_handle, &answer, len);
+  APP_ERROR_CHECK(ret_code);
+}
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+// ---------------------------------------------------------------------------
+// selects profiler record for diagnostics read
+static void ios_set_diag_sel(uint16_t conn_handle, uint16_t datalen, uint8_t *p_data)
+{
+  if (datalen == sizeof(uint8_t))
+  {
+    diag_sel = p_data[0];
+  }
+}
+
+// ---------------------------------------------------------------------------
+// profiler record: [selector, record]. Only selector is returned if it is unknown
+static void ios_diag_request(uint16_t conn_handle)
+{
+  uint8_t answer[1 + CPU_USAGE_RECORD_MAX];
+
+  answer[0] = diag_sel;
+  uint8_t len = CPU_usage_GetRecord(diag_sel, &answer[1]);
+  ret_code_t ret_code = ble_ios_rd_reply(conn_handle, answer, 1 + len);
+  APP_ERROR_CHECK(ret_code);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// HV pump parameters in use: [on phase ns, discharge ns, steady pause ms, recharges, cycles]
+static void ios_hw_param_request(uint16_t conn_handle)
+{
+  hv_report_t report;
+  HV_GetReport(&report);
+  ret_code_t ret_code = ble_ios_rd_reply(conn_handle, &report, sizeof(report));
+  APP_ERROR_CHECK(ret_code);
+}
+
+// ---------------------------------------------------------------------------
+// instant value after dead time correction
+static void ios_corrected_value_request(uint16_t conn_handle)
+{
+  uint32_t val = RPW_GetCorrected();
+  ret_code_t ret_code = ble_ios_rd_reply(conn_handle, &val, sizeof(val));
   APP_ERROR_CHECK(ret_code);
 }
 
@@ -258,6 +523,8 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
 
       uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
       ble_ctx.conn_handle = conn_handle;
+      ENRG_RADIO_SET(ENRG_RADIO_CONN,
+                     p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval * UNIT_1_25_MS);
       ret_code_t error = app_timer_start(sec_tmr, MS_TO_TICK(1000), NULL);
       ASSERT(error == NRF_SUCCESS);
       
@@ -267,6 +534,30 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
     case BLE_GAP_EVT_DISCONNECTED:
       NRF_LOG_INFO("%s: Disconnected\n", (uint32_t)__func__);
       ble_ctx.conn_handle = BLE_CONN_HANDLE_INVALID;
+      evq_stream_on = false;
+      ENRG_RADIO_SET(ENRG_RADIO_IDLE, 0);
+      break;
+
+    case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+      ENRG_RADIO_SET(ENRG_RADIO_CONN,
+                     p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval * UNIT_1_25_MS);
+      break;
+
+    case BLE_GAP_EVT_TIMEOUT:
+      if (p_ble_evt->evt.gap_evt.params.timeout.src == BLE_GAP_TIMEOUT_SRC_ADVERTISING)
+      {
+        ENRG_RADIO_SET(ENRG_RADIO_IDLE, 0);
+      }
+      break;
+
+    case BLE_EVT_TX_COMPLETE:
+      if (evq_stream_on)
+      {
+        sched_Post(SCHED_BLE);  // continue stream in BLE_Process()
+      }
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+      sched_Post(SCHED_PULSE);  // send waiting pulse timestamps
+#endif
       break;
 
     case BLE_GATTC_EVT_TIMEOUT:
@@ -308,11 +599,13 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
  */
 static void ble_evt_dispatch(ble_evt_t * p_ble_evt)
 {
+    PROF_ISR_ENTER();
     ble_conn_state_on_ble_evt(p_ble_evt);
     pm_on_ble_evt(p_ble_evt);
     ble_conn_params_on_ble_evt(p_ble_evt);
     on_ble_evt(p_ble_evt);
     ble_ios_on_ble_evt(p_ble_evt, (void*)&main_ios);
+    PROF_ISR_EXIT(PROF_ISR_SD_EVT);
 }
 
 
@@ -326,6 +619,7 @@ static void ble_evt_dispatch(ble_evt_t * p_ble_evt)
  */
 static void sys_evt_dispatch(uint32_t sys_evt)
 {
+    PROF_ISR_ENTER();
     // Dispatch the system event to the fstorage module, where it will be
     // dispatched to the Flash Data Storage (FDS) module.
     fs_sys_event_handler(sys_evt);
@@ -334,6 +628,7 @@ static void sys_evt_dispatch(uint32_t sys_evt)
     // pending flash operations in fstorage. Let fstorage process system events first,
     // so that it can report correctly to the Advertising module.
     ble_advertising_on_sys_evt(sys_evt);
+    PROF_ISR_EXIT(PROF_ISR_SD_EVT);
 }
 
 
@@ -383,7 +678,9 @@ static void retCodeCheck(ret_code_t ret_code)
 {
   if (ret_code != NRF_SUCCESS &&
       ret_code != BLE_ERROR_INVALID_CONN_HANDLE &&
-      ret_code != NRF_ERROR_INVALID_STATE)
+      ret_code != NRF_ERROR_INVALID_STATE &&
+      ret_code != BLE_ERROR_NO_TX_PACKETS &&
+      ret_code != BLE_ERROR_GATTS_SYS_ATTR_MISSING)
   {
       APP_ERROR_CHECK(ret_code);
   }
@@ -427,6 +724,7 @@ void BLE_Init(bool erase_bonds)
 void BLE_Process(void)
 {
  adv_ctrl_Process();
+ evq_stream_pump();
 }
 
 // ----------------------------------------------------------------------------
@@ -444,4 +742,19 @@ void ble_ios_pulse_transfer(uint32_t pulse)
 
   //ret_code = ble_ios_output_set(ble_ctx.conn_handle, &main_ios, IOS_PULSE_CHAR, &pulse, sizeof(pulse));
   //retCodeCheck(ret_code);
-}
\ No newline at end of file
+}
+
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+// ----------------------------------------------------------------------------
+bool ble_ios_pulse_ts_transfer(const void *p_data, uint16_t len)
+{
+  if (ble_ctx.conn_handle == BLE_CONN_HANDLE_INVALID)
+  {
+    return true;
+  }
+
+  ret_code_t ret_code = ble_ios_on_output_change(ble_ctx.conn_handle, &main_ios, IOS_PULSE_TS_CHAR, (void*)p_data, len);
+  retCodeCheck(ret_code);
+  return (ret_code != BLE_ERROR_NO_TX_PACKETS);
+}
+#endif
@@ -16,6 +16,13 @@ typedef struct
 #define IOS_TEMPERATURE_CHAR      0xFDF6
 #define IOS_BATTERY_CHAR          0xFDF7
 #define IOS_HW_PARAM_CHAR         0xFDF8
+#define IOS_CORRECTED_VALUE_CHAR  0xFDF9
+#define IOS_BARS_CHAR             0xFDFA
+#define IOS_EVQ_STREAM_CHAR       0xFDFB
+#define IOS_PULSE_TS_CHAR         0xFDFC
+#define IOS_DIAG_CHAR             0xFDFD
+
+#define IOS_NOTIFY_MAX_LEN        20  // default ATT MTU without notification header
 
 void BLE_Init(bool erase_bonds);
 
@@ -23,4 +30,13 @@ void BLE_Process(void);
 
 void ble_ios_pulse_transfer(uint32_t pulse);
 
+#if defined(PULSE_TIMESTAMP_CAPTURE) && PULSE_TIMESTAMP_CAPTURE
+/*! ---------------------------------------------------------------------------
+  \brief Notify pulse timestamps packet
+  \return false if there are no free TX buffers and packet should be sent later,
+          true if packet is sent or dropped because nobody listens
+ ----------------------------------------------------------------------------*/
+bool ble_ios_pulse_ts_transfer(const void *p_data, uint16_t len);
+#endif
+
 #endif // BLE_MAIN_H__
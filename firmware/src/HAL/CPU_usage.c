@@ -3,25 +3,96 @@
 #include "nrf_log_ctrl.h"
 
 #include "CPU_usage.h"
+#include "energy_model.h"
+#include "slack_timer.h"
+
+#define RTC_MASK    0x00FFFFFFul
 
 #if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+#include "scheduler.h"
 
 #define NRF_LOG_MODULE_NAME     "CPU_usage"
 #define NRF_LOG_LEVEL           3
 #define NRF_LOG_INFO_COLOR      5
 #include "nrf_log.h"
 
-APP_TIMER_DEF(timer);
+STATIC_ASSERT(SCHED_TASKS_TOTAL <= 0x10);
+STATIC_ASSERT((SCHED_TASKS_TOTAL + 1) * sizeof(uint16_t) <= CPU_USAGE_RECORD_MAX);
+STATIC_ASSERT((PROF_ISR_TOTAL + 1) * sizeof(uint16_t) <= CPU_USAGE_RECORD_MAX);
+STATIC_ASSERT(PROF_ISR_TOTAL <= 32);
+
+typedef struct
+{
+  uint32_t  calls;
+  uint32_t  work;
+} isr_stat_t;
+
+SLACK_TIMER_DEF(timer);
 uint32_t  loops;
 uint32_t  workTime;
 uint32_t  sleepTime;
 bool      onTimerEvt;
 
+static uint32_t   total_loops;
+static uint32_t   total_work;
+static uint32_t   total_sleep;
+static isr_stat_t isr_stat[PROF_ISR_TOTAL];
+static uint16_t   wakeup_cause[SCHED_TASKS_TOTAL + 1];  // the last one is wakeup without posted task
+static uint16_t   wakeup_isr[PROF_ISR_TOTAL + 1];       // wakeups without task, the last one is by not profiled interrupt
+static volatile uint32_t isr_served;                    // bit per prof_isr_t served since sleep
+
 //------------------------------------------------------------------------------
 static void OnTimerEvt(void* context)
 {
   onTimerEvt = true;
 }
+
+//------------------------------------------------------------------------------
+// wakeup is attributed to all tasks posted by interrupts while sleeping,
+// wakeup without task to all profiled interrupts served while sleeping
+static void wakeup_account(uint32_t isr)
+{
+  uint32_t pending = sched_GetPending();
+  if (pending == 0)
+  {
+    wakeup_cause[SCHED_TASKS_TOTAL]++;
+    if (isr == 0)
+    {
+      wakeup_isr[PROF_ISR_TOTAL]++;   // SoftDevice radio, RTC overflow and other not profiled ones
+    }
+    for (uint8_t i = 0; i < PROF_ISR_TOTAL; i++)
+    {
+      if (isr & (1ul << i))
+      {
+        wakeup_isr[i]++;
+      }
+    }
+    return;
+  }
+  for (uint8_t i = 0; i < SCHED_TASKS_TOTAL; i++)
+  {
+    if (pending & (1ul << i))
+    {
+      wakeup_cause[i]++;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void report(void)
+{
+  for (uint8_t i = 0; i < SCHED_TASKS_TOTAL; i++)
+  {
+    sched_stat_t stat;
+    sched_GetStat((sched_task_t)i, &stat);
+    NRF_LOG_INFO("task %d: runs %d work %d latency max %d wakeups %d\n",
+                  i, sched_GetRunCnt((sched_task_t)i), stat.work_ticks, stat.latency_max, wakeup_cause[i]);
+  }
+  for (uint8_t i = 0; i < PROF_ISR_TOTAL; i++)
+  {
+    NRF_LOG_INFO("isr %d: calls %d work %d wakeups %d\n", i, isr_stat[i].calls, isr_stat[i].work, wakeup_isr[i]);
+  }
+}
 #endif
 
 //------------------------------------------------------------------------------
@@ -51,10 +122,12 @@ static void pwr_mgmt_run(void)
 void CPU_usage_Startup(void)
 {
 #if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
-  ret_code_t error = app_timer_create(&timer, APP_TIMER_MODE_REPEATED, OnTimerEvt);
+  // report can be late by a period
+  ret_code_t error = slack_timer_create(&timer, APP_TIMER_MODE_REPEATED, OnTimerEvt,
+                                        MS_TO_TICK(CPU_USAGE_REPORT_PERIOD_MS));
   ASSERT(error == NRF_SUCCESS);
   onTimerEvt = false;
-  error = app_timer_start(timer, MS_TO_TICK(CPU_USAGE_REPORT_PERIOD_MS), NULL);
+  error = slack_timer_start(timer, MS_TO_TICK(CPU_USAGE_REPORT_PERIOD_MS), NULL);
   ASSERT(error == NRF_SUCCESS);
 #endif
 
@@ -66,24 +139,119 @@ void CPU_usage_Startup(void)
 //------------------------------------------------------------------------------
 void CPU_usage_Sleep(void)
 {
-#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+#if (defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR) || (defined(ENERGY_MODEL) && ENERGY_MODEL)
   static uint32_t tickBeforeSleep;
   static uint32_t tickAfterSleep;
   tickBeforeSleep = app_timer_cnt_get();
-  workTime += tickBeforeSleep - tickAfterSleep;
+  uint32_t work = (tickBeforeSleep - tickAfterSleep) & RTC_MASK;
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+  isr_served = 0;
+#endif
   pwr_mgmt_run();
   tickAfterSleep = app_timer_cnt_get();
-  sleepTime += tickAfterSleep - tickBeforeSleep;
+  ENRG_CPU_WORK(work);
+#endif
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+  uint32_t sleep = (tickAfterSleep - tickBeforeSleep) & RTC_MASK;
+  wakeup_account(isr_served);
+  workTime += work;
+  sleepTime += sleep;
+  total_work += work;
+  total_sleep += sleep;
+  total_loops++;
   loops++;
   if (onTimerEvt)
   {
+     static uint32_t runs_old;
+     uint32_t runs = 0;
+     for (uint8_t i = 0; i < SCHED_TASKS_TOTAL; i++)
+     {
+       runs += sched_GetRunCnt((sched_task_t)i);
+     }
      onTimerEvt = false;
      uint8_t duty =  (uint8_t)(100 * workTime / (workTime + sleepTime));
-     NRF_LOG_INFO("cycles %d. Duty %d [Work %d. Sleep %d]\n", loops, duty, workTime, sleepTime);
+     NRF_LOG_INFO("cycles %d, tasks %d. Duty %d [Work %d. Sleep %d]\n", loops, runs - runs_old, duty, workTime, sleepTime);
      loops = workTime = sleepTime = 0;
+     runs_old = runs;
+     report();
   }
-#else
+#elif !(defined(ENERGY_MODEL) && ENERGY_MODEL)
   pwr_mgmt_run();
 #endif
 }
 
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+//------------------------------------------------------------------------------
+uint32_t CPU_usage_IsrEnter(void)
+{
+  return app_timer_cnt_get();
+}
+
+//------------------------------------------------------------------------------
+void CPU_usage_IsrExit(prof_isr_t isr, uint32_t start)
+{
+  ASSERT(isr < PROF_ISR_TOTAL);
+  isr_stat[isr].calls++;
+  isr_stat[isr].work += (app_timer_cnt_get() - start) & RTC_MASK;
+  CRITICAL_REGION_ENTER();
+  isr_served |= 1ul << isr;     // nested handler can come between read and write
+  CRITICAL_REGION_EXIT();
+}
+
+//------------------------------------------------------------------------------
+uint8_t CPU_usage_GetRecord(uint8_t sel, uint8_t *dst)
+{
+  ASSERT(dst);
+  uint8_t idx = sel & 0x0F;
+  uint8_t len = 0;
+
+  switch (sel & 0xF0)
+  {
+    case CPU_USAGE_SEL_TASK:
+      if (idx < SCHED_TASKS_TOTAL)
+      {
+        sched_stat_t stat;
+        uint32_t runs = sched_GetRunCnt((sched_task_t)idx);
+        sched_GetStat((sched_task_t)idx, &stat);
+        memcpy(&dst[len], &runs, sizeof(runs));                   len += sizeof(runs);
+        memcpy(&dst[len], &stat.work_ticks, sizeof(uint32_t));    len += sizeof(uint32_t);
+        memcpy(&dst[len], &stat.latency_ticks, sizeof(uint32_t)); len += sizeof(uint32_t);
+        memcpy(&dst[len], &stat.latency_max, sizeof(uint16_t));   len += sizeof(uint16_t);
+      }
+      break;
+
+    case CPU_USAGE_SEL_ISR:
+      if (idx < PROF_ISR_TOTAL)
+      {
+        memcpy(dst, &isr_stat[idx], sizeof(isr_stat_t));
+        len = sizeof(isr_stat_t);
+      }
+      break;
+
+    case CPU_USAGE_SEL_WAKEUP:
+      if (idx == 0)
+      {
+        memcpy(dst, wakeup_cause, sizeof(wakeup_cause));
+        len = sizeof(wakeup_cause);
+      }
+      else if (idx == 1)
+      {
+        memcpy(dst, wakeup_isr, sizeof(wakeup_isr));
+        len = sizeof(wakeup_isr);
+      }
+      break;
+
+    case CPU_USAGE_SEL_TOTAL:
+      if (idx == 0)
+      {
+        memcpy(&dst[len], &total_loops, sizeof(uint32_t));  len += sizeof(uint32_t);
+        memcpy(&dst[len], &total_work, sizeof(uint32_t));   len += sizeof(uint32_t);
+        memcpy(&dst[len], &total_sleep, sizeof(uint32_t));  len += sizeof(uint32_t);
+      }
+      break;
+  }
+  ASSERT(len <= CPU_USAGE_RECORD_MAX);
+  return len;
+}
+#endif
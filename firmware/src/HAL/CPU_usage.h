@@ -1,7 +1,52 @@
 #ifndef CPU_USAGE_H
 #define CPU_USAGE_H
 
+#include <stdint.h>
+
+// Interrupts attributed by profiler
+typedef enum
+{
+  PROF_ISR_PULSE,       // GPIOTE pulse pin
+  PROF_ISR_LPCOMP,      // HV feedback comparator
+  PROF_ISR_HV_TIMER,    // TIMER1 HV cycle control
+  PROF_ISR_APP_TIMER,   // app_timer callbacks of application modules
+  PROF_ISR_SD_EVT,      // SoftDevice BLE and system events
+  PROF_ISR_TOTAL
+} prof_isr_t;
+
+// Diagnostic record selectors for CPU_usage_GetRecord()
+#define CPU_USAGE_SEL_TASK      0x00  // + sched_task_t: {runs u32, work u32, latency sum u32, latency max u16}
+#define CPU_USAGE_SEL_ISR       0x10  // + prof_isr_t: {calls u32, work u32}
+#define CPU_USAGE_SEL_WAKEUP    0x20  // +0: wakeups by posted task u16 each, then wakeups without task u16
+                                      // +1: wakeups without task by prof_isr_t u16 each, then by not profiled interrupt u16
+#define CPU_USAGE_SEL_TOTAL     0x30  // {wakeups u32, work u32, sleep u32}
+#define CPU_USAGE_RECORD_MAX    14
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+#define PROF_ISR_ENTER()        uint32_t prof_isr_start = CPU_usage_IsrEnter()
+#define PROF_ISR_EXIT(isr)      CPU_usage_IsrExit((isr), prof_isr_start)
+#else
+#define PROF_ISR_ENTER()
+#define PROF_ISR_EXIT(isr)
+#endif
+
 void CPU_usage_Startup(void);
 void CPU_usage_Sleep(void);
 
-#endif // CPU_USAGE_H
\ No newline at end of file
+/*! ---------------------------------------------------------------------------
+  \brief Interrupt profiling, use by PROF_ISR_ENTER() and PROF_ISR_EXIT() at handler borders
+  \details Time is in RTC ticks, so short handlers are measured statistically.
+           Nested interrupt time is counted by both handlers
+ ----------------------------------------------------------------------------*/
+uint32_t CPU_usage_IsrEnter(void);
+void CPU_usage_IsrExit(prof_isr_t isr, uint32_t start);
+
+/*! ---------------------------------------------------------------------------
+  \brief Get profile record, all counters run from start. Time is in RTC ticks (1/32768 s)
+  \param sel[in]  - CPU_USAGE_SEL_xxx
+  \param dst[out] - buffer of CPU_USAGE_RECORD_MAX bytes at least
+  \return record length, zero for unknown selector
+ ----------------------------------------------------------------------------*/
+uint8_t CPU_usage_GetRecord(uint8_t sel, uint8_t *dst);
+
+#endif // CPU_USAGE_H
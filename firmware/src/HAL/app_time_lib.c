@@ -1,6 +1,7 @@
 #include <sdk_common.h>
 #include "nrf_error.h"
 #include "nrf_assert.h"
+#include "app_util_platform.h"
 #include "app_timer.h"
 #include "nrf_drv_clock.h"
 #include "app_time_lib.h"
@@ -11,7 +12,11 @@
 
 #define MAX_RTC_COUNTER_VAL       0x00FFFFFF  // (inherit from app_timer.c) maximum value of the RTC counter
 #define HALF_RTC_COUNTER_VAL      (MAX_RTC_COUNTER_VAL / 2)
-#define APP_TIMER_OP_QUEUE_SIZE   6     // Size of timer operation queues.
+// Size of timer operation queues. Worst case is one RTC1 interrupt where RPW tick kicks
+// HV pump and restarts alarm sound (4), shared slack wakeup moves (2), HV work timer
+// starts steady pause that moves it again (2), note timer starts the next note (1),
+// pulse simulator and flash log poll restart (2): 11 operations
+#define APP_TIMER_OP_QUEUE_SIZE   16
 
 typedef struct
 {
@@ -105,10 +110,15 @@ bool app_time_Set_UTC(uint64_t utc_sec)
 }
 
 //------------------------------------------------------------------------------
+// refresh is read-modify-write of the time, it's shared with interrupts
 uint64_t app_time_Get_sys_time(void)
 {
+  uint64_t ticks;
+  CRITICAL_REGION_ENTER();
   refresh_64bit_value();
-  return app_time_s.time.ticks;
+  ticks = app_time_s.time.ticks;
+  CRITICAL_REGION_EXIT();
+  return ticks;
 }
 
 //------------------------------------------------------------------------------
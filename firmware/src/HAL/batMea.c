@@ -1,7 +1,8 @@
 #include "sdk_common.h"
 #include "nrf_drv_adc.h"
 #include "app_error.h"
-#include "sys_alive.h"
+#include "scheduler.h"
+#include "energy_model.h"
 
 #include "batMea.h"
 
@@ -30,7 +31,6 @@ static uint16_t mv = INVALID_BATT_VOLTAGE;
 static mea_state_t mea_state;
 static bat_cb_t cb = NULL;
 static void *ctx = NULL;
-static bool isMeaCompleted = false;
 
 //------------------------------------------------------------------------------
 //        PRIVATE FUNCTIONS
@@ -42,8 +42,7 @@ static void adc_event_handler(nrf_drv_adc_evt_t const * p_event)
     uint32_t voltage = (3600 * p_event->data.sample.sample) >> 10;
     mv = (uint16_t)voltage;
     NRF_LOG_INFO("Battery = %d mv\n", mv);
-    isMeaCompleted = true;
-    sleepLock();
+    sched_Post(SCHED_BAT);
   }
 }
 
@@ -60,6 +59,7 @@ void runmea(void)
 
   ret_code = nrf_drv_adc_sample_convert(&m_channel_config, NULL);
   APP_ERROR_CHECK(ret_code);
+  ENRG_CHARGE(ENRG_ADC, ENERGY_ADC_NC);
 }
 
 //-----------------------------------------------------------------------------
@@ -80,18 +80,15 @@ bool batMea_Start(bat_cb_t bat_cb, void *bat_ctx)
 }
 
 //-----------------------------------------------------------------------------
+// runs when measurement is completed
 void batMea_Process(void)
 {
-  if (isMeaCompleted)
+  if (cb)
   {
-    isMeaCompleted = false;
-    if (cb)
-    {
-      cb(mv, ctx);
-    }
-    cb = NULL;
-    ctx = NULL;
-    nrf_drv_adc_uninit();
-    mea_state = BAT_IDLE;
+    cb(mv, ctx);
   }
+  cb = NULL;
+  ctx = NULL;
+  nrf_drv_adc_uninit();
+  mea_state = BAT_IDLE;
 }
@@ -1,8 +1,9 @@
 #include <sdk_common.h>
 #include <nrf_drv_gpiote.h>
 #include "app_time_lib.h"
-#include "sys_alive.h"
-#include "ringbuf.h"
+#include "scheduler.h"
+#include "CPU_usage.h"
+#include "typed_queue.h"
 
 #include "button.h"
 
@@ -43,7 +44,7 @@ static ctx_t b_ctx[BUTTONS_TOTAL];
 static bool  is_timer_active;
 
 APP_TIMER_DEF(debounce_tmr);
-RING_BUF_DEF(btn_rb, QUEUE_SIZE);
+TQUEUE_DEF(btn_q, button_event_t, QUEUE_SIZE);
 
 // ----------------------------------------------------------------------------
 //    PRIVATE FUNCTION
@@ -93,10 +94,10 @@ static uint8_t getPinState(uint8_t n_btn)
 //-----------------------------------------------------------------------------
 static void event_to_queue(button_event_t event)
 {
-  if (ringbufPut(&btn_rb, (uint8_t*)&event, 1) == 1)
+  if (btn_q_push(&event))
   {
     NRF_LOG_DEBUG("%s: Event[btn# %d, state %d]\n", (uint32_t)__func__, event.field.button_num, event.field.pressed);
-    sleepLock();
+    sched_Post(SCHED_BUTTON);
   }
   else
   {
@@ -137,17 +138,22 @@ static void process(void)
 */
 static void OnTimerEvent(void * p_context)
 {
+  PROF_ISR_ENTER();
   process();
   for(uint8_t i = 0; i < BUTTONS_TOTAL; i++)
   {
     if (b_ctx[i].is_debounce)
+    {
       // keep takt timer only if even one switch has not stable state (until debounce time expired)
+      PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
       return;
+    }
   }
 
   ret_code_t error = app_timer_stop(debounce_tmr);
   ASSERT(error == NRF_SUCCESS);
   is_timer_active = false;
+  PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
 }
 
 //-----------------------------------------------------------------------------
@@ -179,7 +185,7 @@ void button_Init(void)
   error = app_timer_create(&debounce_tmr, APP_TIMER_MODE_REPEATED, OnTimerEvent);
   ASSERT(error == NRF_SUCCESS);
 
-  ringbufInit(&btn_rb);
+  btn_q_reset();
 }
 
 
@@ -203,20 +209,15 @@ void button_Startup(void)
 //-----------------------------------------------------------------------------
 void button_Process(void)
 {
-  uint8_t         m_next_handler;
   button_event_t  evt;
-  size_t  sz = sizeof( button_event_t);
 
-  do
+  while (btn_q_pop(&evt))
   {
-    m_next_handler = 0;
-    ret_code_t err_code = ringbufGet(&btn_rb, (uint8_t*)&evt, &sz);
-    while ((sz == sizeof(button_event_t)) && (m_next_handler < BUTTON_SECTION_VARS_COUNT))
+    for (uint8_t m_next_handler = 0; m_next_handler < BUTTON_SECTION_VARS_COUNT; m_next_handler++)
     {
       (*BUTTON_SECTION_VARS_GET(m_next_handler))(evt);
-      m_next_handler++;
     }
-  } while (sz == sizeof(button_event_t));
+  }
 }
 
 
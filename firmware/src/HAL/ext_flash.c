@@ -0,0 +1,197 @@
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_drv_spi.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+
+#include "ext_flash.h"
+
+#if defined(EXT_FLASH_LOG) && EXT_FLASH_LOG
+
+#define NRF_LOG_MODULE_NAME "xflash"
+#define NRF_LOG_LEVEL       3
+#include "nrf_log.h"
+
+#if !defined(FLASH_SCK_PIN) || !defined(FLASH_MOSI_PIN) || !defined(FLASH_MISO_PIN) || !defined(FLASH_CS_PIN)
+#error "External flash pins are not defined in pinmap.h"
+#endif
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#define CMD_READ            0x03
+#define CMD_PAGE_PROGRAM    0x02
+#define CMD_SECTOR_ERASE    0x20
+#define CMD_WRITE_ENABLE    0x06
+#define CMD_READ_STATUS     0x05
+#define CMD_READ_ID         0x9F
+#define CMD_DEEP_POWER_DOWN 0xB9
+#define CMD_RELEASE_DPD     0xAB
+
+#define STATUS_WIP          0x01
+#define JEDEC_ID_MX25V1635F 0x1523C2    // manufacturer C2, type 23, density 15 in read order
+#define T_RES1_US           35          // deep power-down release time
+#define SPI_MAX_CHUNK       255         // nRF51 SPI driver transfers uint8_t length
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+static const nrf_drv_spi_t spi = NRF_DRV_SPI_INSTANCE(0);
+static bool isSleep;
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+static void cs_select(void)
+{
+  nrf_gpio_pin_clear(FLASH_CS_PIN);
+}
+
+// ---------------------------------------------------------------------------
+static void cs_release(void)
+{
+  nrf_gpio_pin_set(FLASH_CS_PIN);
+}
+
+// ---------------------------------------------------------------------------
+// CS is driven manually because page program is longer than one SPI driver transfer
+static void spi_tx(const uint8_t *p_tx, size_t len)
+{
+  while (len)
+  {
+    uint8_t chunk = (uint8_t)MIN(len, SPI_MAX_CHUNK);
+    ret_code_t err_code = nrf_drv_spi_transfer(&spi, p_tx, chunk, NULL, 0);
+    APP_ERROR_CHECK(err_code);
+    p_tx += chunk;
+    len -= chunk;
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void spi_rx(uint8_t *p_rx, size_t len)
+{
+  while (len)
+  {
+    uint8_t chunk = (uint8_t)MIN(len, SPI_MAX_CHUNK);
+    ret_code_t err_code = nrf_drv_spi_transfer(&spi, NULL, 0, p_rx, chunk);
+    APP_ERROR_CHECK(err_code);
+    p_rx += chunk;
+    len -= chunk;
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void command(uint8_t cmd)
+{
+  cs_select();
+  spi_tx(&cmd, 1);
+  cs_release();
+}
+
+// ---------------------------------------------------------------------------
+static void command_addr(uint8_t cmd, uint32_t addr)
+{
+  uint8_t hdr[4] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+  spi_tx(hdr, sizeof(hdr));
+}
+
+// ---------------------------------------------------------------------------
+static void wakeup(void)
+{
+  if (isSleep)
+  {
+    command(CMD_RELEASE_DPD);
+    nrf_delay_us(T_RES1_US);
+    isSleep = false;
+  }
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+ret_code_t extFlash_Init(void)
+{
+  nrf_gpio_pin_set(FLASH_CS_PIN);
+  nrf_gpio_cfg_output(FLASH_CS_PIN);
+
+  nrf_drv_spi_config_t spi_config = NRF_DRV_SPI_DEFAULT_CONFIG;
+  spi_config.ss_pin   = NRF_DRV_SPI_PIN_NOT_USED;
+  spi_config.sck_pin  = FLASH_SCK_PIN;
+  spi_config.mosi_pin = FLASH_MOSI_PIN;
+  spi_config.miso_pin = FLASH_MISO_PIN;
+  spi_config.frequency = NRF_DRV_SPI_FREQ_8M;
+  ret_code_t err_code = nrf_drv_spi_init(&spi, &spi_config, NULL);  // blocking mode
+  APP_ERROR_CHECK(err_code);
+
+  // chip can be in deep power-down after MCU reset
+  isSleep = true;
+  wakeup();
+
+  uint8_t cmd = CMD_READ_ID;
+  uint32_t id = 0;
+  cs_select();
+  spi_tx(&cmd, 1);
+  spi_rx((uint8_t*)&id, 3);
+  cs_release();
+  NRF_LOG_INFO("JEDEC ID 0x%06X\n", id);
+  return (id == JEDEC_ID_MX25V1635F) ? NRF_SUCCESS : NRF_ERROR_NOT_FOUND;
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Read(uint32_t addr, void *p_data, size_t len)
+{
+  ASSERT(addr + len <= EXT_FLASH_SIZE);
+  wakeup();
+  cs_select();
+  command_addr(CMD_READ, addr);
+  spi_rx((uint8_t*)p_data, len);
+  cs_release();
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Program(uint32_t addr, const void *p_data, size_t len)
+{
+  ASSERT((addr % EXT_FLASH_PAGE_SIZE) + len <= EXT_FLASH_PAGE_SIZE);
+  wakeup();
+  command(CMD_WRITE_ENABLE);
+  cs_select();
+  command_addr(CMD_PAGE_PROGRAM, addr);
+  spi_tx((const uint8_t*)p_data, len);
+  cs_release();
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_SectorErase(uint32_t addr)
+{
+  ASSERT(addr < EXT_FLASH_SIZE);
+  wakeup();
+  command(CMD_WRITE_ENABLE);
+  cs_select();
+  command_addr(CMD_SECTOR_ERASE, addr);
+  cs_release();
+}
+
+// ---------------------------------------------------------------------------
+bool extFlash_IsBusy(void)
+{
+  uint8_t cmd = CMD_READ_STATUS;
+  uint8_t status;
+  wakeup();
+  cs_select();
+  spi_tx(&cmd, 1);
+  spi_rx(&status, 1);
+  cs_release();
+  return (status & STATUS_WIP) != 0;
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Sleep(void)
+{
+  if (!isSleep)
+  {
+    command(CMD_DEEP_POWER_DOWN);
+    isSleep = true;
+  }
+}
+
+#endif // EXT_FLASH_LOG
@@ -0,0 +1,49 @@
+#ifndef EXT_FLASH_H
+#define EXT_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdk_errors.h"
+
+/*!
+ * \brief MX25V1635F 16 Mbit SPI NOR flash driver.
+ * Operations are blocking only for SPI transfer. Program and erase run inside the chip,
+ * so caller polls extFlash_IsBusy() instead of waiting.
+ * Chip is left in deep power-down by extFlash_Sleep() between uses and is woken up automatically.
+ */
+#define EXT_FLASH_SIZE          (2ul * 1024 * 1024)
+#define EXT_FLASH_SECTOR_SIZE   4096u
+#define EXT_FLASH_PAGE_SIZE     256u
+
+/*! ---------------------------------------------------------------------------
+  \brief SPI and CS pin init, check JEDEC ID
+  \return NRF_SUCCESS or NRF_ERROR_NOT_FOUND if chip doesn't answer
+ ----------------------------------------------------------------------------*/
+ret_code_t extFlash_Init(void);
+
+void extFlash_Read(uint32_t addr, void *p_data, size_t len);
+
+/*! ---------------------------------------------------------------------------
+  \brief Start page program
+  \details Data must not cross page boundary. Only 1->0 bits change, so already
+           programmed bytes of the page can't be written again before erase
+ ----------------------------------------------------------------------------*/
+void extFlash_Program(uint32_t addr, const void *p_data, size_t len);
+
+/*! ---------------------------------------------------------------------------
+  \brief Start 4K sector erase
+ ----------------------------------------------------------------------------*/
+void extFlash_SectorErase(uint32_t addr);
+
+/*! ---------------------------------------------------------------------------
+  \brief Check that program or erase is in progress
+ ----------------------------------------------------------------------------*/
+bool extFlash_IsBusy(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Enter deep power-down mode
+ ----------------------------------------------------------------------------*/
+void extFlash_Sleep(void);
+
+#endif // EXT_FLASH_H
@@ -0,0 +1,190 @@
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_assert.h"
+#include "app_util_platform.h"
+#include "app_time_lib.h"
+
+#include "slack_timer.h"
+
+#if defined(TIMER_SLACK) && TIMER_SLACK
+
+#define MAX_WAKE_TICKS      0x007FFFFF  // half of RTC range, longer waits are done in steps
+
+// ----------------------------------------------------------------------------
+APP_TIMER_DEF(wake_tmr);
+static slack_timer_t  *p_head;
+static bool           is_dispatching;   // timers are rescheduled once after all handlers
+static uint64_t       wake_due = UINT64_MAX;  // deadline wake_tmr runs to, UINT64_MAX if stopped
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+/*! ---------------------------------------------------------------------------
+  \brief Set wakeup to the nearest latest deadline
+  \details All timers expired by that moment are served in the same wakeup.
+           wake_tmr is touched only when the nearest deadline changes, so a burst
+           of starts and stops doesn't fill app_timer operation queue.
+           Runs in critical region
+ ----------------------------------------------------------------------------*/
+static void schedule(void)
+{
+  uint64_t wake = UINT64_MAX;
+  for (slack_timer_t *p_tmr = p_head; p_tmr; p_tmr = p_tmr->p_next)
+  {
+    if (p_tmr->is_running)
+    {
+      wake = MIN(wake, p_tmr->due + p_tmr->slack);
+    }
+  }
+
+  if (wake == wake_due)
+  {
+    return;
+  }
+
+  ret_code_t err_code;
+  if (wake_due != UINT64_MAX)
+  {
+    err_code = app_timer_stop(wake_tmr);
+    APP_ERROR_CHECK(err_code);
+  }
+  wake_due = wake;
+  if (wake == UINT64_MAX)
+  {
+    return;
+  }
+
+  uint64_t now = app_time_Get_sys_time();
+  uint64_t ticks = (wake > now) ? wake - now : 0;
+  ticks = MAX(ticks, APP_TIMER_MIN_TIMEOUT_TICKS);
+  ticks = MIN(ticks, MAX_WAKE_TICKS);
+  err_code = app_timer_start(wake_tmr, (uint32_t)ticks, NULL);
+  APP_ERROR_CHECK(err_code);
+}
+
+// ----------------------------------------------------------------------------
+// invokes handlers of all expired timers
+static void OnWakeTmr(void* context)
+{
+  (void)context;
+  uint64_t now = app_time_Get_sys_time();
+  CRITICAL_REGION_ENTER();
+  wake_due = UINT64_MAX;              // single shot wake_tmr is stopped by expiration
+  is_dispatching = true;
+  CRITICAL_REGION_EXIT();
+
+  for (slack_timer_t *p_tmr = p_head; p_tmr; p_tmr = p_tmr->p_next)
+  {
+    bool is_expired;
+    CRITICAL_REGION_ENTER();
+    is_expired = p_tmr->is_running && (p_tmr->due <= now);
+    if (is_expired)
+    {
+      if (p_tmr->mode == APP_TIMER_MODE_REPEATED)
+      {
+        p_tmr->due += p_tmr->period;
+        if (p_tmr->due <= now)
+        {
+          p_tmr->due = now + p_tmr->period;   // periods are lost, don't catch up
+        }
+      }
+      else
+      {
+        p_tmr->is_running = false;
+      }
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (is_expired)
+    {
+      p_tmr->handler(p_tmr->p_context);
+    }
+  }
+
+  CRITICAL_REGION_ENTER();
+  is_dispatching = false;
+  schedule();
+  CRITICAL_REGION_EXIT();
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void slack_timer_Init(void)
+{
+  ret_code_t err_code = app_timer_create(&wake_tmr, APP_TIMER_MODE_SINGLE_SHOT, OnWakeTmr);
+  APP_ERROR_CHECK(err_code);
+}
+
+// ----------------------------------------------------------------------------
+ret_code_t slack_timer_create(slack_timer_id_t const *p_id, app_timer_mode_t mode,
+                              app_timer_timeout_handler_t handler, uint32_t slack)
+{
+  ASSERT(p_id && *p_id && handler);
+  slack_timer_t *p_tmr = *p_id;
+  ret_code_t ret_code = NRF_SUCCESS;
+
+  CRITICAL_REGION_ENTER();
+  bool is_listed = false;
+  for (slack_timer_t *p_item = p_head; p_item; p_item = p_item->p_next)
+  {
+    is_listed |= (p_item == p_tmr);
+  }
+
+  if (is_listed && p_tmr->is_running)
+  {
+    ret_code = NRF_ERROR_INVALID_STATE;   // like app_timer, running timer can't be recreated
+  }
+  else
+  {
+    p_tmr->handler = handler;
+    p_tmr->slack = slack;
+    p_tmr->mode = mode;
+    p_tmr->is_running = false;
+    if (!is_listed)                       // insert once, the second insert would loop the list
+    {
+      p_tmr->p_next = p_head;
+      p_head = p_tmr;
+    }
+  }
+  CRITICAL_REGION_EXIT();
+  return ret_code;
+}
+
+// ----------------------------------------------------------------------------
+ret_code_t slack_timer_start(slack_timer_id_t id, uint32_t ticks, void *p_context)
+{
+  ASSERT(id && id->handler);
+  if (ticks < APP_TIMER_MIN_TIMEOUT_TICKS)
+  {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+
+  CRITICAL_REGION_ENTER();
+  id->due = app_time_Get_sys_time() + ticks;
+  id->period = ticks;
+  id->p_context = p_context;
+  id->is_running = true;
+  if (!is_dispatching)
+  {
+    schedule();
+  }
+  CRITICAL_REGION_EXIT();
+  return NRF_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+ret_code_t slack_timer_stop(slack_timer_id_t id)
+{
+  ASSERT(id);
+  CRITICAL_REGION_ENTER();
+  id->is_running = false;
+  if (!is_dispatching)
+  {
+    schedule();
+  }
+  CRITICAL_REGION_EXIT();
+  return NRF_SUCCESS;
+}
+
+#endif // TIMER_SLACK
@@ -0,0 +1,69 @@
+#ifndef SLACK_TIMER_H
+#define SLACK_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_timer.h"
+
+#if defined(TIMER_SLACK) && TIMER_SLACK
+typedef struct slack_timer_s
+{
+  struct slack_timer_s        *p_next;
+  app_timer_timeout_handler_t handler;
+  void                        *p_context;
+  uint64_t                    due;        // the earliest expiry in system ticks
+  uint32_t                    period;
+  uint32_t                    slack;      // expiry can be delayed by it
+  app_timer_mode_t            mode;
+  bool                        is_running;
+} slack_timer_t;
+
+typedef slack_timer_t* slack_timer_id_t;
+
+#define SLACK_TIMER_DEF(id)                   \
+  static slack_timer_t id##_data;             \
+  static const slack_timer_id_t id = &id##_data
+
+/*! ---------------------------------------------------------------------------
+  \brief Slack timers init
+  \details Slack timers are app_timer ones which declare how late they can expire.
+           All of them are served by one app_timer: it's set to the nearest latest
+           deadline and handlers of all expired timers are invoked together, so
+           periodic timers share wakeups. Handlers run in app_timer context as usual.
+           Must be called after app_time_Init()
+ ----------------------------------------------------------------------------*/
+void slack_timer_Init(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Create slack timer
+  \param p_id[in]    - timer defined by SLACK_TIMER_DEF
+  \param mode[in]    - single shot or repeated
+  \param handler[in] - expiry handler
+  \param slack[in]   - ticks the expiry can be delayed by
+
+  \details Timer can be created again with new parameters while it's stopped
+  \return NRF_SUCCESS or NRF_ERROR_INVALID_STATE if timer is running
+ ----------------------------------------------------------------------------*/
+ret_code_t slack_timer_create(slack_timer_id_t const *p_id, app_timer_mode_t mode,
+                              app_timer_timeout_handler_t handler, uint32_t slack);
+
+/*! ---------------------------------------------------------------------------
+  \brief Start or restart slack timer
+  \details Repeated timer keeps its nominal period, slack doesn't accumulate.
+           Can be invoked from interrupt
+ ----------------------------------------------------------------------------*/
+ret_code_t slack_timer_start(slack_timer_id_t id, uint32_t ticks, void *p_context);
+
+ret_code_t slack_timer_stop(slack_timer_id_t id);
+
+#else
+// without TIMER_SLACK every slack timer is plain app_timer
+typedef app_timer_id_t slack_timer_id_t;
+
+#define SLACK_TIMER_DEF(id)                                 APP_TIMER_DEF(id)
+#define slack_timer_create(p_id, mode, handler, slack)      app_timer_create((p_id), (mode), (handler))
+#define slack_timer_start(id, ticks, p_context)             app_timer_start((id), (ticks), (p_context))
+#define slack_timer_stop(id)                                app_timer_stop(id)
+#endif // TIMER_SLACK
+
+#endif	// SLACK_TIMER_H
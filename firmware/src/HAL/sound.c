@@ -2,12 +2,17 @@
 #include "nrf_log_ctrl.h"
 #include "nrf_drv_timer.h"
 #include "Timer_anomaly_fix.h"
+#include "CPU_usage.h"
+#include "energy_model.h"
 #include "nrf_drv_gpiote.h"
 #include "nrf_drv_ppi.h"
 #include "nrf_drv_common.h"
 #include "app_time_lib.h"
 
 #include "sound.h"
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+#include "particle_cnt.h"
+#endif
 
 #define NRF_LOG_MODULE_NAME "Sound"
 #include "nrf_log.h"
@@ -22,6 +27,10 @@ static nrf_ppi_channel_t ppi_A, ppi_B;
 static uint16_t   curr_note_play;
 static uint16_t   notes_total;
 static bool isPause;
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+static bool isPlaying;    // TIMER2 and buzzer GPIOTE channels are taken from pulse counter
+static void sound_hw_release(void);
+#endif
 static const sound_note_t *p_seq;
 
 static const sound_note_t hello[] =
@@ -79,6 +88,7 @@ static void note_play_start(uint16_t freq, uint32_t duration)
     frequency_set(freq);
     timer_anomaly_fix(tone_tmr.p_reg, 1);
     nrf_drv_timer_enable(&tone_tmr);
+    ENRG_CHARGE(ENRG_SOUND, duration * ENERGY_BUZZER_UA);   // note may be cut by next melody
   }
   else
   {
@@ -92,6 +102,7 @@ static void note_play_start(uint16_t freq, uint32_t duration)
 // ----------------------------------------------------------------------------
 static void OnNoteTmr(void* context)
 {
+  PROF_ISR_ENTER();
   (void)context;
 
   if (isPause == false)
@@ -105,6 +116,13 @@ static void OnNoteTmr(void* context)
   {
     note_play_start(p_seq[curr_note_play].freq, p_seq[curr_note_play].duration);
   }
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  else
+  {
+    sound_hw_release();
+  }
+#endif
+  PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
 }
 
 
@@ -171,6 +189,19 @@ static void bind_gpio_to_timer(void)
   ASSERT(err_code == NRF_SUCCESS);
 }
 
+// ---------------------------------------------------------------------------
+static void output_enable(void)
+{
+  ret_code_t err_code = nrf_drv_ppi_channel_enable(ppi_A);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  err_code = nrf_drv_ppi_channel_enable(ppi_B);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  nrf_drv_gpiote_out_task_enable(BUZZER_PIN_A);
+  nrf_drv_gpiote_out_task_enable(BUZZER_PIN_B);
+}
+
 // ---------------------------------------------------------------------------
 static void note_delay_timer_init(void)
 {
@@ -178,10 +209,63 @@ static void note_delay_timer_init(void)
   ASSERT(err_code == NRF_SUCCESS);
 }
 
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+/*! ---------------------------------------------------------------------------
+  \brief Take TIMER2, buzzer GPIOTE channels and PPI from pulse counter for melody
+ ----------------------------------------------------------------------------*/
+static void sound_hw_acquire(void)
+{
+  particle_cnt_HwCounterBlock(true);
+  toneTimer_init();
+  sound_gpio_init();
+  bind_gpio_to_timer();
+  output_enable();
+  isPlaying = true;
+}
+
+/*! ---------------------------------------------------------------------------
+  \brief Give TIMER2 and GPIOTE channels back to pulse counter after last note
+ ----------------------------------------------------------------------------*/
+static void sound_hw_release(void)
+{
+  ret_code_t err_code = nrf_drv_ppi_channel_disable(ppi_A);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  err_code = nrf_drv_ppi_channel_disable(ppi_B);
+  ASSERT(err_code == NRF_SUCCESS);
+
+  nrf_drv_gpiote_out_task_disable(BUZZER_PIN_A);
+  nrf_drv_gpiote_out_task_disable(BUZZER_PIN_B);
+  nrf_drv_gpiote_out_uninit(BUZZER_PIN_A);
+  nrf_drv_gpiote_out_uninit(BUZZER_PIN_B);
+  nrf_drv_timer_uninit(&tone_tmr);
+  isPlaying = false;
+  particle_cnt_HwCounterBlock(false);
+}
+#endif
+
 // ----------------------------------------------------------------------------
 static void play(const sound_note_t *sequence, uint16_t seq_long)
 {
   ASSERT(seq_long > 0);
+#if defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER
+  if (isPlaying)
+  {
+    // new melody interrupts current one. Resources are already taken
+    ret_code_t err_code = app_timer_stop(note_delay_tmr);
+    ASSERT(err_code == NRF_SUCCESS);
+    if (isPause == false)
+    {
+      nrf_drv_timer_disable(&tone_tmr);
+      timer_anomaly_fix(tone_tmr.p_reg, 0);
+    }
+    isPause = false;
+  }
+  else
+  {
+    sound_hw_acquire();
+  }
+#endif
   p_seq = sequence;
   notes_total = seq_long;
   curr_note_play = 0;
@@ -193,23 +277,21 @@ static void play(const sound_note_t *sequence, uint16_t seq_long)
 void sound_Init(void)
 {
   note_delay_timer_init();
+  sound_ppi_init();
+#if !(defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER)
   toneTimer_init();
   sound_gpio_init();
-  sound_ppi_init();
   bind_gpio_to_timer();
+#endif
 }
 
 // ----------------------------------------------------------------------------
 void sound_Startup(void)
 {
-  ret_code_t err_code = nrf_drv_ppi_channel_enable(ppi_A);
-  ASSERT(err_code == NRF_SUCCESS);
-
-  err_code = nrf_drv_ppi_channel_enable(ppi_B);
-  ASSERT(err_code == NRF_SUCCESS);
-
-  nrf_drv_gpiote_out_task_enable(BUZZER_PIN_A);
-  nrf_drv_gpiote_out_task_enable(BUZZER_PIN_B);
+#if !(defined(PULSE_HW_COUNTER) && PULSE_HW_COUNTER)
+  output_enable();
+#endif
+  // else resources are taken in play() and released after last note
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+#include <sdk_common.h>
+#include <nrf_assert.h>
+#include "fixmath.h"
+
+#define FX_FRAC_BITS    16
+#define MANT_ONE        (1ul << 30)   // 1.0 for mantissa in Q30
+#define MANT_TWO        (1ul << 31)   // 2.0 for mantissa in Q30
+
+// e^k in Q16, k = 0...10
+static const uint32_t exp_int_q16[] =
+{
+  65536, 178145, 484249, 1316326, 3578144, 9726405,
+  26439109, 71868951, 195360063, 531043708, 1443526462,
+};
+
+//-----------------------------------------------------------------------------
+//   PUBLIC FUNCTIONS
+//-----------------------------------------------------------------------------
+uint32_t fx_log2_q16(uint32_t x)
+{
+  ASSERT(x);
+  uint32_t integer = 31;
+  while ((x & 0x80000000ul) == 0)
+  {
+    x <<= 1;
+    integer--;
+  }
+
+  // x is normalized now in range [1.0 ... 2.0) Q31. Take it to Q30
+  uint32_t mant = x >> 1;
+  uint32_t result = integer << FX_FRAC_BITS;
+
+  for (uint32_t bit = 1ul << (FX_FRAC_BITS - 1); bit; bit >>= 1)
+  {
+    mant = (uint32_t)(((uint64_t)mant * mant) >> 30);
+    if (mant >= MANT_TWO)
+    {
+      mant >>= 1;
+      result |= bit;
+    }
+  }
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t fx_exp_q16(uint32_t x)
+{
+  ASSERT(x < FX_EXP_MAX_ARG_Q16);
+  uint32_t frac = x & (FX_Q16_ONE - 1);
+  uint32_t term = FX_Q16_ONE;
+  uint32_t sum = FX_Q16_ONE;
+
+  // frac < 1.0 so the terms fall quickly, 8-9 steps for full Q16 precision
+  for (uint32_t i = 1; term; i++)
+  {
+    term = (uint32_t)(((uint64_t)term * frac) >> FX_FRAC_BITS) / i;
+    sum += term;
+  }
+  return (uint32_t)(((uint64_t)sum * exp_int_q16[x >> FX_FRAC_BITS]) >> FX_FRAC_BITS);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t fx_isqrt(uint32_t x)
+{
+  uint32_t result = 0;
+  uint32_t bit = 1ul << 30;
+
+  while (bit > x)
+  {
+    bit >>= 2;
+  }
+  while (bit)
+  {
+    if (x >= result + bit)
+    {
+      x -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
@@ -0,0 +1,44 @@
+#ifndef FIXMATH_H__
+#define FIXMATH_H__
+
+#include <stdint.h>
+
+/*!
+ * \brief Small fixed point helpers for code that must not pull float into the M0 image.
+ * Q16 means unsigned value with 16 fractional bits (1.0 == 0x10000).
+ */
+#define FX_Q16_ONE      0x10000u
+#define FX_LN2_Q16      45426u      // ln(2) in Q16
+
+/*! ---------------------------------------------------------------------------
+  \brief Binary logarithm
+  \details Uses the bit-by-bit squaring method, 16 iterations of 64-bit multiply.
+           It isn't intended for a per-pulse path.
+
+  \param x[in] - argument, must be not zero
+
+  \return log2(x) in Q16
+ ----------------------------------------------------------------------------*/
+uint32_t fx_log2_q16(uint32_t x);
+
+#define FX_EXP_MAX_ARG_Q16  (11ul << 16)  // e^11 in Q16 doesn't fit into 32 bits
+
+/*! ---------------------------------------------------------------------------
+  \brief Natural exponent
+  \details Integer part is taken from table, fractional part by Taylor series.
+
+  \param x[in] - argument in Q16, less than FX_EXP_MAX_ARG_Q16
+
+  \return e^x in Q16
+ ----------------------------------------------------------------------------*/
+uint32_t fx_exp_q16(uint32_t x);
+
+/*! ---------------------------------------------------------------------------
+  \brief Integer square root
+  \details Bit by bit method, 16 iterations without multiply
+
+  \return floor(sqrt(x))
+ ----------------------------------------------------------------------------*/
+uint32_t fx_isqrt(uint32_t x);
+
+#endif // FIXMATH_H__
@@ -59,6 +59,9 @@ size_t ringbufPut(ringbuf_t const * p_ringbuf, uint8_t *p_data, size_t length)
 {
   ASSERT(p_ringbuf);
   ASSERT(p_data);
+  if (p_ringbuf->data->openedWrSize)
+    return 0;
+
   size_t qtt = ringbufGetFree(p_ringbuf);
   size_t processed = 0;
   if (length < qtt)   qtt = length;
@@ -142,6 +145,47 @@ ret_code_t ringbufOpenDirectRead(ringbuf_t const *p_ringbuf, uint8_t **pp_data,
   return NRF_SUCCESS; 
 }
 
+//-----------------------------------------------------------------------------
+ret_code_t ringbufOpenDirectReadSeg(ringbuf_t const *p_ringbuf, ringbuf_seg_t seg[2])
+{
+  ASSERT(p_ringbuf);
+  ASSERT(seg);
+
+  if (p_ringbuf->data->openedSize)
+    return NRF_ERROR_BUSY;
+
+  size_t qtt = ringbufGetFull(p_ringbuf);
+
+  uint8_t *bufEnd =  p_ringbuf->p_buffer + p_ringbuf->bufsize;
+  seg[0].p_data = p_ringbuf->data->tail;
+  seg[0].size = MIN((size_t)(bufEnd - p_ringbuf->data->tail), qtt);
+  seg[1].p_data = p_ringbuf->p_buffer;
+  seg[1].size = qtt - seg[0].size;
+
+  p_ringbuf->data->openedSize = qtt;
+  return NRF_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+ret_code_t ringbufPeek(ringbuf_t const *p_ringbuf, size_t offset, uint8_t **pp_data, size_t *p_size)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(pp_data);
+  ASSERT(p_size);
+
+  size_t qtt = ringbufGetFull(p_ringbuf);
+  if (offset > qtt)
+    return NRF_ERROR_INVALID_PARAM;
+
+  uint8_t *pos = modulo(p_ringbuf, p_ringbuf->data->tail + offset);
+  uint8_t *bufEnd =  p_ringbuf->p_buffer + p_ringbuf->bufsize;
+  size_t  partSize = bufEnd - pos;
+
+  *p_size = MIN(partSize, qtt - offset);
+  *pp_data = pos;
+  return NRF_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 void ringbufApplyRead(ringbuf_t const *p_ringbuf, size_t size)
 {
@@ -151,17 +195,156 @@ void ringbufApplyRead(ringbuf_t const *p_ringbuf, size_t size)
 
   p_ringbuf->data->openedSize = 0;
 
+  if (size == 0)
+    return;   // only close. Full buffer has head == tail too
+
   p_ringbuf->data->tail = modulo(p_ringbuf, p_ringbuf->data->tail + size);
   if (p_ringbuf->data->head == p_ringbuf->data->tail)
       p_ringbuf->data->state = BUF_EMPTY;
 }
 
+//-----------------------------------------------------------------------------
+ret_code_t ringbufOpenDirectWrite(ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_size)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(pp_data);
+  ASSERT(p_size);
+
+  if (p_ringbuf->data->openedWrSize)
+    return NRF_ERROR_BUSY;
+
+  size_t qtt = ringbufGetFree(p_ringbuf);
+
+  uint8_t *bufEnd =  p_ringbuf->p_buffer + p_ringbuf->bufsize;
+  size_t  partSize = bufEnd - p_ringbuf->data->head;
+
+  *p_size = p_ringbuf->data->openedWrSize = MIN(partSize, qtt);
+  *pp_data = p_ringbuf->data->head;
+  return NRF_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+ret_code_t ringbufOpenDirectWriteSeg(ringbuf_t const *p_ringbuf, ringbuf_seg_t seg[2])
+{
+  ASSERT(p_ringbuf);
+  ASSERT(seg);
+
+  if (p_ringbuf->data->openedWrSize)
+    return NRF_ERROR_BUSY;
+
+  size_t qtt = ringbufGetFree(p_ringbuf);
+
+  uint8_t *bufEnd =  p_ringbuf->p_buffer + p_ringbuf->bufsize;
+  seg[0].p_data = p_ringbuf->data->head;
+  seg[0].size = MIN((size_t)(bufEnd - p_ringbuf->data->head), qtt);
+  seg[1].p_data = p_ringbuf->p_buffer;
+  seg[1].size = qtt - seg[0].size;
+
+  p_ringbuf->data->openedWrSize = qtt;
+  return NRF_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void ringbufApplyWrite(ringbuf_t const *p_ringbuf, size_t size)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(p_ringbuf->data);
+  ASSERT(size <= p_ringbuf->data->openedWrSize);
+
+  p_ringbuf->data->openedWrSize = 0;
+
+  if (size == 0)
+    return;   // only close. Empty buffer has head == tail too
+
+  p_ringbuf->data->head = modulo(p_ringbuf, p_ringbuf->data->head + size);
+  if (p_ringbuf->data->head == p_ringbuf->data->tail)
+      p_ringbuf->data->state = BUF_FULL;
+}
+
 //-----------------------------------------------------------------------------
 void ringbufReset(ringbuf_t const *p_ringbuf)
 {
   p_ringbuf->data->head = p_ringbuf->data->tail = p_ringbuf->p_buffer;
   p_ringbuf->data->state = BUF_EMPTY;
   p_ringbuf->data->openedSize = 0;
+  p_ringbuf->data->openedWrSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+void spscRingbufInit(spsc_ringbuf_t const *p_ringbuf)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(IS_POWER_OF_TWO(p_ringbuf->bufsize));
+  p_ringbuf->data->wr = p_ringbuf->data->rd = 0;
+}
+
+//-----------------------------------------------------------------------------
+size_t spscRingbufGetFull(spsc_ringbuf_t const *p_ringbuf)
+{
+  ASSERT(p_ringbuf);
+  return p_ringbuf->data->wr - p_ringbuf->data->rd;
+}
+
+//-----------------------------------------------------------------------------
+size_t spscRingbufGetFree(spsc_ringbuf_t const *p_ringbuf)
+{
+  return p_ringbuf->bufsize - spscRingbufGetFull(p_ringbuf);
+}
+
+//-----------------------------------------------------------------------------
+size_t spscRingbufPut(spsc_ringbuf_t const *p_ringbuf, const uint8_t *p_data, size_t length)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(p_data);
+  uint32_t wr = p_ringbuf->data->wr;
+  uint32_t rd = p_ringbuf->data->rd;  // read once, MIN() evaluates arguments twice
+  uint32_t pos = wr & (p_ringbuf->bufsize - 1);
+  size_t qtt = MIN(length, p_ringbuf->bufsize - (wr - rd));
+  size_t partSize = MIN(qtt, p_ringbuf->bufsize - pos);
+
+  __DMB();  // consumer has finished reading released space
+  memcpy(p_ringbuf->p_buffer + pos, p_data, partSize);
+  memcpy(p_ringbuf->p_buffer, p_data + partSize, qtt - partSize);
+  __DMB();  // data is written before it is published
+  p_ringbuf->data->wr = wr + qtt;
+  return qtt;
+}
+
+//-----------------------------------------------------------------------------
+size_t spscRingbufPeek(spsc_ringbuf_t const *p_ringbuf, size_t offset, uint8_t *p_data, size_t length)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(p_data);
+  uint32_t rd = p_ringbuf->data->rd;
+  size_t full = p_ringbuf->data->wr - rd;
+  if (offset >= full)
+    return 0;
+
+  uint32_t pos = (rd + offset) & (p_ringbuf->bufsize - 1);
+  size_t qtt = MIN(length, full - offset);
+  size_t partSize = MIN(qtt, p_ringbuf->bufsize - pos);
+
+  __DMB();  // published index is read before data
+  memcpy(p_data, p_ringbuf->p_buffer + pos, partSize);
+  memcpy(p_data + partSize, p_ringbuf->p_buffer, qtt - partSize);
+  return qtt;
+}
+
+//-----------------------------------------------------------------------------
+void spscRingbufRelease(spsc_ringbuf_t const *p_ringbuf, size_t length)
+{
+  ASSERT(p_ringbuf);
+  ASSERT(length <= spscRingbufGetFull(p_ringbuf));
+  __DMB();  // data is read before space is given back to producer
+  p_ringbuf->data->rd += length;
+}
+
+//-----------------------------------------------------------------------------
+size_t spscRingbufGet(spsc_ringbuf_t const *p_ringbuf, uint8_t *p_data, size_t length)
+{
+  size_t qtt = spscRingbufPeek(p_ringbuf, 0, p_data, length);
+  spscRingbufRelease(p_ringbuf, qtt);
+  return qtt;
 }
 
 //-----------------------------------------------------------------------------
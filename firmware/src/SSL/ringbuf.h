@@ -18,8 +18,18 @@ typedef struct
   uint8_t   *tail;
   uint8_t   state;  //0-Empty, 1=full
   size_t    openedSize;
+  size_t    openedWrSize;
 } ringbuf_data_t;
 
+/**
+ * @brief Contiguous part of ring buffer memory.
+ * */
+typedef struct
+{
+  uint8_t   *p_data;
+  size_t    size;
+} ringbuf_seg_t;
+
 /**
  * @brief Ring buffer instance structure.
  * */
@@ -58,7 +68,7 @@ void ringbufInit(ringbuf_t const *p_ringbuf);
  * @param[in] p_data         Pointer to data to store.
  * @param[in] length         Length of data block to store.
  *
- * @retval Amount of really putted bytes to ringbuf.
+ * @retval Amount of really putted bytes to ringbuf. Zero if application has direct access to write.
  * */
 size_t ringbufPut(ringbuf_t const * p_ringbuf, uint8_t *p_data, size_t length);
 
@@ -87,8 +97,73 @@ ret_code_t ringbufGet(ringbuf_t const *p_ringbuf, uint8_t *p_data, size_t *p_siz
   */
 ret_code_t ringbufOpenDirectRead(ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_size);
 
+/**
+ * Function for open internal buffer to getting data from both sides of buffer end.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[out]    seg           Function puts here stored data. The second segment starts at buffer
+ *                              beginning and has zero size if data doesn't wrap. Only for reading.
+ *
+ * @retval  NFR_ERROR_BUSU - if application have direct access to read and didn't close it.
+ * @retval  NFR_SUCCES -     if operation success (but it can give zero size)
+ * Access is closed by ringbufApplyRead().
+  */
+ret_code_t ringbufOpenDirectReadSeg(ringbuf_t const *p_ringbuf, ringbuf_seg_t seg[2]);
+
+/**
+ * Function for look at data inside internal buffer without removing it.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[in]     offset        Offset from the oldest byte.
+ * @param[out]    pp_data       Pointer to pointer to the position in internal buffer. Only for reading.
+ * @param[out]    p_size        Function put here amount of contiguous bytes from position.
+ *
+ * @retval  NRF_ERROR_INVALID_PARAM - if offset is beyond stored data.
+ * @retval  NFR_SUCCES -     if operation success (but it can write zero at p_size)
+  */
+ret_code_t ringbufPeek(ringbuf_t const *p_ringbuf, size_t offset, uint8_t **pp_data, size_t *p_size);
+
+/**
+ * Function for close direct read access and release read data.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[in]     size          Amount of really read bytes, not more than opened. Zero only closes access.
+  */
 void ringbufApplyRead(ringbuf_t const *p_ringbuf, size_t size);
 
+/**
+ * Function for open internal buffer to build data in place.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[out]    pp_data       Pointer to pointer to the write position in internal buffer.
+ * @param[out]    p_size        Function put here amount of contiguous free bytes from position.
+ *
+ * @retval  NFR_ERROR_BUSU - if application have direct access to write and didn't close it.
+ * @retval  NFR_SUCCES -     if operation success (but it can write zero at p_size)
+  */
+ret_code_t ringbufOpenDirectWrite(ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_size);
+
+/**
+ * Function for open internal buffer to build data in place on both sides of buffer end.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[out]    seg           Function puts here free space. The second segment starts at buffer
+ *                              beginning and has zero size if free space doesn't wrap.
+ *
+ * @retval  NFR_ERROR_BUSU - if application have direct access to write and didn't close it.
+ * @retval  NFR_SUCCES -     if operation success (but it can give zero size)
+ * Access is closed by ringbufApplyWrite().
+  */
+ret_code_t ringbufOpenDirectWriteSeg(ringbuf_t const *p_ringbuf, ringbuf_seg_t seg[2]);
+
+/**
+ * Function for close direct write access and store written data.
+ *
+ * @param[in]     p_ringbuf     Pointer to the ring buffer instance.
+ * @param[in]     size          Amount of really written bytes, not more than opened. Zero only closes access.
+  */
+void ringbufApplyWrite(ringbuf_t const *p_ringbuf, size_t size);
+
 /**
  * @brief Function for getting free spice in ring buffer.
  *
@@ -114,6 +189,109 @@ size_t ringbufGetFull(ringbuf_t const *p_ringbuf);
  * */
 void ringbufReset(ringbuf_t const *p_ringbuf);
 
+/**
+ * @brief Single producer single consumer ring buffer instance data.
+ *
+ * Indexes run freely and are masked by buffer size. Each side writes only own index,
+ * so producer in interrupt and consumer in main loop need no critical region.
+ * */
+typedef struct
+{
+  volatile uint32_t wr;   // written by producer only
+  volatile uint32_t rd;   // written by consumer only
+} spsc_ringbuf_data_t;
+
+/**
+ * @brief Single producer single consumer ring buffer instance structure.
+ * */
+typedef struct
+{
+    uint8_t             *p_buffer;
+    uint32_t            bufsize;
+    spsc_ringbuf_data_t *data;
+} spsc_ringbuf_t;
+
+/**
+ * @brief Macro for defining a single producer single consumer ring buffer instance.
+ *
+ * @param _name Instance name.
+ * @param _size Size of the ring buffer (must be a power of 2).
+ * */
+#define SPSC_RING_BUF_DEF(_name, _size)                     \
+static const spsc_ringbuf_t _name =                         \
+{                                                           \
+  .p_buffer = (uint8_t*)&(uint8_t[_size]){0},               \
+  .bufsize = _size,                                         \
+  .data = (spsc_ringbuf_data_t*)&(spsc_ringbuf_data_t){0},  \
+}
+
+/**
+ * @brief Function for initializing a single producer single consumer ring buffer instance.
+ *
+ * @param p_ringbuf          Pointer to the ring buffer instance.
+ * */
+void spscRingbufInit(spsc_ringbuf_t const *p_ringbuf);
+
+/**
+ * @brief Function for put blob to a ring buffer. Producer side only.
+ *
+ * @param[in] p_ringbuf      Pointer to the ring buffer instance.
+ * @param[in] p_data         Pointer to data to store.
+ * @param[in] length         Length of data block to store.
+ *
+ * @retval Amount of really putted bytes to ringbuf.
+ * */
+size_t spscRingbufPut(spsc_ringbuf_t const *p_ringbuf, const uint8_t *p_data, size_t length);
+
+/**
+ * @brief Function for copy data from a ring buffer without removing it. Consumer side only.
+ *
+ * @param[in]  p_ringbuf     Pointer to the ring buffer instance.
+ * @param[in]  offset        Offset from the oldest byte.
+ * @param[out] p_data        Pointer to store data block.
+ * @param[in]  length        Amount of wanted bytes.
+ *
+ * @retval Amount of really copied bytes.
+ * */
+size_t spscRingbufPeek(spsc_ringbuf_t const *p_ringbuf, size_t offset, uint8_t *p_data, size_t length);
+
+/**
+ * @brief Function for removing the oldest data from a ring buffer. Consumer side only.
+ *
+ * @param[in] p_ringbuf      Pointer to the ring buffer instance.
+ * @param[in] length         Amount of bytes to remove, not more than stored.
+ * */
+void spscRingbufRelease(spsc_ringbuf_t const *p_ringbuf, size_t length);
+
+/**
+ * @brief Function for getting data from a ring buffer. Consumer side only.
+ *
+ * @param[in]  p_ringbuf     Pointer to the ring buffer instance.
+ * @param[out] p_data        Pointer to store data block.
+ * @param[in]  length        Amount of wanted bytes.
+ *
+ * @retval Amount of really read bytes.
+ * */
+size_t spscRingbufGet(spsc_ringbuf_t const *p_ringbuf, uint8_t *p_data, size_t length);
+
+/**
+ * @brief Function for getting full space in a ring buffer.
+ *
+ * @param[in] p_ringbuf          Pointer to the ring buffer instance.
+ *
+ * @return  Amount of full space. Other side can only change it to the safe direction.
+ * */
+size_t spscRingbufGetFull(spsc_ringbuf_t const *p_ringbuf);
+
+/**
+ * @brief Function for getting free space in a ring buffer.
+ *
+ * @param[in] p_ringbuf          Pointer to the ring buffer instance.
+ *
+ * @return  Amount of free space. Other side can only change it to the safe direction.
+ * */
+size_t spscRingbufGetFree(spsc_ringbuf_t const *p_ringbuf);
+
 #ifdef __cplusplus
 }
 #endif
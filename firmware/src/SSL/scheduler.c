@@ -0,0 +1,111 @@
+#include "sdk_common.h"
+#include "app_util_platform.h"
+#include "app_timer.h"
+
+#include "scheduler.h"
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#define RTC_MASK    0x00FFFFFFul
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+static volatile uint32_t  pending;   // bit per task
+static sched_handler_t    handlers[SCHED_TASKS_TOTAL];
+static uint32_t           run_cnt[SCHED_TASKS_TOTAL];
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+static uint32_t           post_tick[SCHED_TASKS_TOTAL];
+static sched_stat_t       stat[SCHED_TASKS_TOTAL];
+#endif
+
+STATIC_ASSERT(SCHED_TASKS_TOTAL <= 32);
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void sched_Register(sched_task_t task, sched_handler_t handler)
+{
+  ASSERT(task < SCHED_TASKS_TOTAL);
+  handlers[task] = handler;
+}
+
+// ---------------------------------------------------------------------------
+void sched_Post(sched_task_t task)
+{
+  ASSERT(task < SCHED_TASKS_TOTAL);
+  CRITICAL_REGION_ENTER();
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+  if ((pending & (1ul << task)) == 0)
+  {
+    post_tick[task] = app_timer_cnt_get();
+  }
+#endif
+  pending |= 1ul << task;
+  CRITICAL_REGION_EXIT();
+}
+
+// ---------------------------------------------------------------------------
+void sched_Run(void)
+{
+  while (pending)
+  {
+    uint8_t task = 0;
+    while ((pending & (1ul << task)) == 0)
+    {
+      task++;
+    }
+
+    CRITICAL_REGION_ENTER();
+    pending &= ~(1ul << task);
+    CRITICAL_REGION_EXIT();
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+    uint32_t start = app_timer_cnt_get();
+    uint32_t latency = (start - post_tick[task]) & RTC_MASK;
+    stat[task].latency_ticks += latency;
+    stat[task].latency_max = MAX(stat[task].latency_max, MIN(latency, UINT16_MAX));
+#endif
+
+    // task is cleared before run, so event posted during run isn't lost
+    if (handlers[task])
+    {
+      handlers[task]();
+    }
+    run_cnt[task]++;
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+    stat[task].work_ticks += (app_timer_cnt_get() - start) & RTC_MASK;
+#endif
+  }
+}
+
+// ---------------------------------------------------------------------------
+bool sched_IsPending(void)
+{
+  return (pending != 0);
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sched_GetRunCnt(sched_task_t task)
+{
+  ASSERT(task < SCHED_TASKS_TOTAL);
+  return run_cnt[task];
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sched_GetPending(void)
+{
+  return pending;
+}
+
+#if defined(CPU_USAGE_MONITOR) && CPU_USAGE_MONITOR
+// ---------------------------------------------------------------------------
+void sched_GetStat(sched_task_t task, sched_stat_t *p_stat)
+{
+  ASSERT(task < SCHED_TASKS_TOTAL);
+  ASSERT(p_stat);
+  *p_stat = stat[task];
+}
+#endif
@@ -0,0 +1,74 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Run to completion scheduler of main loop.
+ * Interrupts and other tasks post a task instead of setting own flag. Main loop runs
+ * only posted tasks, the most priority first, and sleeps when nothing is posted.
+ * A task which posts itself runs once more after other posted tasks of higher priority.
+ */
+
+// Task order is priority, the first one is the most urgent
+typedef enum
+{
+  SCHED_PULSE,    // particle_cnt_Process
+  SCHED_BUTTON,   // button_Process
+  SCHED_BLE,      // BLE_Process
+  SCHED_PWT,      // PWT_Process
+  SCHED_FLOG,     // FLOG_Process
+  SCHED_BAT,      // batMea_Process
+  SCHED_TASKS_TOTAL
+} sched_task_t;
+
+typedef void (*sched_handler_t)(void);
+
+// Task profile, collected with CPU_USAGE_MONITOR only. Time is in RTC ticks (1/32768 s),
+// so tasks shorter than a tick are measured statistically
+typedef struct
+{
+  uint32_t  work_ticks;     // time inside task
+  uint32_t  latency_ticks;  // sum of time from the first post to run
+  uint16_t  latency_max;
+} sched_stat_t;
+
+/*! ---------------------------------------------------------------------------
+  \brief Set task handler
+  \param task[in]     - task
+  \param handler[in]  - function runs in main context when task is posted
+ ----------------------------------------------------------------------------*/
+void sched_Register(sched_task_t task, sched_handler_t handler);
+
+/*! ---------------------------------------------------------------------------
+  \brief Request task run. Can be invoked from any interrupt
+ ----------------------------------------------------------------------------*/
+void sched_Post(sched_task_t task);
+
+/*! ---------------------------------------------------------------------------
+  \brief Run posted tasks until nothing is posted
+ ----------------------------------------------------------------------------*/
+void sched_Run(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Check posted tasks. Main loop may sleep only if nothing is posted
+ ----------------------------------------------------------------------------*/
+bool sched_IsPending(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Amount of task runs after start
+ ----------------------------------------------------------------------------*/
+uint32_t sched_GetRunCnt(sched_task_t task);
+
+/*! ---------------------------------------------------------------------------
+  \brief Posted tasks mask, bit per task
+ ----------------------------------------------------------------------------*/
+uint32_t sched_GetPending(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Task profile after start. Available with CPU_USAGE_MONITOR only
+ ----------------------------------------------------------------------------*/
+void sched_GetStat(sched_task_t task, sched_stat_t *p_stat);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,128 @@
+#ifndef TYPED_QUEUE_H__
+#define TYPED_QUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_util_platform.h"
+
+/*!
+ * \brief Queue of fixed size elements generated for an element type.
+ * TQUEUE_DEF(name, type, capacity) defines a static queue and inline functions
+ * name_push(), name_push_overwrite(), name_pop(), name_peek(), name_pop_batch(),
+ * name_count() and name_reset(). Elements are copied by assignment, all functions are O(1)
+ * except batch pop. Every function runs in critical region, so producer and consumer
+ * can be in different interrupt priorities.
+ */
+
+/*! ---------------------------------------------------------------------------
+  \brief Define a typed queue
+  \param _name[in]      - queue name, prefix of generated functions
+  \param _type[in]      - element type
+  \param _capacity[in]  - maximum amount of elements <1-65535>
+ ----------------------------------------------------------------------------*/
+#define TQUEUE_DEF(_name, _type, _capacity)                                     \
+static struct                                                                   \
+{                                                                               \
+  _type     buf[_capacity];                                                     \
+  uint16_t  rd;                                                                 \
+  uint16_t  cnt;                                                                \
+} _name;                                                                        \
+                                                                                \
+static inline uint16_t _name##_idx(uint16_t offset)                             \
+{                                                                               \
+  uint32_t idx = (uint32_t)_name.rd + offset;                                   \
+  return (uint16_t)((idx >= (_capacity)) ? idx - (_capacity) : idx);            \
+}                                                                               \
+                                                                                \
+/* add element, false if queue is full */                                       \
+static inline bool _name##_push(const _type *p_item)                            \
+{                                                                               \
+  bool is_stored = false;                                                       \
+  CRITICAL_REGION_ENTER();                                                      \
+  if (_name.cnt < (_capacity))                                                  \
+  {                                                                             \
+    _name.buf[_name##_idx(_name.cnt)] = *p_item;                                \
+    _name.cnt++;                                                                \
+    is_stored = true;                                                           \
+  }                                                                             \
+  CRITICAL_REGION_EXIT();                                                       \
+  return is_stored;                                                             \
+}                                                                               \
+                                                                                \
+/* add element, the oldest one is thrown out if queue is full. true if it was */\
+static inline bool _name##_push_overwrite(const _type *p_item)                  \
+{                                                                               \
+  bool is_dropped;                                                              \
+  CRITICAL_REGION_ENTER();                                                      \
+  is_dropped = (_name.cnt == (_capacity));                                      \
+  if (is_dropped)                                                               \
+  {                                                                             \
+    _name.rd = _name##_idx(1);                                                  \
+    _name.cnt--;                                                                \
+  }                                                                             \
+  _name.buf[_name##_idx(_name.cnt)] = *p_item;                                  \
+  _name.cnt++;                                                                  \
+  CRITICAL_REGION_EXIT();                                                       \
+  return is_dropped;                                                            \
+}                                                                               \
+                                                                                \
+/* copy the oldest element without removing, false if queue is empty */         \
+static inline bool _name##_peek(_type *p_item)                                  \
+{                                                                               \
+  bool is_found = false;                                                        \
+  CRITICAL_REGION_ENTER();                                                      \
+  if (_name.cnt)                                                                \
+  {                                                                             \
+    *p_item = _name.buf[_name.rd];                                              \
+    is_found = true;                                                            \
+  }                                                                             \
+  CRITICAL_REGION_EXIT();                                                       \
+  return is_found;                                                              \
+}                                                                               \
+                                                                                \
+/* remove the oldest element, false if queue is empty */                        \
+static inline bool _name##_pop(_type *p_item)                                   \
+{                                                                               \
+  bool is_found = false;                                                        \
+  CRITICAL_REGION_ENTER();                                                      \
+  if (_name.cnt)                                                                \
+  {                                                                             \
+    *p_item = _name.buf[_name.rd];                                              \
+    _name.rd = _name##_idx(1);                                                  \
+    _name.cnt--;                                                                \
+    is_found = true;                                                            \
+  }                                                                             \
+  CRITICAL_REGION_EXIT();                                                       \
+  return is_found;                                                              \
+}                                                                               \
+                                                                                \
+/* remove up to max oldest elements to array, returns amount of them */         \
+static inline uint16_t _name##_pop_batch(_type *p_items, uint16_t max)          \
+{                                                                               \
+  uint16_t n;                                                                   \
+  CRITICAL_REGION_ENTER();                                                      \
+  n = (_name.cnt < max) ? _name.cnt : max;                                      \
+  for (uint16_t i = 0; i < n; i++)                                              \
+  {                                                                             \
+    p_items[i] = _name.buf[_name.rd];                                           \
+    _name.rd = _name##_idx(1);                                                  \
+  }                                                                             \
+  _name.cnt -= n;                                                               \
+  CRITICAL_REGION_EXIT();                                                       \
+  return n;                                                                     \
+}                                                                               \
+                                                                                \
+static inline uint16_t _name##_count(void)                                      \
+{                                                                               \
+  return _name.cnt;                                                             \
+}                                                                               \
+                                                                                \
+static inline void _name##_reset(void)                                          \
+{                                                                               \
+  CRITICAL_REGION_ENTER();                                                      \
+  _name.rd = 0;                                                                 \
+  _name.cnt = 0;                                                                \
+  CRITICAL_REGION_EXIT();                                                       \
+}
+
+#endif // TYPED_QUEUE_H__
@@ -0,0 +1,54 @@
+#include <sdk_common.h>
+#include <nrf_assert.h>
+#include "varint.h"
+
+#define GROUP_BITS    7
+#define GROUP_MASK    0x7F
+#define MORE_FLAG     0x80
+
+//-----------------------------------------------------------------------------
+//   PUBLIC FUNCTIONS
+//-----------------------------------------------------------------------------
+uint32_t zigzag_encode(int32_t v)
+{
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+//-----------------------------------------------------------------------------
+int32_t zigzag_decode(uint32_t v)
+{
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+//-----------------------------------------------------------------------------
+uint8_t varint_encode(uint32_t v, uint8_t *dst)
+{
+  ASSERT(dst);
+  uint8_t len = 0;
+  while (v > GROUP_MASK)
+  {
+    dst[len++] = (uint8_t)(v & GROUP_MASK) | MORE_FLAG;
+    v >>= GROUP_BITS;
+  }
+  dst[len++] = (uint8_t)v;
+  return len;
+}
+
+//-----------------------------------------------------------------------------
+uint8_t varint_decode(const uint8_t *src, uint8_t len, uint32_t *p_v)
+{
+  ASSERT(src);
+  ASSERT(p_v);
+  uint32_t v = 0;
+  len = MIN(len, VARINT_MAX_LEN);
+  for (uint8_t i = 0; i < len; i++)
+  {
+    v |= (uint32_t)(src[i] & GROUP_MASK) << (i * GROUP_BITS);
+    if ((src[i] & MORE_FLAG) == 0)
+    {
+      *p_v = v;
+      return i + 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef VARINT_H__
+#define VARINT_H__
+
+#include <stdint.h>
+
+/*!
+ * \brief Variable length integer codec.
+ * Value is split to 7 bit groups from the least significant one, bit 7 of a byte
+ * means that one more byte follows. Signed values are zig-zag mapped before, so
+ * small deltas of both signs take one byte: 0->0, -1->1, 1->2, -2->3 ...
+ */
+#define VARINT_MAX_LEN    5   // uint32_t takes 5 bytes at most
+
+/*! ---------------------------------------------------------------------------
+  \brief Map signed value to unsigned one with small magnitude kept small
+ ----------------------------------------------------------------------------*/
+uint32_t zigzag_encode(int32_t v);
+
+/*! ---------------------------------------------------------------------------
+  \brief Inverse of zigzag_encode()
+ ----------------------------------------------------------------------------*/
+int32_t zigzag_decode(uint32_t v);
+
+/*! ---------------------------------------------------------------------------
+  \brief Encode value
+  \param v[in]      - value
+  \param dst[out]   - buffer at least VARINT_MAX_LEN bytes
+
+  \return encoded length
+ ----------------------------------------------------------------------------*/
+uint8_t varint_encode(uint32_t v, uint8_t *dst);
+
+/*! ---------------------------------------------------------------------------
+  \brief Decode value
+  \param src[in]    - encoded data
+  \param len[in]    - available bytes in src
+  \param p_v[out]   - value
+
+  \return decoded length or 0 if src hasn't a whole value
+ ----------------------------------------------------------------------------*/
+uint8_t varint_decode(const uint8_t *src, uint8_t len, uint32_t *p_v);
+
+#endif // VARINT_H__
@@ -33,6 +33,21 @@ static void on_write(const char_desc_t *cd, ble_evt_t const * p_ble_evt)
 
 static void on_read(const char_desc_t *cd, ble_evt_t const * p_ble_evt)
 {
+  if (cd->is_long_read && (p_ble_evt->evt.gatts_evt.params.authorize_request.request.read.offset > 0))
+  {
+    // Read blob of a long value. Value was updated by the first reply, so the rest goes from attribute table
+    ble_gatts_rw_authorize_reply_params_t reply_params = {0};
+    reply_params.type = BLE_GATTS_AUTHORIZE_TYPE_READ;
+    reply_params.params.read.update      = 0;
+    reply_params.params.read.gatt_status = BLE_GATT_STATUS_SUCCESS;
+    ret_code_t ret_code = sd_ble_gatts_rw_authorize_reply(p_ble_evt->evt.gatts_evt.conn_handle, &reply_params);
+    if (ret_code != NRF_ERROR_BUSY)
+    {
+      APP_ERROR_CHECK(ret_code);
+    }
+    return;
+  }
+
   if (cd->rdCb != NULL)
   {
     cd->rdCb(p_ble_evt->evt.gatts_evt.conn_handle);
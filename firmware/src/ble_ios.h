@@ -52,6 +52,7 @@ typedef struct
   ble_ios_rd_handler_t  rdCb;                 // Callback on authorize read action
   ble_ios_wr_handler_t  wrCb;                 // Callback on write action
   bool                  is_defered_read;      // The defered read properties cause to BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST event when char is read
+  bool                  is_long_read;         // Value is longer than ATT MTU: read blob requests get the value set by the first reply
 } char_desc_t;
 
 
@@ -2,7 +2,7 @@
 #include "app_error.h"
 #include "nrf_log_ctrl.h"
 
-#include "sys_alive.h"
+#include "scheduler.h"
 #include "app_time_lib.h"
 #include "common_part.h"
 #include "CPU_usage.h"
@@ -14,7 +14,12 @@
 #include "sound.h"
 #include "hw_test.h"
 #include "realtime_particle_watcher.h"
+#include "particle_watcher.h"
 #include "event_queue.h"
+#include "pulse_sim.h"
+#include "flash_log.h"
+#include "energy_model.h"
+#include "slack_timer.h"
 
 
 #define NRF_LOG_MODULE_NAME     app
@@ -82,6 +87,9 @@ int main(void)
   chip_check();
   common_drv_init();
   app_time_Init();
+#if defined(TIMER_SLACK) && TIMER_SLACK
+  slack_timer_Init();
+#endif
 
   ret_code_t err_code = NRF_LOG_INIT(log_time_provider);
   ASSERT(err_code == NRF_SUCCESS);
@@ -99,28 +107,46 @@ int main(void)
   HV_pump_Init();
   particle_cnt_Init();
   RPW_Init();
-  EVQ_Init();
+#if defined(EXT_FLASH_LOG) && EXT_FLASH_LOG
+  FLOG_Init();
+#endif
+#if defined(PULSE_SIMULATOR) && PULSE_SIMULATOR
+  PSIM_Init();
+#endif
+#if defined(ENERGY_MODEL) && ENERGY_MODEL
+  ENRG_Init();
+#endif
 
   sound_Startup();
   button_Startup();
   particle_cnt_Startup();
   HV_pump_Startup();
-  RPW_Startup();
   EVQ_Startup();
+  RPW_Startup();
+#if defined(PULSE_SIMULATOR) && PULSE_SIMULATOR
+  PSIM_Startup();
+#endif
+#if defined(ENERGY_MODEL) && ENERGY_MODEL
+  ENRG_Startup();
+#endif
   sound_hello();
 
+  sched_Register(SCHED_PULSE, particle_cnt_Process);
+  sched_Register(SCHED_BUTTON, button_Process);
+  sched_Register(SCHED_BLE, BLE_Process);
+  sched_Register(SCHED_PWT, PWT_Process);
+#if defined(EXT_FLASH_LOG) && EXT_FLASH_LOG
+  sched_Register(SCHED_FLOG, FLOG_Process);
+#endif
+  sched_Register(SCHED_BAT, batMea_Process);
 
   // Enter main loop.
   while (true)
   {
-    batMea_Process();
-    button_Process();
-    particle_cnt_Process();
-    BLE_Process();
+    sched_Run();
 
     bool log_in_process = NRF_LOG_PROCESS();
-    bool sleep_is_locked = sleepLock_check();
-    if ((log_in_process == false) && (sleep_is_locked == false))
+    if ((log_in_process == false) && (sched_IsPending() == false))
     {
       CPU_usage_Sleep();
     }
@@ -0,0 +1,10 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Weak stand-ins of firmware modules a test doesn't build.
+ * Real module given to fw_test() overrides them.
+ */
+
+#define FAKE  __attribute__((weak))
+
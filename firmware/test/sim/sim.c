@@ -0,0 +1,590 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "sdk_common.h"
+#include "app_error.h"
+#include "app_timer.h"
+#include "nrf_delay.h"
+#include "nrf_drv_clock.h"
+#include "nrf_soc.h"
+
+#include "sim.h"
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#define EVENTS_MAX        32
+#define MAX_TIMEOUT_TICKS SIM_RTC_MASK
+
+// ----------------------------------------------------------------------------
+//   PRIVATE TYPES
+// ----------------------------------------------------------------------------
+typedef struct
+{
+  uint64_t  us;
+  sim_fn_t  fn;
+  void      *p_ctx;
+  bool      is_active;
+} hw_event_t;
+
+typedef struct
+{
+  sim_fn_t  handler;
+  void      *p_ctx;
+  uint32_t  busy_us;
+  uint64_t  free_us;    // previous handler is finished
+  bool      is_pending;
+} irq_line_t;
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+static uint64_t     now_us;
+static hw_event_t   events[EVENTS_MAX];
+static irq_line_t   irqs[SIM_IRQ_TOTAL];
+static app_timer_t  *p_timers;        // every created timer
+static sim_fn_t     p_main_loop;
+static void         *p_main_ctx;
+static uint32_t     wakeups;
+static uint32_t     block_period_us;
+static uint32_t     block_len_us;
+static uint32_t     critical_depth;
+static uint32_t     critical_cnt;
+static bool         is_dispatching;
+static bool         is_irq;           // firmware interrupt handler runs
+static uint32_t     op_queue_size;    // 0 before APP_TIMER_INIT: unlimited
+static uint32_t     timer_ops;        // app_timer operations queued by running interrupt
+static uint32_t     timer_ops_max;
+static sim_fn_t     p_barrier_hook;
+static void         *p_barrier_ctx;
+static bool         is_in_barrier;
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+static uint64_t us_to_ticks(uint64_t us)
+{
+  return us * SIM_TICK_FREQ / SIM_US_PER_SEC;
+}
+
+// ---------------------------------------------------------------------------
+// the earliest time interrupt can be served at
+static uint64_t unblocked(uint64_t us)
+{
+  if (block_period_us && ((us % block_period_us) < block_len_us))
+  {
+    us += block_len_us - (us % block_period_us);
+  }
+  return us;
+}
+
+// ---------------------------------------------------------------------------
+static int next_event(uint64_t *p_us)
+{
+  int next = -1;
+  for (int i = 0; i < EVENTS_MAX; i++)
+  {
+    if (events[i].is_active && ((next < 0) || (events[i].us < events[next].us)))
+    {
+      next = i;
+    }
+  }
+  if (next >= 0)
+  {
+    *p_us = events[next].us;
+  }
+  return next;
+}
+
+// ---------------------------------------------------------------------------
+static int next_irq(uint64_t *p_us)
+{
+  int next = -1;
+  uint64_t next_us = 0;
+  for (int i = 0; i < SIM_IRQ_TOTAL; i++)
+  {
+    if (irqs[i].is_pending)
+    {
+      uint64_t us = unblocked(MAX(now_us, irqs[i].free_us));
+      if ((next < 0) || (us < next_us))
+      {
+        next = i;
+        next_us = us;
+      }
+    }
+  }
+  *p_us = next_us;
+  return next;
+}
+
+// ---------------------------------------------------------------------------
+static app_timer_t *next_timer(uint64_t *p_us)
+{
+  app_timer_t *p_next = NULL;
+  for (app_timer_t *p_tmr = p_timers; p_tmr; p_tmr = p_tmr->p_next)
+  {
+    if (p_tmr->is_running && ((p_next == NULL) || (p_tmr->expiry < p_next->expiry)))
+    {
+      p_next = p_tmr;
+    }
+  }
+  if (p_next)
+  {
+    *p_us = unblocked(MAX(now_us, sim_TicksToUs(p_next->expiry)));
+  }
+  return p_next;
+}
+
+// ---------------------------------------------------------------------------
+static void event_fire(int idx)
+{
+  hw_event_t evt = events[idx];
+  events[idx].is_active = false;
+  now_us = MAX(now_us, evt.us);
+  evt.fn(evt.p_ctx);
+}
+
+// ---------------------------------------------------------------------------
+// all timers expired by now are served by one RTC1 interrupt
+static void timers_fire(void)
+{
+  uint64_t tick = sim_GetTicks();
+  app_timer_t *p_due;
+  do
+  {
+    p_due = NULL;
+    for (app_timer_t *p_tmr = p_timers; p_tmr; p_tmr = p_tmr->p_next)
+    {
+      if (p_tmr->is_running && (p_tmr->expiry <= tick) && ((p_due == NULL) || (p_tmr->expiry < p_due->expiry)))
+      {
+        p_due = p_tmr;
+      }
+    }
+
+    if (p_due)
+    {
+      if (p_due->mode == APP_TIMER_MODE_REPEATED)
+      {
+        p_due->expiry += p_due->period;
+      }
+      else
+      {
+        p_due->is_running = false;
+      }
+      p_due->handler(p_due->p_context);
+    }
+  } while (p_due);
+}
+
+// ---------------------------------------------------------------------------
+// app_timer operations of interrupt are processed by SWI after it returns
+static void irq_enter(void)
+{
+  is_irq = true;
+  timer_ops = 0;
+}
+
+static void irq_exit(void)
+{
+  is_irq = false;
+  timer_ops_max = MAX(timer_ops_max, timer_ops);
+}
+
+// main loop requests are processed at once, SWI preempts thread mode
+static bool timer_op_queue(void)
+{
+  if (!is_irq)
+  {
+    return true;
+  }
+  if ((op_queue_size != 0) && (timer_ops >= op_queue_size))
+  {
+    return false;
+  }
+  timer_ops++;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+static void wakeup_done(void)
+{
+  wakeups++;
+  ASSERT(critical_depth == 0);
+  if (p_main_loop)
+  {
+    p_main_loop(p_main_ctx);
+  }
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+uint64_t sim_GetUs(void)
+{
+  return now_us;
+}
+
+// ---------------------------------------------------------------------------
+uint64_t sim_GetTicks(void)
+{
+  return us_to_ticks(now_us);
+}
+
+// ---------------------------------------------------------------------------
+// the first microsecond the tick is reached at
+uint64_t sim_TicksToUs(uint64_t ticks)
+{
+  return (ticks * SIM_US_PER_SEC + SIM_TICK_FREQ - 1) / SIM_TICK_FREQ;
+}
+
+// ---------------------------------------------------------------------------
+// dispatches the nearest thing due before or at us, false if there is none
+static bool step(uint64_t us, bool *p_is_wakeup)
+{
+  uint64_t evt_us, irq_us, tmr_us;
+  int evt = next_event(&evt_us);
+  int irq = next_irq(&irq_us);
+  app_timer_t *p_tmr = next_timer(&tmr_us);
+  *p_is_wakeup = false;
+
+  if ((evt >= 0) && (evt_us <= us) && ((irq < 0) || (evt_us <= irq_us)) && ((p_tmr == NULL) || (evt_us <= tmr_us)))
+  {
+    event_fire(evt);
+  }
+  else if ((irq >= 0) && (irq_us <= us) && ((p_tmr == NULL) || (irq_us <= tmr_us)))
+  {
+    now_us = irq_us;
+    irqs[irq].is_pending = false;
+    irqs[irq].free_us = now_us + irqs[irq].busy_us;
+    irq_enter();
+    irqs[irq].handler(irqs[irq].p_ctx);
+    irq_exit();
+    *p_is_wakeup = true;
+  }
+  else if ((p_tmr != NULL) && (tmr_us <= us))
+  {
+    now_us = tmr_us;
+    irq_enter();
+    timers_fire();
+    irq_exit();
+    *p_is_wakeup = true;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+void sim_RunUntil(uint64_t us)
+{
+  ASSERT(!is_dispatching);    // must be invoked from test, not from firmware
+  is_dispatching = true;
+  bool is_wakeup;
+  while (step(us, &is_wakeup))
+  {
+    if (is_wakeup)
+    {
+      wakeup_done();
+    }
+  }
+  now_us = MAX(now_us, us);
+  is_dispatching = false;
+}
+
+// ---------------------------------------------------------------------------
+void sim_Run(uint64_t us)
+{
+  sim_RunUntil(now_us + us);
+}
+
+// ---------------------------------------------------------------------------
+void sim_CpuBusy(uint64_t us)
+{
+  uint64_t end = now_us + us;
+  uint64_t evt_us;
+  int evt;
+  while (((evt = next_event(&evt_us)) >= 0) && (evt_us <= end))
+  {
+    event_fire(evt);
+  }
+  now_us = end;
+}
+
+// ---------------------------------------------------------------------------
+void sim_SetMainLoop(sim_fn_t p_loop, void *p_ctx)
+{
+  p_main_loop = p_loop;
+  p_main_ctx = p_ctx;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_GetTimerOpsMax(void)
+{
+  uint32_t res = timer_ops_max;
+  timer_ops_max = 0;
+  return res;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_GetWakeups(void)
+{
+  return wakeups;
+}
+
+// ---------------------------------------------------------------------------
+int sim_At(uint64_t us, sim_fn_t fn, void *p_ctx)
+{
+  ASSERT(fn);
+  for (int i = 0; i < EVENTS_MAX; i++)
+  {
+    if (!events[i].is_active)
+    {
+      events[i] = (hw_event_t){.us = MAX(us, now_us), .fn = fn, .p_ctx = p_ctx, .is_active = true};
+      return i;
+    }
+  }
+  ASSERT(false);
+  return -1;
+}
+
+// ---------------------------------------------------------------------------
+void sim_Cancel(int id)
+{
+  if ((id >= 0) && (id < EVENTS_MAX))
+  {
+    events[id].is_active = false;
+  }
+}
+
+// ---------------------------------------------------------------------------
+void sim_IrqConnect(sim_irq_t irq, sim_fn_t handler, void *p_ctx, uint32_t busy_us)
+{
+  ASSERT(irq < SIM_IRQ_TOTAL);
+  irqs[irq].handler = handler;
+  irqs[irq].p_ctx = p_ctx;
+  irqs[irq].busy_us = busy_us;
+}
+
+// ---------------------------------------------------------------------------
+bool sim_IrqPend(sim_irq_t irq)
+{
+  ASSERT((irq < SIM_IRQ_TOTAL) && irqs[irq].handler);
+  if (irqs[irq].is_pending)
+  {
+    return false;
+  }
+  irqs[irq].is_pending = true;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+void sim_SetRadioBlock(uint32_t period_us, uint32_t len_us)
+{
+  ASSERT(len_us < period_us || period_us == 0);
+  block_period_us = period_us;
+  block_len_us = len_us;
+}
+
+// ---------------------------------------------------------------------------
+bool sim_IsCritical(void)
+{
+  return (critical_depth != 0);
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_GetCriticalCnt(void)
+{
+  return critical_cnt;
+}
+
+// ---------------------------------------------------------------------------
+void sim_CriticalEnter(void)
+{
+  critical_depth++;
+  critical_cnt++;
+}
+
+// ---------------------------------------------------------------------------
+void sim_CriticalExit(void)
+{
+  ASSERT(critical_depth);
+  critical_depth--;
+}
+
+// ---------------------------------------------------------------------------
+void sim_Barrier(void)
+{
+  __sync_synchronize();
+  if (p_barrier_hook && !is_in_barrier)
+  {
+    is_in_barrier = true;
+    p_barrier_hook(p_barrier_ctx);
+    is_in_barrier = false;
+  }
+}
+
+// ---------------------------------------------------------------------------
+void sim_SetBarrierHook(sim_fn_t hook, void *p_ctx)
+{
+  p_barrier_hook = hook;
+  p_barrier_ctx = p_ctx;
+}
+
+// ---------------------------------------------------------------------------
+void sim_AssertFailed(const char *file, int line, const char *expr)
+{
+  fprintf(stderr, "%s:%d: ASSERT(%s) failed at %llu us\n", file, line, expr, (unsigned long long)now_us);
+  abort();
+}
+
+// ---------------------------------------------------------------------------
+void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t *p_file_name)
+{
+  fprintf(stderr, "%s:%u: error 0x%X at %llu us\n", (const char*)p_file_name, line_num, error_code,
+          (unsigned long long)now_us);
+  abort();
+}
+
+// ---------------------------------------------------------------------------
+void sim_Log(const char *fmt, ...)
+{
+  static int is_enabled = -1;
+  if (is_enabled < 0)
+  {
+    is_enabled = (getenv("SIM_LOG") != NULL);
+  }
+  if (is_enabled)
+  {
+    va_list args;
+    va_start(args, fmt);
+    printf("%10.6f ", (double)now_us / SIM_US_PER_SEC);
+    vprintf(fmt, args);
+    va_end(args);
+  }
+}
+
+// ----------------------------------------------------------------------------
+//    APP_TIMER
+// ----------------------------------------------------------------------------
+void app_timer_sim_init(uint32_t size)
+{
+  op_queue_size = size;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler)
+{
+  if ((p_timer_id == NULL) || (*p_timer_id == NULL) || (timeout_handler == NULL))
+  {
+    return NRF_ERROR_NULL;
+  }
+  app_timer_t *p_tmr = *p_timer_id;
+  if (p_tmr->handler == NULL)
+  {
+    p_tmr->p_next = p_timers;
+    p_timers = p_tmr;
+  }
+  p_tmr->handler = timeout_handler;
+  p_tmr->mode = mode;
+  p_tmr->is_running = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context)
+{
+  if ((timer_id == NULL) || (timer_id->handler == NULL))
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if ((timeout_ticks < APP_TIMER_MIN_TIMEOUT_TICKS) || (timeout_ticks > MAX_TIMEOUT_TICKS))
+  {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  if (!timer_op_queue())
+  {
+    return NRF_ERROR_NO_MEM;
+  }
+  if (timer_id->is_running)
+  {
+    return NRF_SUCCESS;   // SDK 12 ignores start of running timer
+  }
+  timer_id->expiry = sim_GetTicks() + timeout_ticks;
+  timer_id->period = timeout_ticks;
+  timer_id->p_context = p_context;
+  timer_id->is_running = true;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t app_timer_stop(app_timer_id_t timer_id)
+{
+  if ((timer_id == NULL) || (timer_id->handler == NULL))
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if (!timer_op_queue())
+  {
+    return NRF_ERROR_NO_MEM;
+  }
+  timer_id->is_running = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t app_timer_cnt_get(void)
+{
+  return (uint32_t)sim_GetTicks() & SIM_RTC_MASK;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from, uint32_t *p_ticks_diff)
+{
+  *p_ticks_diff = (ticks_to - ticks_from) & SIM_RTC_MASK;
+  return NRF_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+//    OTHER SDK SERVICES
+// ----------------------------------------------------------------------------
+void nrf_delay_us(uint32_t us)
+{
+  sim_CpuBusy(us);
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_clock_init(void)
+{
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_clock_lfclk_request(void *p_handler_item)
+{
+  (void)p_handler_item;
+}
+
+// ---------------------------------------------------------------------------
+// Main loop of firmware driven by test sleeps till the next wakeup, main loop run by
+// sim_SetMainLoop() is invoked after wakeup, so it doesn't sleep
+uint32_t sd_app_evt_wait(void)
+{
+  if (is_dispatching)
+  {
+    return NRF_SUCCESS;
+  }
+  is_dispatching = true;
+  bool is_wakeup = false;
+  while (!is_wakeup && step(UINT64_MAX, &is_wakeup))
+  {
+  }
+  if (is_wakeup)
+  {
+    wakeups++;
+  }
+  is_dispatching = false;
+  return NRF_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Host simulation core.
+ * Virtual time runs in microseconds, the 32768 Hz RTC1 clock of app_timer is derived
+ * from it. Nothing runs by itself: sim_RunUntil() moves time forward and dispatches
+ * in time order hardware events, interrupts and app_timer expirations. Every
+ * interrupt or batch of timers expired together is one wakeup, after it the main loop
+ * function is invoked like firmware main() does after __WFE(). Firmware main loop
+ * can be driven by test instead, then sd_app_evt_wait() sleeps till the next wakeup.
+ * Firmware code takes no time, busy waits and register polling move time by sim_CpuBusy().
+ */
+
+#define SIM_US_PER_SEC    1000000ull
+#define SIM_TICK_FREQ     32768ull
+#define SIM_RTC_MASK      0x00FFFFFFul
+
+#define SIM_SEC(s)        ((uint64_t)(s) * SIM_US_PER_SEC)
+#define SIM_MS(ms)        ((uint64_t)(ms) * 1000)
+
+// Interrupt lines of the modelled peripherals, lower number is served first
+typedef enum
+{
+  SIM_IRQ_GPIOTE,
+  SIM_IRQ_TIMER0,
+  SIM_IRQ_TIMER1,
+  SIM_IRQ_TIMER2,
+  SIM_IRQ_LPCOMP,
+  SIM_IRQ_TOTAL
+} sim_irq_t;
+
+typedef void (*sim_fn_t)(void *p_ctx);
+
+// ----------------------------------------------------------------------------
+uint64_t sim_GetUs(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Virtual RTC1 time in 1/32768 s ticks from start, not wrapped at 24 bit
+ ----------------------------------------------------------------------------*/
+uint64_t sim_GetTicks(void);
+
+uint64_t sim_TicksToUs(uint64_t ticks);
+
+/*! ---------------------------------------------------------------------------
+  \brief Move time to us dispatching everything due before or at it
+ ----------------------------------------------------------------------------*/
+void sim_RunUntil(uint64_t us);
+
+void sim_Run(uint64_t us);
+
+/*! ---------------------------------------------------------------------------
+  \brief Code is busy for us: hardware events are processed, interrupts wait
+ ----------------------------------------------------------------------------*/
+void sim_CpuBusy(uint64_t us);
+
+/*! ---------------------------------------------------------------------------
+  \brief Set main loop function invoked after every wakeup, e.g. sched_Run
+ ----------------------------------------------------------------------------*/
+void sim_SetMainLoop(sim_fn_t p_loop, void *p_ctx);
+
+/*! ---------------------------------------------------------------------------
+  \brief Wakeups since start: interrupts and app_timer expiration batches
+ ----------------------------------------------------------------------------*/
+uint32_t sim_GetWakeups(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Most app_timer operations queued by one interrupt since the previous call
+ ----------------------------------------------------------------------------*/
+uint32_t sim_GetTimerOpsMax(void);
+
+// ----------------------------------------------------------------------------
+// Hardware event at time us, returns id for sim_Cancel
+int  sim_At(uint64_t us, sim_fn_t fn, void *p_ctx);
+void sim_Cancel(int id);
+
+/*! ---------------------------------------------------------------------------
+  \brief Interrupt line set up by peripheral model
+  \param irq[in]     - line
+  \param handler[in] - invoked when interrupt is served
+  \param busy_us[in] - handler duration, line isn't served again before it passes
+ ----------------------------------------------------------------------------*/
+void sim_IrqConnect(sim_irq_t irq, sim_fn_t handler, void *p_ctx, uint32_t busy_us);
+
+/*! ---------------------------------------------------------------------------
+  \brief Request interrupt
+  \return false if it's pending already, so request is merged with previous one
+ ----------------------------------------------------------------------------*/
+bool sim_IrqPend(sim_irq_t irq);
+
+/*! ---------------------------------------------------------------------------
+  \brief SoftDevice radio activity model
+  \details Application interrupts and timers wait while radio event is in progress.
+           Events of len_us repeat every period_us, zero period turns model off
+ ----------------------------------------------------------------------------*/
+void sim_SetRadioBlock(uint32_t period_us, uint32_t len_us);
+
+// ----------------------------------------------------------------------------
+bool     sim_IsCritical(void);
+uint32_t sim_GetCriticalCnt(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Hook invoked at every __DMB() of firmware, not nested
+  \details Lets test run an interrupt exactly where lock-free code orders its memory
+           accesses. NULL turns it off
+ ----------------------------------------------------------------------------*/
+void sim_SetBarrierHook(sim_fn_t hook, void *p_ctx);
+
+#endif // SIM_H
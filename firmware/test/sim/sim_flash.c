@@ -0,0 +1,219 @@
+#include <sys/mman.h>
+#include "sdk_common.h"
+#include "ext_flash.h"
+
+#include "sim.h"
+#include "test.h"
+#include "sim_flash.h"
+
+// ----------------------------------------------------------------------------
+//   PRIVATE TYPES
+// ----------------------------------------------------------------------------
+typedef enum
+{
+  OP_NONE,
+  OP_PROGRAM,
+  OP_ERASE,
+} op_t;
+
+typedef struct
+{
+  uint8_t           array[EXT_FLASH_SIZE];
+  uint8_t           backup[EXT_FLASH_SECTOR_SIZE];  // content before operation in progress
+  uint8_t           data[EXT_FLASH_PAGE_SIZE];      // data of program in progress
+  sim_flash_stat_t  stat;
+  uint64_t          busy_until;
+  uint32_t          op_addr;
+  uint32_t          op_len;
+  op_t              op;
+  bool              is_present;
+  bool              is_sleep;
+} chip_t;
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+static chip_t *p_chip;
+
+// ----------------------------------------------------------------------------
+//    PRIVATE FUNCTION
+// ----------------------------------------------------------------------------
+static bool is_busy(void)
+{
+  if ((p_chip->op != OP_NONE) && (sim_GetUs() >= p_chip->busy_until))
+  {
+    p_chip->op = OP_NONE;
+  }
+  return (p_chip->op != OP_NONE);
+}
+
+// ---------------------------------------------------------------------------
+static bool access_check(void)
+{
+  ASSERT(p_chip && p_chip->is_present);
+  p_chip->is_sleep = false;         // driver wakes chip up by CS
+  if (is_busy())
+  {
+    p_chip->stat.violations++;
+    return false;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+static void op_start(op_t op, uint32_t addr, uint32_t len, uint32_t us)
+{
+  memcpy(p_chip->backup, &p_chip->array[addr], len);
+  p_chip->op = op;
+  p_chip->op_addr = addr;
+  p_chip->op_len = len;
+  p_chip->busy_until = sim_GetUs() + us;
+  p_chip->stat.busy_us += us;
+}
+
+// ----------------------------------------------------------------------------
+//    PUBLIC FUNCTION
+// ----------------------------------------------------------------------------
+void sim_flash_Init(bool is_present)
+{
+  if (p_chip == NULL)
+  {
+    p_chip = mmap(NULL, sizeof(chip_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT(p_chip != MAP_FAILED);
+    sim_flash_Erase();
+  }
+  p_chip->op = OP_NONE;
+  p_chip->is_present = is_present;
+}
+
+// ---------------------------------------------------------------------------
+void sim_flash_Erase(void)
+{
+  memset(p_chip->array, 0xFF, sizeof(p_chip->array));
+  memset(&p_chip->stat, 0, sizeof(p_chip->stat));
+  p_chip->op = OP_NONE;
+}
+
+// ---------------------------------------------------------------------------
+bool sim_flash_PowerCut(void)
+{
+  bool is_torn = is_busy();
+  if (is_torn)
+  {
+    uint8_t *p_dst = &p_chip->array[p_chip->op_addr];
+    memcpy(p_dst, p_chip->backup, p_chip->op_len);
+    if (p_chip->op == OP_PROGRAM)
+    {
+      uint32_t done = test_Rand() % p_chip->op_len;
+      for (uint32_t i = 0; i < done; i++)
+      {
+        p_dst[i] &= p_chip->data[i];
+      }
+      p_dst[done] &= p_chip->data[done] | (uint8_t)test_Rand();
+    }
+    else
+    {
+      for (uint32_t i = 0; i < p_chip->op_len; i++)
+      {
+        p_dst[i] = (test_Rand() & 1) ? 0xFF : p_dst[i];
+      }
+    }
+  }
+  p_chip->op = OP_NONE;
+  p_chip->is_sleep = false;
+  return is_torn;
+}
+
+// ---------------------------------------------------------------------------
+const sim_flash_stat_t *sim_flash_GetStat(void)
+{
+  return &p_chip->stat;
+}
+
+// ----------------------------------------------------------------------------
+//    ext_flash.h
+// ----------------------------------------------------------------------------
+ret_code_t extFlash_Init(void)
+{
+  ASSERT(p_chip);
+  return p_chip->is_present ? NRF_SUCCESS : NRF_ERROR_NOT_FOUND;
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Read(uint32_t addr, void *p_data, size_t len)
+{
+  ASSERT(addr + len <= EXT_FLASH_SIZE);
+  if (access_check())
+  {
+    memcpy(p_data, &p_chip->array[addr], len);
+  }
+  else
+  {
+    memset(p_data, 0xA5, len);      // status register comes instead of data
+  }
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Program(uint32_t addr, const void *p_data, size_t len)
+{
+  ASSERT(addr + len <= EXT_FLASH_SIZE);
+  if (!access_check())
+  {
+    return;
+  }
+  if ((len == 0) || (len > EXT_FLASH_PAGE_SIZE) ||
+      ((addr / EXT_FLASH_PAGE_SIZE) != ((addr + len - 1) / EXT_FLASH_PAGE_SIZE)))
+  {
+    p_chip->stat.violations++;
+    return;
+  }
+
+  const uint8_t *p_src = p_data;
+  op_start(OP_PROGRAM, addr, len, SIM_FLASH_PROGRAM_US);
+  memcpy(p_chip->data, p_src, len);
+  for (size_t i = 0; i < len; i++)
+  {
+    if (p_src[i] & ~p_chip->array[addr + i])
+    {
+      p_chip->stat.violations++;    // bit can't go 0->1 without erase
+    }
+    p_chip->array[addr + i] &= p_src[i];
+  }
+  p_chip->stat.programs++;
+  p_chip->stat.program_bytes += len;
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_SectorErase(uint32_t addr)
+{
+  ASSERT(addr < EXT_FLASH_SIZE);
+  if (!access_check())
+  {
+    return;
+  }
+  addr -= addr % EXT_FLASH_SECTOR_SIZE;
+  op_start(OP_ERASE, addr, EXT_FLASH_SECTOR_SIZE, SIM_FLASH_ERASE_US);
+  memset(&p_chip->array[addr], 0xFF, EXT_FLASH_SECTOR_SIZE);
+  p_chip->stat.erases++;
+  p_chip->stat.sector_erases[addr / EXT_FLASH_SECTOR_SIZE]++;
+}
+
+// ---------------------------------------------------------------------------
+bool extFlash_IsBusy(void)
+{
+  ASSERT(p_chip && p_chip->is_present);
+  p_chip->is_sleep = false;
+  return is_busy();
+}
+
+// ---------------------------------------------------------------------------
+void extFlash_Sleep(void)
+{
+  ASSERT(p_chip && p_chip->is_present);
+  if (is_busy())
+  {
+    p_chip->stat.violations++;      // deep power-down command is ignored while busy
+    return;
+  }
+  p_chip->is_sleep = true;
+}
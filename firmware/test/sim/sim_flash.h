@@ -0,0 +1,49 @@
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ext_flash.h"
+
+/*!
+ * \brief SPI NOR flash model behind ext_flash.h.
+ * Program and erase keep the chip busy in virtual time (0.85 ms and 30 ms typical of
+ * MX25V1635F). Program changes only 1->0 bits. Array is shared memory, so it survives
+ * fork() of the test: a child process can work until power cut and the next child
+ * starts from that content like firmware after reset.
+ */
+
+#define SIM_FLASH_PROGRAM_US    850
+#define SIM_FLASH_ERASE_US      30000
+#define SIM_FLASH_SECTORS       (EXT_FLASH_SIZE / EXT_FLASH_SECTOR_SIZE)
+
+typedef struct
+{
+  uint32_t  programs;
+  uint32_t  program_bytes;
+  uint32_t  erases;
+  uint64_t  busy_us;          // chip time of program and erase
+  uint32_t  violations;       // access while busy, page crossing, 0->1 program
+  uint32_t  sector_erases[SIM_FLASH_SECTORS];
+} sim_flash_stat_t;
+
+/*! ---------------------------------------------------------------------------
+  \brief Create erased chip on the first call, keep content on next ones
+  \param is_present[in] - false if chip doesn't answer to extFlash_Init()
+ ----------------------------------------------------------------------------*/
+void sim_flash_Init(bool is_present);
+
+// erase the whole chip and reset statistic
+void sim_flash_Erase(void);
+
+/*! ---------------------------------------------------------------------------
+  \brief Power is lost now: operation in progress is torn
+  \details Program leaves random part of data written and one byte with part of bits.
+           Erase leaves sector bytes randomly erased or not
+  \return true if operation was torn
+ ----------------------------------------------------------------------------*/
+bool sim_flash_PowerCut(void);
+
+const sim_flash_stat_t *sim_flash_GetStat(void);
+
+#endif // SIM_FLASH_H
@@ -0,0 +1,102 @@
+#include <math.h>
+#include "sdk_common.h"
+#include "sim.h"
+#include "sim_hw.h"
+#include "sim_hv.h"
+
+#define ON_PHASE_REF_NS   15000.0
+
+static sim_hv_cfg_t cfg;
+static double       volt;
+static double       min_volt;
+static uint64_t     last_us;
+static uint64_t     rise_us;
+static uint32_t     cycles;
+static uint32_t     on_ns;
+
+// ---------------------------------------------------------------------------
+static void leak(void)
+{
+  uint64_t now = sim_GetUs();
+  volt *= exp(-(double)(now - last_us) / SIM_US_PER_SEC / cfg.tau_s);
+  last_us = now;
+}
+
+// ---------------------------------------------------------------------------
+static void on_pin(uint32_t pin, bool level)
+{
+  if (pin != PUMP_HV_PIN)
+  {
+    return;
+  }
+  if (level)
+  {
+    rise_us = sim_GetUs();
+    return;
+  }
+
+  // on phase is over, coil energy goes to capacitor in fly back
+  leak();
+  min_volt = MIN(min_volt, volt);
+  on_ns = (uint32_t)((sim_GetUs() - rise_us) * 1000);
+  double k = on_ns / ON_PHASE_REF_NS;
+  volt += cfg.cycle_dv * k * k;
+  cycles++;
+  if (volt >= 1.0)
+  {
+    sim_lpcomp_Set(true);
+  }
+  sim_lpcomp_Set(false);    // coil node goes back to supply after fly back
+}
+
+// ---------------------------------------------------------------------------
+void sim_hv_Init(const sim_hv_cfg_t *p_cfg)
+{
+  cfg = *p_cfg;
+  volt = 0;
+  min_volt = INFINITY;
+  last_us = sim_GetUs();
+  cycles = 0;
+  sim_gpio_Observe(on_pin);
+}
+
+// ---------------------------------------------------------------------------
+void sim_hv_SetCycleDv(double cycle_dv)
+{
+  cfg.cycle_dv = cycle_dv;
+}
+
+// ---------------------------------------------------------------------------
+void sim_hv_Pulse(void)
+{
+  leak();
+  volt = MAX(volt - cfg.pulse_dv, 0);
+  min_volt = MIN(min_volt, volt);
+}
+
+// ---------------------------------------------------------------------------
+double sim_hv_GetV(void)
+{
+  leak();
+  return volt;
+}
+
+// ---------------------------------------------------------------------------
+double sim_hv_TakeMinV(void)
+{
+  double v = MIN(min_volt, sim_hv_GetV());
+  min_volt = INFINITY;
+  return v;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_hv_GetCycles(void)
+{
+  return cycles;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_hv_GetOnNs(void)
+{
+  return on_ns;
+}
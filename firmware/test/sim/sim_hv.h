@@ -0,0 +1,39 @@
+#ifndef SIM_HV_H
+#define SIM_HV_H
+
+#include <stdint.h>
+
+/*!
+ * \brief Flyback converter and tube capacitor model, voltage is relative to LPCOMP threshold.
+ * Every pump cycle (PUMP_HV_PIN high phase) adds charge growing with on phase squared,
+ * capacitor leaks through RC and every tube pulse takes a fixed portion. Feedback is
+ * valid in fly back only: LPCOMP sees capacitor voltage while coil releases energy, so UP
+ * event comes in the cycle which reaches threshold.
+ */
+
+typedef struct
+{
+  double  cycle_dv;       // voltage rise by one cycle of 15 us on phase
+  double  pulse_dv;       // voltage drop by one tube pulse
+  double  tau_s;          // RC of capacitor leakage
+} sim_hv_cfg_t;
+
+void sim_hv_Init(const sim_hv_cfg_t *p_cfg);
+
+// converter gain change, e.g. battery sag: voltage rise by one cycle of 15 us on phase
+void sim_hv_SetCycleDv(double cycle_dv);
+
+// tube pulse discharges capacitor
+void sim_hv_Pulse(void);
+
+// voltage now, 1.0 is feedback threshold
+double sim_hv_GetV(void);
+
+// the lowest voltage since the previous call, taken before every pump cycle
+double sim_hv_TakeMinV(void);
+
+// pump cycles and the last on phase
+uint32_t sim_hv_GetCycles(void);
+uint32_t sim_hv_GetOnNs(void);
+
+#endif // SIM_HV_H
@@ -0,0 +1,947 @@
+#include <string.h>
+#include "sdk_common.h"
+#include "nrf_gpio.h"
+#include "nrf_drv_gpiote.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_timer.h"
+#include "nrf_drv_lpcomp.h"
+#include "Timer_anomaly_fix.h"
+
+#include "sim.h"
+#include "sim_hw.h"
+
+// ----------------------------------------------------------------------------
+//  DEFINE MODULE PARAMETER
+// ----------------------------------------------------------------------------
+#define PINS_TOTAL          32
+#define TIMERS_TOTAL        3
+#define PPI_CH_TOTAL        8     // channels left to application by S130
+#define NO_CHANNEL          (-1)
+
+#define GPIOTE_TASKS_OUT    0x000
+#define GPIOTE_EVENTS_IN    0x100
+#define GPIOTE_EVENTS_PORT  0x17C
+#define REG_SPAN            0x1000
+#define TIMER_INTEN_POS     16    // COMPARE[n] interrupt is bit 16 + n of INTENSET
+#define POLL_US             1     // register read in polling loop, about 16 cycles
+#define OBSERVERS_MAX       4
+
+// ----------------------------------------------------------------------------
+//   PRIVATE TYPES
+// ----------------------------------------------------------------------------
+typedef struct
+{
+  nrf_drv_gpiote_in_config_t    in_cfg;
+  nrf_drv_gpiote_evt_handler_t  handler;
+  nrf_drv_gpiote_out_config_t   out_cfg;
+  int8_t                        channel;
+  bool                          is_in;
+  bool                          is_out;
+  bool                          is_evt_enabled;
+  bool                          is_int_enabled;
+  bool                          is_task_enabled;
+  bool                          is_irq_pending;
+  bool                          level;
+} pin_t;
+
+typedef struct
+{
+  nrf_timer_event_handler_t handler;
+  void                      *p_context;
+  nrf_timer_mode_t          mode;
+  uint32_t                  mask;
+  uint32_t                  hz;
+  uint32_t                  base;       // counter value at start_us
+  uint64_t                  start_us;
+  int                       evt_id[4];
+  bool                      is_init;
+  bool                      is_running;
+} tmr_model_t;
+
+typedef struct
+{
+  uint32_t  eep;
+  uint32_t  tep;
+  bool      is_alloc;
+  bool      is_enabled;
+} ppi_ch_t;
+
+// ----------------------------------------------------------------------------
+//   PRIVATE VARIABLE
+// ----------------------------------------------------------------------------
+NRF_TIMER_Type  sim_timer_regs[TIMERS_TOTAL];
+NRF_GPIO_Type   sim_gpio_regs;
+
+static pin_t      pins[PINS_TOTAL];
+static bool       is_ch_used[GPIOTE_CH_NUM];
+static uint32_t   gpiote_merged;
+static uint32_t   gpiote_irq_cnt;
+static tmr_model_t    timers[TIMERS_TOTAL];
+static ppi_ch_t   ppi[PPI_CH_TOTAL];
+static sim_gpio_observer_t observers[OBSERVERS_MAX];
+
+static struct
+{
+  lpcomp_events_handler_t handler;
+  uint32_t                int_mask;
+  bool                    is_enabled;
+  bool                    is_above;
+  bool                    evt_up;
+} lpcomp;
+
+// ----------------------------------------------------------------------------
+//    GPIO
+// ----------------------------------------------------------------------------
+static void level_set(uint32_t pin, bool level)
+{
+  ASSERT(pin < PINS_TOTAL);
+  if (pins[pin].level != level)
+  {
+    pins[pin].level = level;
+    for (uint8_t i = 0; (i < OBSERVERS_MAX) && observers[i]; i++)
+    {
+      observers[i](pin, level);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_cfg(uint32_t pin_number, nrf_gpio_pin_dir_t dir, nrf_gpio_pin_input_t input,
+                  nrf_gpio_pin_pull_t pull, nrf_gpio_pin_drive_t drive, nrf_gpio_pin_sense_t sense)
+{
+  ASSERT(pin_number < PINS_TOTAL);
+  sim_gpio_regs.PIN_CNF[pin_number] = (uint32_t)dir | ((uint32_t)input << 1) |
+                                      ((uint32_t)pull << GPIO_PIN_CNF_PULL_Pos) |
+                                      ((uint32_t)drive << 8) | ((uint32_t)sense << 16);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_cfg_output(uint32_t pin_number)
+{
+  nrf_gpio_cfg(pin_number, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_DISCONNECT,
+               NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_cfg_input(uint32_t pin_number, nrf_gpio_pin_pull_t pull_config)
+{
+  nrf_gpio_cfg(pin_number, NRF_GPIO_PIN_DIR_INPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+               pull_config, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_cfg_default(uint32_t pin_number)
+{
+  nrf_gpio_cfg(pin_number, NRF_GPIO_PIN_DIR_INPUT, NRF_GPIO_PIN_INPUT_DISCONNECT,
+               NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_pin_set(uint32_t pin_number)
+{
+  level_set(pin_number, true);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_pin_clear(uint32_t pin_number)
+{
+  level_set(pin_number, false);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_pin_toggle(uint32_t pin_number)
+{
+  level_set(pin_number, !sim_gpio_Get(pin_number));
+}
+
+// ---------------------------------------------------------------------------
+void nrf_gpio_pin_write(uint32_t pin_number, uint32_t value)
+{
+  level_set(pin_number, value != 0);
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_gpio_pin_read(uint32_t pin_number)
+{
+  return sim_gpio_Get(pin_number);
+}
+
+// ---------------------------------------------------------------------------
+NRF_GPIO_Type *nrf_gpio_pin_port_decode(uint32_t *p_pin)
+{
+  ASSERT(*p_pin < PINS_TOTAL);
+  return &sim_gpio_regs;
+}
+
+// ---------------------------------------------------------------------------
+bool sim_gpio_Get(uint32_t pin)
+{
+  ASSERT(pin < PINS_TOTAL);
+  return pins[pin].level;
+}
+
+// ---------------------------------------------------------------------------
+nrf_gpio_pin_pull_t sim_gpio_GetPull(uint32_t pin)
+{
+  ASSERT(pin < PINS_TOTAL);
+  return (nrf_gpio_pin_pull_t)((sim_gpio_regs.PIN_CNF[pin] & GPIO_PIN_CNF_PULL_Msk) >> GPIO_PIN_CNF_PULL_Pos);
+}
+
+// ---------------------------------------------------------------------------
+void sim_gpio_Observe(sim_gpio_observer_t observer)
+{
+  uint8_t i = 0;
+  while (observers[i] && (observers[i] != observer))
+  {
+    i++;
+    ASSERT(i < OBSERVERS_MAX);
+  }
+  observers[i] = observer;
+}
+
+// ----------------------------------------------------------------------------
+//    GPIOTE
+// ----------------------------------------------------------------------------
+static int8_t channel_alloc(void)
+{
+  for (int8_t ch = 0; ch < GPIOTE_CH_NUM; ch++)
+  {
+    if (!is_ch_used[ch])
+    {
+      is_ch_used[ch] = true;
+      return ch;
+    }
+  }
+  return NO_CHANNEL;
+}
+
+// ---------------------------------------------------------------------------
+static void channel_free(int8_t ch)
+{
+  if (ch != NO_CHANNEL)
+  {
+    is_ch_used[ch] = false;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// the driver IRQ handler calls user handler of every pin which event came
+static void gpiote_irq(void *p_ctx)
+{
+  (void)p_ctx;
+  gpiote_irq_cnt++;
+  for (uint32_t pin = 0; pin < PINS_TOTAL; pin++)
+  {
+    if (pins[pin].is_irq_pending)
+    {
+      pins[pin].is_irq_pending = false;
+      if (pins[pin].is_in && pins[pin].is_int_enabled && pins[pin].handler)
+      {
+        pins[pin].handler(pin, pins[pin].in_cfg.sense);
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_gpiote_init(void)
+{
+  sim_IrqConnect(SIM_IRQ_GPIOTE, gpiote_irq, NULL, SIM_PULSE_ISR_US);
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+bool nrf_drv_gpiote_is_init(void)
+{
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_gpiote_in_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_in_config_t const *p_config,
+                                  nrf_drv_gpiote_evt_handler_t evt_handler)
+{
+  ASSERT((pin < PINS_TOTAL) && p_config);
+  pin_t *p_pin = &pins[pin];
+  if (p_pin->is_in || p_pin->is_out)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  p_pin->channel = NO_CHANNEL;
+  if (p_config->hi_accuracy)
+  {
+    p_pin->channel = channel_alloc();
+    if (p_pin->channel == NO_CHANNEL)
+    {
+      return NRF_ERROR_NO_MEM;
+    }
+  }
+  nrf_drv_gpiote_init();
+  nrf_gpio_cfg_input(pin, p_config->pull);
+  p_pin->in_cfg = *p_config;
+  p_pin->handler = evt_handler;
+  p_pin->is_in = true;
+  p_pin->is_evt_enabled = false;
+  p_pin->is_int_enabled = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_in_uninit(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_in);
+  channel_free(pins[pin].channel);
+  pins[pin].is_in = false;
+  pins[pin].is_evt_enabled = false;
+  pins[pin].is_int_enabled = false;
+  pins[pin].is_irq_pending = false;
+  nrf_gpio_cfg_default(pin);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_in_event_enable(nrf_drv_gpiote_pin_t pin, bool int_enable)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_in);
+  pins[pin].is_evt_enabled = true;
+  pins[pin].is_int_enabled = int_enable;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_in_event_disable(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_in);
+  pins[pin].is_evt_enabled = false;
+  pins[pin].is_int_enabled = false;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_drv_gpiote_in_event_addr_get(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_in);
+  if (pins[pin].channel == NO_CHANNEL)
+  {
+    return NRF_GPIOTE_BASE + GPIOTE_EVENTS_PORT;
+  }
+  return NRF_GPIOTE_BASE + GPIOTE_EVENTS_IN + 4 * (uint32_t)pins[pin].channel;
+}
+
+// ---------------------------------------------------------------------------
+bool nrf_drv_gpiote_in_is_set(nrf_drv_gpiote_pin_t pin)
+{
+  return sim_gpio_Get(pin);
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_gpiote_out_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_out_config_t const *p_config)
+{
+  ASSERT((pin < PINS_TOTAL) && p_config);
+  pin_t *p_pin = &pins[pin];
+  if (p_pin->is_in || p_pin->is_out)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  p_pin->channel = NO_CHANNEL;
+  if (p_config->task_pin)
+  {
+    p_pin->channel = channel_alloc();
+    if (p_pin->channel == NO_CHANNEL)
+    {
+      return NRF_ERROR_NO_MEM;
+    }
+  }
+  nrf_gpio_cfg_output(pin);
+  level_set(pin, p_config->init_state == NRF_GPIOTE_INITIAL_VALUE_HIGH);
+  p_pin->out_cfg = *p_config;
+  p_pin->is_out = true;
+  p_pin->is_task_enabled = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_out_uninit(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_out);
+  channel_free(pins[pin].channel);
+  pins[pin].is_out = false;
+  pins[pin].is_task_enabled = false;
+  nrf_gpio_cfg_default(pin);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_out_task_enable(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_out && (pins[pin].channel != NO_CHANNEL));
+  pins[pin].is_task_enabled = true;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_out_task_disable(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_out);
+  pins[pin].is_task_enabled = false;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_drv_gpiote_out_task_addr_get(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_out && (pins[pin].channel != NO_CHANNEL));
+  return NRF_GPIOTE_BASE + GPIOTE_TASKS_OUT + 4 * (uint32_t)pins[pin].channel;
+}
+
+// ---------------------------------------------------------------------------
+static void gpiote_task_out(uint8_t ch)
+{
+  for (uint32_t pin = 0; pin < PINS_TOTAL; pin++)
+  {
+    if (pins[pin].is_out && pins[pin].is_task_enabled && (pins[pin].channel == ch))
+    {
+      switch (pins[pin].out_cfg.action)
+      {
+        case NRF_GPIOTE_POLARITY_LOTOHI: level_set(pin, true);              break;
+        case NRF_GPIOTE_POLARITY_HITOLO: level_set(pin, false);             break;
+        default:                         level_set(pin, !pins[pin].level);  break;
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_gpiote_out_task_trigger(nrf_drv_gpiote_pin_t pin)
+{
+  ASSERT((pin < PINS_TOTAL) && pins[pin].is_out && (pins[pin].channel != NO_CHANNEL));
+  gpiote_task_out((uint8_t)pins[pin].channel);
+}
+
+// ---------------------------------------------------------------------------
+void sim_gpio_Pulse(uint32_t pin)
+{
+  ASSERT(pin < PINS_TOTAL);
+  pin_t *p_pin = &pins[pin];
+  if (!p_pin->is_in || !p_pin->is_evt_enabled || (p_pin->in_cfg.sense == NRF_GPIOTE_POLARITY_HITOLO))
+  {
+    return;
+  }
+
+  sim_ppi_Event(nrf_drv_gpiote_in_event_addr_get(pin));
+  if (p_pin->is_int_enabled)
+  {
+    if (p_pin->is_irq_pending)
+    {
+      gpiote_merged++;    // event flag is set already, handler runs once for both
+    }
+    p_pin->is_irq_pending = true;
+    sim_IrqPend(SIM_IRQ_GPIOTE);
+  }
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_gpiote_GetMerged(void)
+{
+  return gpiote_merged;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_gpiote_GetIrqCnt(void)
+{
+  return gpiote_irq_cnt;
+}
+
+// ----------------------------------------------------------------------------
+//    PPI
+// ----------------------------------------------------------------------------
+static void task_trigger(uint32_t tep);
+
+ret_code_t nrf_drv_ppi_init(void)
+{
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_ppi_channel_alloc(nrf_ppi_channel_t *p_channel)
+{
+  ASSERT(p_channel);
+  for (uint8_t ch = 0; ch < PPI_CH_TOTAL; ch++)
+  {
+    if (!ppi[ch].is_alloc)
+    {
+      ppi[ch] = (ppi_ch_t){.is_alloc = true};
+      *p_channel = (nrf_ppi_channel_t)ch;
+      return NRF_SUCCESS;
+    }
+  }
+  return NRF_ERROR_NO_MEM;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_ppi_channel_free(nrf_ppi_channel_t channel)
+{
+  if ((channel >= PPI_CH_TOTAL) || !ppi[channel].is_alloc)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  ppi[channel].is_alloc = false;
+  ppi[channel].is_enabled = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep)
+{
+  if ((channel >= PPI_CH_TOTAL) || !ppi[channel].is_alloc)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  ppi[channel].eep = eep;
+  ppi[channel].tep = tep;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_ppi_channel_enable(nrf_ppi_channel_t channel)
+{
+  if ((channel >= PPI_CH_TOTAL) || !ppi[channel].is_alloc)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  ppi[channel].is_enabled = true;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_ppi_channel_disable(nrf_ppi_channel_t channel)
+{
+  if ((channel >= PPI_CH_TOTAL) || !ppi[channel].is_alloc)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  ppi[channel].is_enabled = false;
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void sim_ppi_Event(uint32_t eep)
+{
+  for (uint8_t ch = 0; ch < PPI_CH_TOTAL; ch++)
+  {
+    if (ppi[ch].is_enabled && (ppi[ch].eep == eep) && ppi[ch].tep)
+    {
+      task_trigger(ppi[ch].tep);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+uint8_t sim_ppi_GetUsed(void)
+{
+  uint8_t used = 0;
+  for (uint8_t ch = 0; ch < PPI_CH_TOTAL; ch++)
+  {
+    used += ppi[ch].is_alloc;
+  }
+  return used;
+}
+
+// ----------------------------------------------------------------------------
+//    TIMER
+// ----------------------------------------------------------------------------
+static uint8_t timer_instance(NRF_TIMER_Type *p_reg)
+{
+  ptrdiff_t idx = p_reg - sim_timer_regs;
+  ASSERT((idx >= 0) && (idx < TIMERS_TOTAL));
+  return (uint8_t)idx;
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t counter_get(uint8_t id)
+{
+  tmr_model_t *p_tmr = &timers[id];
+  uint64_t cnt = p_tmr->base;
+  if (p_tmr->is_running && (p_tmr->mode == NRF_TIMER_MODE_TIMER))
+  {
+    cnt += (sim_GetUs() - p_tmr->start_us) * p_tmr->hz / SIM_US_PER_SEC;
+  }
+  return (uint32_t)cnt & p_tmr->mask;
+}
+
+// ---------------------------------------------------------------------------
+static void counter_set(uint8_t id, uint32_t value)
+{
+  timers[id].base = value & timers[id].mask;
+  timers[id].start_us = sim_GetUs();
+}
+
+static void compares_plan(uint8_t id);
+
+// ---------------------------------------------------------------------------
+// compare event of channel with PPI, shorts and interrupt
+static void compare_hit(uint8_t id, uint8_t ch)
+{
+  NRF_TIMER_Type *p_reg = &sim_timer_regs[id];
+  tmr_model_t *p_tmr = &timers[id];
+
+  p_reg->EVENTS_COMPARE[ch] = 1;
+  sim_ppi_Event(NRF_TIMER0_BASE + id * NRF_TIMER_STEP + NRF_TIMER_EVENT_COMPARE0 + 4 * ch);
+  if (p_reg->SHORTS & (TIMER_SHORTS_COMPARE0_CLEAR_Msk << ch))
+  {
+    counter_set(id, 0);
+  }
+  if (p_reg->SHORTS & (TIMER_SHORTS_COMPARE0_STOP_Msk << ch))
+  {
+    p_tmr->base = counter_get(id);
+    p_tmr->is_running = false;
+  }
+  if ((p_reg->INTENSET & (1ul << (TIMER_INTEN_POS + ch))) && p_tmr->handler)
+  {
+    sim_IrqPend((sim_irq_t)(SIM_IRQ_TIMER0 + id));
+  }
+  compares_plan(id);
+}
+
+// ---------------------------------------------------------------------------
+static void compare_evt(void *p_ctx)
+{
+  uintptr_t code = (uintptr_t)p_ctx;
+  uint8_t id = (uint8_t)(code >> 8);
+  uint8_t ch = (uint8_t)code;
+  timers[id].evt_id[ch] = -1;
+  compare_hit(id, ch);
+}
+
+// ---------------------------------------------------------------------------
+// running timer in timer mode: the next hit of every CC is put in virtual time
+static void compares_plan(uint8_t id)
+{
+  tmr_model_t *p_tmr = &timers[id];
+  for (uint8_t ch = 0; ch < 4; ch++)
+  {
+    sim_Cancel(p_tmr->evt_id[ch]);
+    p_tmr->evt_id[ch] = -1;
+    if (p_tmr->is_running && (p_tmr->mode == NRF_TIMER_MODE_TIMER))
+    {
+      uint32_t now = counter_get(id);
+      uint32_t ticks = (sim_timer_regs[id].CC[ch] - now) & p_tmr->mask;
+      if (ticks == 0)
+      {
+        ticks = p_tmr->mask + 1;    // counter is at CC already, event comes after wrap
+      }
+      uint64_t us = ((uint64_t)ticks * SIM_US_PER_SEC + p_tmr->hz - 1) / p_tmr->hz;
+      p_tmr->evt_id[ch] = sim_At(sim_GetUs() + us, compare_evt, (void*)(uintptr_t)((id << 8) | ch));
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void timer_task(uint8_t id, uint32_t task)
+{
+  tmr_model_t *p_tmr = &timers[id];
+  switch (task)
+  {
+    case NRF_TIMER_TASK_START:
+      if (!p_tmr->is_running)
+      {
+        counter_set(id, p_tmr->base);
+        p_tmr->is_running = true;
+      }
+      break;
+
+    case NRF_TIMER_TASK_STOP:
+    case NRF_TIMER_TASK_SHUTDOWN:
+      p_tmr->base = counter_get(id);
+      p_tmr->is_running = false;
+      break;
+
+    case NRF_TIMER_TASK_CLEAR:
+      counter_set(id, 0);
+      break;
+
+    case NRF_TIMER_TASK_COUNT:
+      if (p_tmr->is_running && (p_tmr->mode == NRF_TIMER_MODE_COUNTER))
+      {
+        counter_set(id, p_tmr->base + 1);
+        for (uint8_t ch = 0; ch < 4; ch++)
+        {
+          if (p_tmr->base == (sim_timer_regs[id].CC[ch] & p_tmr->mask))
+          {
+            compare_hit(id, ch);
+          }
+        }
+      }
+      break;
+
+    default:
+      if ((task >= NRF_TIMER_TASK_CAPTURE0) && (task <= NRF_TIMER_TASK_CAPTURE3))
+      {
+        sim_timer_regs[id].CC[(task - NRF_TIMER_TASK_CAPTURE0) / 4] = counter_get(id);
+      }
+      break;
+  }
+  compares_plan(id);
+}
+
+// ---------------------------------------------------------------------------
+// the driver IRQ handler: every enabled compare event is cleared and passed to user handler
+static void timer_irq(void *p_ctx)
+{
+  uint8_t id = (uint8_t)(uintptr_t)p_ctx;
+  NRF_TIMER_Type *p_reg = &sim_timer_regs[id];
+  for (uint8_t ch = 0; ch < 4; ch++)
+  {
+    if (p_reg->EVENTS_COMPARE[ch] && (p_reg->INTENSET & (1ul << (TIMER_INTEN_POS + ch))))
+    {
+      p_reg->EVENTS_COMPARE[ch] = 0;
+      timers[id].handler((nrf_timer_event_t)(NRF_TIMER_EVENT_COMPARE0 + 4 * ch), timers[id].p_context);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_timer_init(nrf_drv_timer_t const *p_instance, nrf_drv_timer_config_t const *p_config,
+                              nrf_timer_event_handler_t timer_event_handler)
+{
+  ASSERT(p_instance && p_config && timer_event_handler);
+  uint8_t id = timer_instance(p_instance->p_reg);
+  tmr_model_t *p_tmr = &timers[id];
+  if (p_tmr->is_init)
+  {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  static const uint32_t masks[] = {0xFFFF, 0xFF, 0xFFFFFF, 0xFFFFFFFF};
+  *p_tmr = (tmr_model_t)
+  {
+    .handler = timer_event_handler,
+    .p_context = p_config->p_context,
+    .mode = p_config->mode,
+    .mask = masks[p_config->bit_width],
+    .hz = 16000000ul >> p_config->frequency,
+    .evt_id = {-1, -1, -1, -1},
+    .is_init = true,
+  };
+  memset(p_instance->p_reg, 0, sizeof(NRF_TIMER_Type));
+  p_instance->p_reg->MODE = p_config->mode;
+  p_instance->p_reg->BITMODE = p_config->bit_width;
+  p_instance->p_reg->PRESCALER = p_config->frequency;
+  sim_IrqConnect((sim_irq_t)(SIM_IRQ_TIMER0 + id), timer_irq, (void*)(uintptr_t)id, 0);
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_uninit(nrf_drv_timer_t const *p_instance)
+{
+  uint8_t id = timer_instance(p_instance->p_reg);
+  timer_task(id, NRF_TIMER_TASK_SHUTDOWN);
+  timers[id].is_init = false;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_enable(nrf_drv_timer_t const *p_instance)
+{
+  uint8_t id = timer_instance(p_instance->p_reg);
+  ASSERT(timers[id].is_init);
+  timer_task(id, NRF_TIMER_TASK_START);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_disable(nrf_drv_timer_t const *p_instance)
+{
+  uint8_t id = timer_instance(p_instance->p_reg);
+  ASSERT(timers[id].is_init);
+  timer_task(id, NRF_TIMER_TASK_SHUTDOWN);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_clear(nrf_drv_timer_t const *p_instance)
+{
+  timer_task(timer_instance(p_instance->p_reg), NRF_TIMER_TASK_CLEAR);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_increment(nrf_drv_timer_t const *p_instance)
+{
+  timer_task(timer_instance(p_instance->p_reg), NRF_TIMER_TASK_COUNT);
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_drv_timer_capture(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel)
+{
+  uint8_t id = timer_instance(p_instance->p_reg);
+  timer_task(id, NRF_TIMER_TASK_CAPTURE0 + 4 * cc_channel);
+  return p_instance->p_reg->CC[cc_channel];
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel,
+                           uint32_t cc_value, bool enable_int)
+{
+  uint8_t id = timer_instance(p_instance->p_reg);
+  NRF_TIMER_Type *p_reg = p_instance->p_reg;
+  uint32_t int_mask = 1ul << (TIMER_INTEN_POS + cc_channel);
+  p_reg->EVENTS_COMPARE[cc_channel] = 0;
+  p_reg->INTENSET = enable_int ? (p_reg->INTENSET | int_mask) : (p_reg->INTENSET & ~int_mask);
+  p_reg->CC[cc_channel] = cc_value;
+  compares_plan(id);
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_timer_extended_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel,
+                                    uint32_t cc_value, nrf_timer_short_mask_t timer_short_mask,
+                                    bool enable_int)
+{
+  uint32_t channel_shorts = (TIMER_SHORTS_COMPARE0_CLEAR_Msk | TIMER_SHORTS_COMPARE0_STOP_Msk) << cc_channel;
+  p_instance->p_reg->SHORTS = (p_instance->p_reg->SHORTS & ~channel_shorts) | timer_short_mask;
+  nrf_drv_timer_compare(p_instance, cc_channel, cc_value, enable_int);
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_drv_timer_task_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_task_t timer_task)
+{
+  return NRF_TIMER0_BASE + timer_instance(p_instance->p_reg) * NRF_TIMER_STEP + timer_task;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_drv_timer_event_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_event_t timer_event)
+{
+  return NRF_TIMER0_BASE + timer_instance(p_instance->p_reg) * NRF_TIMER_STEP + timer_event;
+}
+
+// ---------------------------------------------------------------------------
+bool nrf_timer_event_check(NRF_TIMER_Type *p_timer, nrf_timer_event_t event)
+{
+  sim_CpuBusy(POLL_US);
+  return p_timer->EVENTS_COMPARE[(event - NRF_TIMER_EVENT_COMPARE0) / 4] != 0;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_timer_event_clear(NRF_TIMER_Type *p_timer, nrf_timer_event_t event)
+{
+  p_timer->EVENTS_COMPARE[(event - NRF_TIMER_EVENT_COMPARE0) / 4] = 0;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_timer, nrf_timer_task_t task)
+{
+  timer_task(timer_instance(p_timer), task);
+}
+
+// ---------------------------------------------------------------------------
+// PAN 73 workaround writes undocumented register, nothing to model
+void timer_anomaly_fix(NRF_TIMER_Type *base, uint8_t op)
+{
+  (void)timer_instance(base);
+  (void)op;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t sim_timer_Get(uint8_t instance)
+{
+  ASSERT(instance < TIMERS_TOTAL);
+  return counter_get(instance);
+}
+
+// ---------------------------------------------------------------------------
+bool sim_timer_IsRunning(uint8_t instance)
+{
+  ASSERT(instance < TIMERS_TOTAL);
+  return timers[instance].is_running;
+}
+
+// ----------------------------------------------------------------------------
+//    TASK ROUTING
+// ----------------------------------------------------------------------------
+static void task_trigger(uint32_t tep)
+{
+  if ((tep >= NRF_TIMER0_BASE) && (tep < NRF_TIMER0_BASE + TIMERS_TOTAL * NRF_TIMER_STEP))
+  {
+    timer_task((uint8_t)((tep - NRF_TIMER0_BASE) / NRF_TIMER_STEP), (tep - NRF_TIMER0_BASE) % NRF_TIMER_STEP);
+  }
+  else if ((tep >= NRF_GPIOTE_BASE + GPIOTE_TASKS_OUT) && (tep < NRF_GPIOTE_BASE + GPIOTE_TASKS_OUT + 4 * GPIOTE_CH_NUM))
+  {
+    gpiote_task_out((uint8_t)((tep - NRF_GPIOTE_BASE - GPIOTE_TASKS_OUT) / 4));
+  }
+  else
+  {
+    ASSERT(false);    // task isn't modelled
+  }
+}
+
+// ----------------------------------------------------------------------------
+//    LPCOMP
+// ----------------------------------------------------------------------------
+static void lpcomp_irq(void *p_ctx)
+{
+  (void)p_ctx;
+  if (lpcomp.evt_up && (lpcomp.int_mask & NRF_LPCOMP_INT_UP_MASK))
+  {
+    lpcomp.evt_up = false;
+    lpcomp.handler(NRF_LPCOMP_EVENT_UP);
+  }
+}
+
+// ---------------------------------------------------------------------------
+ret_code_t nrf_drv_lpcomp_init(nrf_drv_lpcomp_config_t const *p_config, lpcomp_events_handler_t events_handler)
+{
+  ASSERT(p_config && events_handler);
+  ASSERT(p_config->hal.detection == NRF_LPCOMP_DETECT_UP);
+  lpcomp.handler = events_handler;
+  lpcomp.int_mask = NRF_LPCOMP_INT_UP_MASK;
+  sim_IrqConnect(SIM_IRQ_LPCOMP, lpcomp_irq, NULL, 0);
+  return NRF_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_lpcomp_enable(void)
+{
+  lpcomp.is_enabled = true;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_drv_lpcomp_disable(void)
+{
+  lpcomp.is_enabled = false;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t nrf_lpcomp_event_address_get(nrf_lpcomp_event_t event)
+{
+  return NRF_LPCOMP_BASE + event;
+}
+
+// ---------------------------------------------------------------------------
+bool nrf_lpcomp_event_check(nrf_lpcomp_event_t event)
+{
+  ASSERT(event == NRF_LPCOMP_EVENT_UP);
+  return lpcomp.evt_up;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_lpcomp_event_clear(nrf_lpcomp_event_t event)
+{
+  ASSERT(event == NRF_LPCOMP_EVENT_UP);
+  lpcomp.evt_up = false;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_lpcomp_int_enable(uint32_t lpcomp_int_mask)
+{
+  lpcomp.int_mask |= lpcomp_int_mask;
+}
+
+// ---------------------------------------------------------------------------
+void nrf_lpcomp_int_disable(uint32_t lpcomp_int_mask)
+{
+  lpcomp.int_mask &= ~lpcomp_int_mask;
+}
+
+// ---------------------------------------------------------------------------
+void sim_lpcomp_Set(bool is_above)
+{
+  bool is_up = is_above && !lpcomp.is_above;
+  lpcomp.is_above = is_above;
+  if (is_up && lpcomp.is_enabled)
+  {
+    lpcomp.evt_up = true;
+    sim_ppi_Event(nrf_lpcomp_event_address_get(NRF_LPCOMP_EVENT_UP));
+    if (lpcomp.int_mask & NRF_LPCOMP_INT_UP_MASK)
+    {
+      sim_IrqPend(SIM_IRQ_LPCOMP);
+    }
+  }
+}
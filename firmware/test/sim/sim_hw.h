@@ -0,0 +1,59 @@
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf_gpio.h"
+
+/*!
+ * \brief nRF51 peripheral models behind the SDK driver stand-ins.
+ * GPIOTE, PPI, TIMER and LPCOMP are modelled on register level: events are routed
+ * by address through PPI to tasks, TIMER compares come in virtual time, interrupts
+ * go through sim.c lines, so a pulse coming while GPIOTE interrupt is pending is merged
+ * with it like on the chip.
+ */
+
+#define SIM_PULSE_ISR_US    8     // GPIOTE handler of pulse pin with SDK driver overhead
+
+// ----------------------------------------------------------------------------
+/*! ---------------------------------------------------------------------------
+  \brief External rising edge on input pin
+ ----------------------------------------------------------------------------*/
+void sim_gpio_Pulse(uint32_t pin);
+
+// Output level driven by CPU or GPIOTE task
+bool sim_gpio_Get(uint32_t pin);
+
+nrf_gpio_pin_pull_t sim_gpio_GetPull(uint32_t pin);
+
+// Observers of output level change, e.g. external circuit model or test probe
+typedef void (*sim_gpio_observer_t)(uint32_t pin, bool level);
+void sim_gpio_Observe(sim_gpio_observer_t observer);
+
+/*! ---------------------------------------------------------------------------
+  \brief GPIOTE pulse interrupts merged with a pending one, so handler missed them
+ ----------------------------------------------------------------------------*/
+uint32_t sim_gpiote_GetMerged(void);
+
+// Interrupt handler calls of GPIOTE
+uint32_t sim_gpiote_GetIrqCnt(void);
+
+// ----------------------------------------------------------------------------
+// Counter value of running or stopped TIMER, as CAPTURE task would give
+uint32_t sim_timer_Get(uint8_t instance);
+
+bool sim_timer_IsRunning(uint8_t instance);
+
+// ----------------------------------------------------------------------------
+/*! ---------------------------------------------------------------------------
+  \brief Feedback comparator input: true if above reference
+ ----------------------------------------------------------------------------*/
+void sim_lpcomp_Set(bool is_above);
+
+// ----------------------------------------------------------------------------
+// Event address is routed to tasks of enabled PPI channels
+void sim_ppi_Event(uint32_t eep);
+
+uint8_t sim_ppi_GetUsed(void);
+
+#endif // SIM_HW_H
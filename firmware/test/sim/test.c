@@ -0,0 +1,33 @@
+#include <math.h>
+#include "test.h"
+
+int test_failed;
+
+static uint32_t rnd = 2463534242ul;
+
+// ---------------------------------------------------------------------------
+void test_Seed(uint32_t seed)
+{
+  rnd = seed ? seed : 2463534242ul;
+}
+
+// ---------------------------------------------------------------------------
+uint32_t test_Rand(void)
+{
+  rnd ^= rnd << 13;
+  rnd ^= rnd >> 17;
+  rnd ^= rnd << 5;
+  return rnd;
+}
+
+// ---------------------------------------------------------------------------
+double test_Uniform(void)
+{
+  return ((double)test_Rand() + 1.0) / 4294967296.0;
+}
+
+// ---------------------------------------------------------------------------
+double test_Exp(double mean)
+{
+  return -mean * log(test_Uniform());
+}
@@ -0,0 +1,68 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+/*!
+ * \brief Minimal checks of host tests. A failed check is reported and counted, test
+ * goes on, so one run shows every broken property. Exit code of main is TEST_RESULT().
+ */
+
+extern int test_failed;
+
+#define CHECK(expr)                                                               \
+  do                                                                              \
+  {                                                                               \
+    if (!(expr))                                                                  \
+    {                                                                             \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr);             \
+      test_failed++;                                                              \
+    }                                                                             \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                            \
+  do                                                                              \
+  {                                                                               \
+    long long _a = (long long)(a), _b = (long long)(b);                           \
+    if (_a != _b)                                                                 \
+    {                                                                             \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",                    \
+             __FILE__, __LINE__, #a, #b, _a, _b);                                 \
+      test_failed++;                                                              \
+    }                                                                             \
+  } while (0)
+
+// |a - b| <= tol
+#define CHECK_NEAR(a, b, tol)                                                     \
+  do                                                                              \
+  {                                                                               \
+    double _a = (double)(a), _b = (double)(b);                                    \
+    if (!(fabs(_a - _b) <= (double)(tol)))                                        \
+    {                                                                             \
+      printf("%s:%d: CHECK_NEAR(%s, %s, %s) failed: %g vs %g\n",                  \
+             __FILE__, __LINE__, #a, #b, #tol, _a, _b);                           \
+      test_failed++;                                                              \
+    }                                                                             \
+  } while (0)
+
+#define TEST_RUN(fn)                                                              \
+  do                                                                              \
+  {                                                                               \
+    int _before = test_failed;                                                    \
+    fn();                                                                         \
+    printf("%-40s %s\n", #fn, (test_failed == _before) ? "ok" : "FAILED");        \
+  } while (0)
+
+#define TEST_RESULT()   ((test_failed == 0) ? 0 : 1)
+
+// deterministic generator of tests, xorshift32
+uint32_t test_Rand(void);
+void     test_Seed(uint32_t seed);
+// uniform (0, 1]
+double   test_Uniform(void);
+// exponential interval with given mean
+double   test_Exp(double mean);
+
+#endif // TEST_H
@@ -0,0 +1,25 @@
+#ifndef APP_ERROR_H__
+#define APP_ERROR_H__
+
+// Host stand-in: error code other than NRF_SUCCESS stops the test
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nrf_assert.h"
+
+void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t *p_file_name);
+
+#define APP_ERROR_HANDLER(err_code)                                         \
+  app_error_handler((err_code), __LINE__, (const uint8_t*)__FILE__)
+
+#define APP_ERROR_CHECK(err_code)                                           \
+  do                                                                        \
+  {                                                                         \
+    const uint32_t LOCAL_ERR_CODE = (err_code);                             \
+    if (LOCAL_ERR_CODE != NRF_SUCCESS)                                      \
+    {                                                                       \
+      APP_ERROR_HANDLER(LOCAL_ERR_CODE);                                    \
+    }                                                                       \
+  } while (0)
+
+#endif // APP_ERROR_H__
@@ -0,0 +1,61 @@
+#ifndef APP_TIMER_H__
+#define APP_TIMER_H__
+
+/*!
+ * \brief Host stand-in of SDK 12.3 app_timer on the virtual 32768 Hz clock of sim.c.
+ * Semantics kept from SDK: RTC1 counter is 24 bit, timeout is [APP_TIMER_MIN_TIMEOUT_TICKS
+ * ... 0xFFFFFF] ticks, start of a running timer is ignored, repeated timer keeps its period
+ * from the previous expiration, handlers run in RTC1 interrupt context.
+ * Start and stop requested from interrupt context wait in the operation queue of
+ * OP_QUEUE_SIZE until the interrupt returns, overflow gives NRF_ERROR_NO_MEM.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "app_error.h"
+#include "app_util_platform.h"
+
+#define APP_TIMER_CLOCK_FREQ          32768
+#define APP_TIMER_MIN_TIMEOUT_TICKS   5
+
+typedef void (*app_timer_timeout_handler_t)(void *p_context);
+
+typedef enum
+{
+  APP_TIMER_MODE_SINGLE_SHOT,
+  APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+typedef struct app_timer_s
+{
+  struct app_timer_s          *p_next;
+  app_timer_timeout_handler_t handler;
+  void                        *p_context;
+  uint64_t                    expiry;       // virtual clock tick
+  uint32_t                    period;
+  app_timer_mode_t            mode;
+  bool                        is_running;
+} app_timer_t;
+
+typedef app_timer_t *app_timer_id_t;
+
+#define APP_TIMER_DEF(timer_id)                   \
+  static app_timer_t timer_id##_data;             \
+  static const app_timer_id_t timer_id = &timer_id##_data
+
+#define APP_TIMER_TICKS(MS, PRESCALER)            \
+  ((uint32_t)(((uint64_t)(MS) * APP_TIMER_CLOCK_FREQ) / (((PRESCALER) + 1) * 1000)))
+
+#define APP_TIMER_INIT(PRESCALER, OP_QUEUE_SIZE, SCHEDULER_FUNC)  app_timer_sim_init(OP_QUEUE_SIZE)
+
+void       app_timer_sim_init(uint32_t op_queue_size);
+
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+uint32_t   app_timer_cnt_get(void);
+uint32_t   app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from, uint32_t *p_ticks_diff);
+
+#endif // APP_TIMER_H__
@@ -0,0 +1,31 @@
+#ifndef APP_UTIL_PLATFORM_H__
+#define APP_UTIL_PLATFORM_H__
+
+// Host stand-in: there are no asynchronous interrupts in simulation. Critical region
+// only keeps nesting depth, so tests can check what runs inside of it
+
+#include <stdint.h>
+#include "nordic_common.h"
+#ifdef SOFTDEVICE_PRESENT
+#include "nrf_soc.h"      // like SDK one
+#endif
+
+#define APP_IRQ_PRIORITY_HIGHEST  0
+#define APP_IRQ_PRIORITY_HIGH     1
+#define APP_IRQ_PRIORITY_LOW      3
+
+void sim_CriticalEnter(void);
+void sim_CriticalExit(void);
+void sim_Barrier(void);
+
+#define CRITICAL_REGION_ENTER()   { sim_CriticalEnter();
+#define CRITICAL_REGION_EXIT()      sim_CriticalExit(); }
+
+#define __DMB()                   sim_Barrier()
+#define __DSB()                   __sync_synchronize()
+#define __ISB()                   __sync_synchronize()
+#define __WFE()
+#define __SEV()
+#define __NOP()
+
+#endif // APP_UTIL_PLATFORM_H__
@@ -0,0 +1,23 @@
+#ifndef NORDIC_COMMON_H__
+#define NORDIC_COMMON_H__
+
+// Host stand-in of SDK 12.3 nordic_common.h and compiler_abstraction.h parts in use
+
+#define MIN(a, b)             ((a) < (b) ? (a) : (b))
+#define MAX(a, b)             ((a) < (b) ? (b) : (a))
+#define ARRAY_SIZE(arr)       (sizeof(arr) / sizeof((arr)[0]))
+#define CONCAT_2(p1, p2)      CONCAT_2_(p1, p2)
+#define CONCAT_2_(p1, p2)     p1##p2
+#define CONCAT_3(p1, p2, p3)  CONCAT_3_(p1, p2, p3)
+#define CONCAT_3_(p1, p2, p3) p1##p2##p3
+#define STATIC_ASSERT(EXPR)   _Static_assert((EXPR), #EXPR)
+#define UNUSED_PARAMETER(X)   (void)(X)
+#define UNUSED_VARIABLE(X)    (void)(X)
+#define IS_POWER_OF_TWO(A)    (((A) != 0) && ((((A) - 1) & (A)) == 0))
+
+#define __PACKED              __attribute__((packed))
+#define __ALIGN(n)            __attribute__((aligned(n)))
+#define __WEAK                __attribute__((weak))
+#define __STATIC_INLINE       static inline
+
+#endif // NORDIC_COMMON_H__
@@ -0,0 +1,60 @@
+#ifndef NRF_H
+#define NRF_H
+
+/*!
+ * \brief Host stand-in of nRF51 peripheral registers.
+ * Register blocks are plain memory inside simulation, peripheral behaviour is modelled by
+ * sim_hw.c through the driver functions. Event and task addresses are the real nRF51
+ * ones, so PPI wiring can be followed by address.
+ */
+
+#include <stdint.h>
+
+#define NRF_GPIOTE_BASE   0x40006000ul
+#define NRF_TIMER0_BASE   0x40008000ul
+#define NRF_TIMER1_BASE   0x40009000ul
+#define NRF_TIMER2_BASE   0x4000A000ul
+#define NRF_RTC1_BASE     0x40011000ul
+#define NRF_LPCOMP_BASE   0x40013000ul
+#define NRF_TIMER_STEP    (NRF_TIMER1_BASE - NRF_TIMER0_BASE)
+
+typedef struct
+{
+  volatile uint32_t TASKS_START;
+  volatile uint32_t TASKS_STOP;
+  volatile uint32_t TASKS_COUNT;
+  volatile uint32_t TASKS_CLEAR;
+  volatile uint32_t TASKS_SHUTDOWN;
+  volatile uint32_t TASKS_CAPTURE[4];
+  volatile uint32_t EVENTS_COMPARE[4];
+  volatile uint32_t SHORTS;
+  volatile uint32_t INTENSET;
+  volatile uint32_t INTENCLR;
+  volatile uint32_t MODE;
+  volatile uint32_t BITMODE;
+  volatile uint32_t PRESCALER;
+  volatile uint32_t CC[4];
+} NRF_TIMER_Type;
+
+typedef struct
+{
+  volatile uint32_t PIN_CNF[32];
+} NRF_GPIO_Type;
+
+extern NRF_TIMER_Type sim_timer_regs[3];
+extern NRF_GPIO_Type  sim_gpio_regs;
+
+#define NRF_TIMER0    (&sim_timer_regs[0])
+#define NRF_TIMER1    (&sim_timer_regs[1])
+#define NRF_TIMER2    (&sim_timer_regs[2])
+#define NRF_GPIO      (&sim_gpio_regs)
+
+#define TIMER_SHORTS_COMPARE0_CLEAR_Msk   (1ul << 0)
+#define TIMER_SHORTS_COMPARE3_CLEAR_Msk   (1ul << 3)
+#define TIMER_SHORTS_COMPARE0_STOP_Msk    (1ul << 8)
+#define TIMER_SHORTS_COMPARE3_STOP_Msk    (1ul << 11)
+
+#define GPIO_PIN_CNF_PULL_Pos   2
+#define GPIO_PIN_CNF_PULL_Msk   (0x3ul << GPIO_PIN_CNF_PULL_Pos)
+
+#endif // NRF_H
@@ -0,0 +1,17 @@
+#ifndef NRF_ASSERT_H__
+#define NRF_ASSERT_H__
+
+// Host stand-in: failed assertion stops the test with file and line
+
+void sim_AssertFailed(const char *file, int line, const char *expr);
+
+#define ASSERT(expr)                                            \
+  do                                                            \
+  {                                                             \
+    if (!(expr))                                                \
+    {                                                           \
+      sim_AssertFailed(__FILE__, __LINE__, #expr);              \
+    }                                                           \
+  } while (0)
+
+#endif // NRF_ASSERT_H__
@@ -0,0 +1,9 @@
+#ifndef NRF_DELAY_H__
+#define NRF_DELAY_H__
+
+#include <stdint.h>
+
+// busy wait advances the virtual clock
+void nrf_delay_us(uint32_t us);
+
+#endif // NRF_DELAY_H__
@@ -0,0 +1,73 @@
+#ifndef NRF_DRV_GPIOTE_H__
+#define NRF_DRV_GPIOTE_H__
+
+// Host stand-in of SDK 12.3 GPIOTE driver. Input with hi_accuracy takes one of 4 channels,
+// others use PORT event like SDK does
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_gpio.h"
+
+#define GPIOTE_CH_NUM   4
+
+typedef uint32_t nrf_drv_gpiote_pin_t;
+
+typedef enum
+{
+  NRF_GPIOTE_POLARITY_LOTOHI = 1,
+  NRF_GPIOTE_POLARITY_HITOLO = 2,
+  NRF_GPIOTE_POLARITY_TOGGLE = 3
+} nrf_gpiote_polarity_t;
+
+typedef enum
+{
+  NRF_GPIOTE_INITIAL_VALUE_LOW  = 0,
+  NRF_GPIOTE_INITIAL_VALUE_HIGH = 1
+} nrf_gpiote_outinit_t;
+
+typedef struct
+{
+  nrf_gpiote_polarity_t sense;
+  nrf_gpio_pin_pull_t   pull;
+  bool                  is_watcher;
+  bool                  hi_accuracy;
+} nrf_drv_gpiote_in_config_t;
+
+typedef struct
+{
+  nrf_gpiote_polarity_t action;
+  nrf_gpiote_outinit_t  init_state;
+  bool                  task_pin;
+} nrf_drv_gpiote_out_config_t;
+
+#define GPIOTE_CONFIG_IN_SENSE_LOTOHI(hi_accu)  \
+  {.sense = NRF_GPIOTE_POLARITY_LOTOHI, .pull = NRF_GPIO_PIN_NOPULL, .is_watcher = false, .hi_accuracy = hi_accu}
+#define GPIOTE_CONFIG_IN_SENSE_HITOLO(hi_accu)  \
+  {.sense = NRF_GPIOTE_POLARITY_HITOLO, .pull = NRF_GPIO_PIN_NOPULL, .is_watcher = false, .hi_accuracy = hi_accu}
+#define GPIOTE_CONFIG_IN_SENSE_TOGGLE(hi_accu)  \
+  {.sense = NRF_GPIOTE_POLARITY_TOGGLE, .pull = NRF_GPIO_PIN_NOPULL, .is_watcher = false, .hi_accuracy = hi_accu}
+#define GPIOTE_CONFIG_OUT_TASK_TOGGLE(init_high)  \
+  {.action = NRF_GPIOTE_POLARITY_TOGGLE, .init_state = (init_high), .task_pin = true}
+
+typedef void (*nrf_drv_gpiote_evt_handler_t)(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
+
+ret_code_t nrf_drv_gpiote_init(void);
+bool       nrf_drv_gpiote_is_init(void);
+
+ret_code_t nrf_drv_gpiote_in_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_in_config_t const *p_config,
+                                  nrf_drv_gpiote_evt_handler_t evt_handler);
+void       nrf_drv_gpiote_in_uninit(nrf_drv_gpiote_pin_t pin);
+void       nrf_drv_gpiote_in_event_enable(nrf_drv_gpiote_pin_t pin, bool int_enable);
+void       nrf_drv_gpiote_in_event_disable(nrf_drv_gpiote_pin_t pin);
+uint32_t   nrf_drv_gpiote_in_event_addr_get(nrf_drv_gpiote_pin_t pin);
+bool       nrf_drv_gpiote_in_is_set(nrf_drv_gpiote_pin_t pin);
+
+ret_code_t nrf_drv_gpiote_out_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_out_config_t const *p_config);
+void       nrf_drv_gpiote_out_uninit(nrf_drv_gpiote_pin_t pin);
+void       nrf_drv_gpiote_out_task_enable(nrf_drv_gpiote_pin_t pin);
+void       nrf_drv_gpiote_out_task_disable(nrf_drv_gpiote_pin_t pin);
+uint32_t   nrf_drv_gpiote_out_task_addr_get(nrf_drv_gpiote_pin_t pin);
+void       nrf_drv_gpiote_out_task_trigger(nrf_drv_gpiote_pin_t pin);
+
+#endif // NRF_DRV_GPIOTE_H__
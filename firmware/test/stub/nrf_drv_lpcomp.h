@@ -0,0 +1,73 @@
+#ifndef NRF_DRV_LPCOMP_H__
+#define NRF_DRV_LPCOMP_H__
+
+// Host stand-in of SDK 12.3 LPCOMP driver and HAL. Comparator input is driven by test
+// through sim_lpcomp_Set() or by HV converter model
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+
+typedef enum
+{
+  NRF_LPCOMP_EVENT_READY = 0x100,
+  NRF_LPCOMP_EVENT_DOWN  = 0x104,
+  NRF_LPCOMP_EVENT_UP    = 0x108,
+  NRF_LPCOMP_EVENT_CROSS = 0x10C
+} nrf_lpcomp_event_t;
+
+typedef enum
+{
+  NRF_LPCOMP_DETECT_CROSS,
+  NRF_LPCOMP_DETECT_UP,
+  NRF_LPCOMP_DETECT_DOWN
+} nrf_lpcomp_detect_t;
+
+typedef enum
+{
+  NRF_LPCOMP_INPUT_0, NRF_LPCOMP_INPUT_1, NRF_LPCOMP_INPUT_2, NRF_LPCOMP_INPUT_3,
+  NRF_LPCOMP_INPUT_4, NRF_LPCOMP_INPUT_5, NRF_LPCOMP_INPUT_6, NRF_LPCOMP_INPUT_7
+} nrf_lpcomp_input_t;
+
+typedef enum
+{
+  NRF_LPCOMP_REF_SUPPLY_1_8 = 0,
+  NRF_LPCOMP_REF_EXT_REF0   = 7,
+  NRF_LPCOMP_REF_EXT_REF1   = 0x10007
+} nrf_lpcomp_ref_t;
+
+typedef enum
+{
+  NRF_LPCOMP_INT_READY_MASK = 1ul << 0,
+  NRF_LPCOMP_INT_DOWN_MASK  = 1ul << 1,
+  NRF_LPCOMP_INT_UP_MASK    = 1ul << 2,
+  NRF_LPCOMP_INT_CROSS_MASK = 1ul << 3
+} nrf_lpcomp_int_mask_t;
+
+typedef struct
+{
+  nrf_lpcomp_ref_t    reference;
+  nrf_lpcomp_detect_t detection;
+} nrf_lpcomp_config_t;
+
+typedef struct
+{
+  nrf_lpcomp_config_t hal;
+  nrf_lpcomp_input_t  input;
+  uint8_t             interrupt_priority;
+} nrf_drv_lpcomp_config_t;
+
+typedef void (*lpcomp_events_handler_t)(nrf_lpcomp_event_t event);
+
+ret_code_t nrf_drv_lpcomp_init(nrf_drv_lpcomp_config_t const *p_config, lpcomp_events_handler_t events_handler);
+void       nrf_drv_lpcomp_enable(void);
+void       nrf_drv_lpcomp_disable(void);
+
+uint32_t   nrf_lpcomp_event_address_get(nrf_lpcomp_event_t event);
+bool       nrf_lpcomp_event_check(nrf_lpcomp_event_t event);
+void       nrf_lpcomp_event_clear(nrf_lpcomp_event_t event);
+void       nrf_lpcomp_int_enable(uint32_t lpcomp_int_mask);
+void       nrf_lpcomp_int_disable(uint32_t lpcomp_int_mask);
+
+#endif // NRF_DRV_LPCOMP_H__
@@ -0,0 +1,22 @@
+#ifndef NRF_DRV_PPI_H
+#define NRF_DRV_PPI_H
+
+// Host stand-in of SDK 12.3 PPI driver. Channels 0-7 are given to application like S130 does
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+typedef enum
+{
+  NRF_PPI_CHANNEL0,  NRF_PPI_CHANNEL1,  NRF_PPI_CHANNEL2,  NRF_PPI_CHANNEL3,
+  NRF_PPI_CHANNEL4,  NRF_PPI_CHANNEL5,  NRF_PPI_CHANNEL6,  NRF_PPI_CHANNEL7,
+} nrf_ppi_channel_t;
+
+ret_code_t nrf_drv_ppi_init(void);
+ret_code_t nrf_drv_ppi_channel_alloc(nrf_ppi_channel_t *p_channel);
+ret_code_t nrf_drv_ppi_channel_free(nrf_ppi_channel_t channel);
+ret_code_t nrf_drv_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep);
+ret_code_t nrf_drv_ppi_channel_enable(nrf_ppi_channel_t channel);
+ret_code_t nrf_drv_ppi_channel_disable(nrf_ppi_channel_t channel);
+
+#endif // NRF_DRV_PPI_H
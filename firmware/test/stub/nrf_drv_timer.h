@@ -0,0 +1,53 @@
+#ifndef NRF_DRV_TIMER_H__
+#define NRF_DRV_TIMER_H__
+
+// Host stand-in of SDK 12.3 TIMER driver
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_timer.h"
+
+
+typedef struct
+{
+  NRF_TIMER_Type  *p_reg;
+  uint8_t         instance_id;
+  uint8_t         cc_channel_count;
+} nrf_drv_timer_t;
+
+#define NRF_DRV_TIMER_INSTANCE(id)    \
+{                                     \
+  .p_reg            = &sim_timer_regs[id], \
+  .instance_id      = (id),           \
+  .cc_channel_count = 4,              \
+}
+
+typedef struct
+{
+  nrf_timer_frequency_t frequency;
+  nrf_timer_mode_t      mode;
+  nrf_timer_bit_width_t bit_width;
+  uint8_t               interrupt_priority;
+  void                  *p_context;
+} nrf_drv_timer_config_t;
+
+typedef void (*nrf_timer_event_handler_t)(nrf_timer_event_t event_type, void *p_context);
+
+ret_code_t nrf_drv_timer_init(nrf_drv_timer_t const *p_instance, nrf_drv_timer_config_t const *p_config,
+                              nrf_timer_event_handler_t timer_event_handler);
+void       nrf_drv_timer_uninit(nrf_drv_timer_t const *p_instance);
+void       nrf_drv_timer_enable(nrf_drv_timer_t const *p_instance);
+void       nrf_drv_timer_disable(nrf_drv_timer_t const *p_instance);
+void       nrf_drv_timer_clear(nrf_drv_timer_t const *p_instance);
+void       nrf_drv_timer_increment(nrf_drv_timer_t const *p_instance);
+uint32_t   nrf_drv_timer_capture(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel);
+void       nrf_drv_timer_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel,
+                                 uint32_t cc_value, bool enable_int);
+void       nrf_drv_timer_extended_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel,
+                                          uint32_t cc_value, nrf_timer_short_mask_t timer_short_mask,
+                                          bool enable_int);
+uint32_t   nrf_drv_timer_task_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_task_t timer_task);
+uint32_t   nrf_drv_timer_event_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_event_t timer_event);
+
+#endif // NRF_DRV_TIMER_H__
@@ -0,0 +1,6 @@
+#ifndef NRF_ERROR_H__
+#define NRF_ERROR_H__
+
+#include "sdk_errors.h"
+
+#endif // NRF_ERROR_H__
@@ -0,0 +1,56 @@
+#ifndef NRF_GPIO_H__
+#define NRF_GPIO_H__
+
+// Host stand-in of SDK 12.3 nrf_gpio.h. Pin configuration is kept in NRF_GPIO->PIN_CNF,
+// output levels are kept by sim_hw.c
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf.h"
+#include "nordic_common.h"
+
+typedef enum
+{
+  NRF_GPIO_PIN_NOPULL   = 0,
+  NRF_GPIO_PIN_PULLDOWN = 1,
+  NRF_GPIO_PIN_PULLUP   = 3,
+} nrf_gpio_pin_pull_t;
+
+typedef enum
+{
+  NRF_GPIO_PIN_DIR_INPUT,
+  NRF_GPIO_PIN_DIR_OUTPUT
+} nrf_gpio_pin_dir_t;
+
+typedef enum
+{
+  NRF_GPIO_PIN_INPUT_CONNECT,
+  NRF_GPIO_PIN_INPUT_DISCONNECT
+} nrf_gpio_pin_input_t;
+
+typedef enum
+{
+  NRF_GPIO_PIN_S0S1 = 0,
+  NRF_GPIO_PIN_H0H1 = 3,
+} nrf_gpio_pin_drive_t;
+
+typedef enum
+{
+  NRF_GPIO_PIN_NOSENSE = 0,
+  NRF_GPIO_PIN_SENSE_HIGH = 2,
+  NRF_GPIO_PIN_SENSE_LOW = 3,
+} nrf_gpio_pin_sense_t;
+
+void nrf_gpio_cfg(uint32_t pin_number, nrf_gpio_pin_dir_t dir, nrf_gpio_pin_input_t input,
+                  nrf_gpio_pin_pull_t pull, nrf_gpio_pin_drive_t drive, nrf_gpio_pin_sense_t sense);
+void nrf_gpio_cfg_output(uint32_t pin_number);
+void nrf_gpio_cfg_input(uint32_t pin_number, nrf_gpio_pin_pull_t pull_config);
+void nrf_gpio_cfg_default(uint32_t pin_number);
+void nrf_gpio_pin_set(uint32_t pin_number);
+void nrf_gpio_pin_clear(uint32_t pin_number);
+void nrf_gpio_pin_toggle(uint32_t pin_number);
+void nrf_gpio_pin_write(uint32_t pin_number, uint32_t value);
+uint32_t nrf_gpio_pin_read(uint32_t pin_number);
+NRF_GPIO_Type *nrf_gpio_pin_port_decode(uint32_t *p_pin);
+
+#endif // NRF_GPIO_H__
@@ -0,0 +1,16 @@
+#ifndef NRF_LOG_H_
+#define NRF_LOG_H_
+
+// Host stand-in: log goes to stdout when SIM_LOG environment variable is set.
+// The header is included once per module after NRF_LOG_MODULE_NAME like SDK one.
+
+void sim_Log(const char *fmt, ...);
+
+#define NRF_LOG_ERROR(...)          sim_Log(__VA_ARGS__)
+#define NRF_LOG_WARNING(...)        sim_Log(__VA_ARGS__)
+#define NRF_LOG_INFO(...)           sim_Log(__VA_ARGS__)
+#define NRF_LOG_DEBUG(...)          sim_Log(__VA_ARGS__)
+#define NRF_LOG_HEXDUMP_INFO(p, n)  (void)(p), (void)(n)
+#define NRF_LOG_HEXDUMP_DEBUG(p, n) (void)(p), (void)(n)
+
+#endif // NRF_LOG_H_
@@ -0,0 +1,11 @@
+#ifndef NRF_LOG_CTRL_H
+#define NRF_LOG_CTRL_H
+
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#define NRF_LOG_INIT(timestamp_func)  NRF_SUCCESS
+#define NRF_LOG_PROCESS()             false
+#define NRF_LOG_FLUSH()
+
+#endif // NRF_LOG_CTRL_H
@@ -0,0 +1,8 @@
+#ifndef NRF_SOC_H__
+#define NRF_SOC_H__
+
+#include <stdint.h>
+
+uint32_t sd_app_evt_wait(void);
+
+#endif // NRF_SOC_H__
@@ -0,0 +1,80 @@
+#ifndef NRF_TIMER_H__
+#define NRF_TIMER_H__
+
+// Host stand-in of SDK 12.3 TIMER HAL, task and event values are register offsets
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nrf.h"
+
+typedef enum
+{
+  NRF_TIMER_TASK_START    = 0x000,
+  NRF_TIMER_TASK_STOP     = 0x004,
+  NRF_TIMER_TASK_COUNT    = 0x008,
+  NRF_TIMER_TASK_CLEAR    = 0x00C,
+  NRF_TIMER_TASK_SHUTDOWN = 0x010,
+  NRF_TIMER_TASK_CAPTURE0 = 0x040,
+  NRF_TIMER_TASK_CAPTURE1 = 0x044,
+  NRF_TIMER_TASK_CAPTURE2 = 0x048,
+  NRF_TIMER_TASK_CAPTURE3 = 0x04C,
+} nrf_timer_task_t;
+
+typedef enum
+{
+  NRF_TIMER_EVENT_COMPARE0 = 0x140,
+  NRF_TIMER_EVENT_COMPARE1 = 0x144,
+  NRF_TIMER_EVENT_COMPARE2 = 0x148,
+  NRF_TIMER_EVENT_COMPARE3 = 0x14C,
+} nrf_timer_event_t;
+
+typedef enum
+{
+  NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK = TIMER_SHORTS_COMPARE0_CLEAR_Msk,
+  NRF_TIMER_SHORT_COMPARE3_CLEAR_MASK = TIMER_SHORTS_COMPARE3_CLEAR_Msk,
+  NRF_TIMER_SHORT_COMPARE0_STOP_MASK  = TIMER_SHORTS_COMPARE0_STOP_Msk,
+  NRF_TIMER_SHORT_COMPARE3_STOP_MASK  = TIMER_SHORTS_COMPARE3_STOP_Msk,
+} nrf_timer_short_mask_t;
+
+typedef enum
+{
+  NRF_TIMER_MODE_TIMER,
+  NRF_TIMER_MODE_COUNTER
+} nrf_timer_mode_t;
+
+typedef enum
+{
+  NRF_TIMER_BIT_WIDTH_16 = 0,
+  NRF_TIMER_BIT_WIDTH_8  = 1,
+  NRF_TIMER_BIT_WIDTH_24 = 2,
+  NRF_TIMER_BIT_WIDTH_32 = 3
+} nrf_timer_bit_width_t;
+
+typedef enum
+{
+  NRF_TIMER_FREQ_16MHz = 0,
+  NRF_TIMER_FREQ_8MHz,
+  NRF_TIMER_FREQ_4MHz,
+  NRF_TIMER_FREQ_2MHz,
+  NRF_TIMER_FREQ_1MHz,
+  NRF_TIMER_FREQ_500kHz,
+  NRF_TIMER_FREQ_250kHz,
+  NRF_TIMER_FREQ_125kHz,
+  NRF_TIMER_FREQ_62500Hz,
+  NRF_TIMER_FREQ_31250Hz
+} nrf_timer_frequency_t;
+
+typedef enum
+{
+  NRF_TIMER_CC_CHANNEL0 = 0,
+  NRF_TIMER_CC_CHANNEL1,
+  NRF_TIMER_CC_CHANNEL2,
+  NRF_TIMER_CC_CHANNEL3
+} nrf_timer_cc_channel_t;
+
+// event check lets running timer model advance, so polling loops see events coming
+bool nrf_timer_event_check(NRF_TIMER_Type *p_timer, nrf_timer_event_t event);
+void nrf_timer_event_clear(NRF_TIMER_Type *p_timer, nrf_timer_event_t event);
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_timer, nrf_timer_task_t task);
+
+#endif // NRF_TIMER_H__
@@ -0,0 +1,17 @@
+#ifndef SDK_COMMON_H__
+#define SDK_COMMON_H__
+
+// Host stand-in of SDK 12.3 sdk_common.h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "sdk_config.h"
+#include "nordic_common.h"
+#include "sdk_errors.h"
+#include "app_util_platform.h"
+#include "nrf.h"
+#include "nrf_assert.h"
+
+#endif // SDK_COMMON_H__
@@ -0,0 +1,189 @@
+#include <string.h>
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "CPU_usage.h"
+#include "sim.h"
+#include "test.h"
+
+// Profiler attribution on firmware main loop: a wakeup with posted task goes to the task,
+// a wakeup without task goes to the profiled interrupts served in it or to not profiled
+// ones, every wakeup is counted once, handler and task time goes where it was spent
+
+#define RUN_S             60
+#define PULSE_MS          37      // GPIOTE interrupt posts particle_cnt task
+#define LPCOMP_MS         113     // comparator interrupt doesn't post
+#define BAT_MS            1700    // app_timer posts battery task
+#define PULSE_ISR_US      200
+#define PULSE_TASK_US     1000
+#define BAT_TASK_US       3000
+#define TIME_TOL          0.03    // RTC tick resolution of short handlers
+
+APP_TIMER_DEF(bat_tmr);
+
+static uint32_t pulse_cnt;
+static uint32_t lpcomp_cnt;
+static uint32_t bat_cnt;
+
+// ---------------------------------------------------------------------------
+static void pulse_isr(void *p_ctx)
+{
+  PROF_ISR_ENTER();
+  pulse_cnt++;
+  sim_CpuBusy(PULSE_ISR_US);
+  sched_Post(SCHED_PULSE);
+  PROF_ISR_EXIT(PROF_ISR_PULSE);
+}
+
+static void lpcomp_isr(void *p_ctx)
+{
+  PROF_ISR_ENTER();
+  lpcomp_cnt++;
+  PROF_ISR_EXIT(PROF_ISR_LPCOMP);
+}
+
+static void on_bat_tmr(void *p_ctx)
+{
+  PROF_ISR_ENTER();
+  bat_cnt++;
+  sched_Post(SCHED_BAT);
+  PROF_ISR_EXIT(PROF_ISR_APP_TIMER);
+}
+
+static void pulse_task(void)
+{
+  sim_CpuBusy(PULSE_TASK_US);
+}
+
+static void bat_task(void)
+{
+  sim_CpuBusy(BAT_TASK_US);
+}
+
+// hardware events keep coming with their periods
+static void pulse_evt(void *p_ctx)
+{
+  sim_IrqPend(SIM_IRQ_GPIOTE);
+  sim_At(sim_GetUs() + SIM_MS(PULSE_MS), pulse_evt, NULL);
+}
+
+static void lpcomp_evt(void *p_ctx)
+{
+  sim_IrqPend(SIM_IRQ_LPCOMP);
+  sim_At(sim_GetUs() + SIM_MS(LPCOMP_MS), lpcomp_evt, NULL);
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t get_u32(uint8_t sel, uint8_t offset)
+{
+  uint8_t rec[CPU_USAGE_RECORD_MAX];
+  uint32_t val;
+  CHECK(CPU_usage_GetRecord(sel, rec) >= offset + sizeof(val));
+  memcpy(&val, &rec[offset], sizeof(val));
+  return val;
+}
+
+static uint16_t get_u16(uint8_t sel, uint8_t idx)
+{
+  uint8_t rec[CPU_USAGE_RECORD_MAX];
+  uint16_t val;
+  CHECK(CPU_usage_GetRecord(sel, rec) >= (idx + 1) * sizeof(val));
+  memcpy(&val, &rec[idx * sizeof(val)], sizeof(val));
+  return val;
+}
+
+static uint32_t ticks_of(uint64_t us)
+{
+  return (uint32_t)(us * SIM_TICK_FREQ / SIM_US_PER_SEC);
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t wakeups;
+static uint64_t run_ticks;
+
+// firmware main() loop
+static void main_loop(void)
+{
+  uint64_t start = sim_GetTicks();
+  uint64_t end = sim_GetUs() + SIM_SEC(RUN_S);
+  wakeups = sim_GetWakeups();
+  while (sim_GetUs() < end)
+  {
+    sched_Run();
+    if (!sched_IsPending())
+    {
+      CPU_usage_Sleep();
+    }
+  }
+  wakeups = sim_GetWakeups() - wakeups;
+  run_ticks = sim_GetTicks() - start;
+}
+
+// ---------------------------------------------------------------------------
+static void wakeup_causes(void)
+{
+  main_loop();
+  uint32_t no_task = wakeups - pulse_cnt - bat_cnt;
+  printf("  %u wakeups: pulse %u, battery %u, comparator %u, not profiled %u\n",
+         wakeups, pulse_cnt, bat_cnt, lpcomp_cnt, no_task - lpcomp_cnt);
+
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_TOTAL, 0), wakeups);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP, SCHED_PULSE), pulse_cnt);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP, SCHED_BAT), bat_cnt);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP, SCHED_BLE), 0);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP, SCHED_TASKS_TOTAL), no_task);
+
+  // wakeups with task are not given to interrupts
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP + 1, PROF_ISR_PULSE), 0);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP + 1, PROF_ISR_APP_TIMER), 0);
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP + 1, PROF_ISR_LPCOMP), lpcomp_cnt);
+  // profiler report timer and app_time_lib overflow one
+  CHECK_EQ(get_u16(CPU_USAGE_SEL_WAKEUP + 1, PROF_ISR_TOTAL), no_task - lpcomp_cnt);
+  CHECK(no_task - lpcomp_cnt >= RUN_S * 1000 / CPU_USAGE_REPORT_PERIOD_MS - 1);
+}
+
+// ---------------------------------------------------------------------------
+static void time_attribution(void)
+{
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_ISR + PROF_ISR_PULSE, 0), pulse_cnt);
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_ISR + PROF_ISR_LPCOMP, 0), lpcomp_cnt);
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_ISR + PROF_ISR_APP_TIMER, 0), bat_cnt);
+  double isr_ticks = ticks_of((uint64_t)pulse_cnt * PULSE_ISR_US);
+  CHECK_NEAR(get_u32(CPU_USAGE_SEL_ISR + PROF_ISR_PULSE, 4), isr_ticks, isr_ticks * TIME_TOL + 1);
+  CHECK(get_u32(CPU_USAGE_SEL_ISR + PROF_ISR_LPCOMP, 4) <= 1);
+
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_TASK + SCHED_PULSE, 0), pulse_cnt);
+  CHECK_EQ(get_u32(CPU_USAGE_SEL_TASK + SCHED_BAT, 0), bat_cnt);
+  double pulse_ticks = ticks_of((uint64_t)pulse_cnt * PULSE_TASK_US);
+  double bat_ticks = ticks_of((uint64_t)bat_cnt * BAT_TASK_US);
+  CHECK_NEAR(get_u32(CPU_USAGE_SEL_TASK + SCHED_PULSE, 4), pulse_ticks, pulse_ticks * TIME_TOL + 1);
+  CHECK_NEAR(get_u32(CPU_USAGE_SEL_TASK + SCHED_BAT, 4), bat_ticks, bat_ticks * TIME_TOL + 1);
+
+  // main loop works in tasks only, interrupts run while it sleeps
+  uint32_t work = get_u32(CPU_USAGE_SEL_TOTAL, 4);
+  uint32_t sleep = get_u32(CPU_USAGE_SEL_TOTAL, 8);
+  printf("  work %u sleep %u ticks\n", work, sleep);
+  CHECK_NEAR(work + sleep, run_ticks, 2);
+  CHECK_NEAR(work, pulse_ticks + bat_ticks, (pulse_ticks + bat_ticks) * TIME_TOL + 1);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sched_Register(SCHED_PULSE, pulse_task);
+  sched_Register(SCHED_BAT, bat_task);
+  sim_IrqConnect(SIM_IRQ_GPIOTE, pulse_isr, NULL, 0);
+  sim_IrqConnect(SIM_IRQ_LPCOMP, lpcomp_isr, NULL, 0);
+  CPU_usage_Startup();
+
+  APP_ERROR_CHECK(app_timer_create(&bat_tmr, APP_TIMER_MODE_REPEATED, on_bat_tmr));
+  APP_ERROR_CHECK(app_timer_start(bat_tmr, MS_TO_TICK(BAT_MS), NULL));
+  sim_At(SIM_MS(5), pulse_evt, NULL);
+  sim_At(SIM_MS(11), lpcomp_evt, NULL);
+
+  TEST_RUN(wakeup_causes);
+  TEST_RUN(time_attribution);
+  return TEST_RESULT();
+}
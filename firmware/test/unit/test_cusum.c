@@ -0,0 +1,153 @@
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "realtime_particle_watcher.h"
+#include "sim.h"
+#include "test.h"
+
+// CUSUM alarm of the tube in build: no false alarm at background for days, a step to
+// threshold rates is detected sooner than the window of RPW_WINDOW_S is filled
+
+#ifdef J305
+#define TUBE              "J305"
+#define BACKGROUND_CPS    (ALARM_BG_J305_MCPS / 1000.0)
+#else
+#define TUBE              "SBM20"
+#define BACKGROUND_CPS    (ALARM_BG_SBM20_MCPS / 1000.0)
+#endif
+#define WARNING_CPS       (85.0 / 40)
+#define DANGER_CPS        (170.0 / 40)
+
+static uint32_t pulses;
+static uint32_t alarms;
+static uint32_t dangers;
+
+// ----------------------------------------------------------------------------
+uint32_t particle_cnt_Get(void)
+{
+  return pulses;
+}
+
+void sound_alarm(void)
+{
+  alarms++;
+}
+
+void sound_danger(void)
+{
+  dangers++;
+}
+
+void HV_instantKick(void)
+{
+}
+
+void PWT_Tick(uint32_t cnt)
+{
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t poisson(double mean)
+{
+  uint32_t n = 0;
+  double t = test_Exp(1.0 / mean);
+  while (t < 1.0)
+  {
+    n++;
+    t += test_Exp(1.0 / mean);
+  }
+  return n;
+}
+
+// pulses of every second come before the RPW tick
+static void run_rate(double cps, uint32_t sec)
+{
+  for (uint32_t i = 0; i < sec; i++)
+  {
+    pulses += poisson(cps);
+    sim_Run(SIM_SEC(1));
+  }
+}
+
+// seconds at rate until sound, 0 if it didn't come in limit. Any sound is taken without danger_only
+static uint32_t detect_delay(double cps, bool danger_only, uint32_t limit)
+{
+  uint32_t before = dangers + (danger_only ? 0 : alarms);
+  for (uint32_t sec = 1; sec <= limit; sec++)
+  {
+    run_rate(cps, 1);
+    if (dangers + (danger_only ? 0 : alarms) != before)
+    {
+      return sec;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+static void background(void)
+{
+  uint32_t days = 20;
+  run_rate(BACKGROUND_CPS, days * 86400);
+  printf("  %s %u days at %.2f cps: %u warnings, %u dangers\n", TUBE, days, BACKGROUND_CPS, alarms, dangers);
+  CHECK_EQ(alarms, 0);
+  CHECK_EQ(dangers, 0);
+}
+
+// seconds of rate until window sum of background and rate crosses threshold of rate
+static double window_delay(double threshold_cps, double cps)
+{
+  return (threshold_cps - BACKGROUND_CPS) * RPW_WINDOW_S / (cps - BACKGROUND_CPS);
+}
+
+// ---------------------------------------------------------------------------
+static void step(void)
+{
+  double warn_cps = WARNING_CPS * 1.5;    // below danger rate
+  double danger_cps = DANGER_CPS * 2;
+  uint32_t trials = 20;
+  uint32_t warn_sum = 0, warn_max = 0, danger_sum = 0, danger_max = 0;
+  uint32_t missed = 0, early_danger = 0;
+
+  for (uint32_t i = 0; i < trials; i++)
+  {
+    // an hour of background resets sums and repeat period of previous alarm
+    run_rate(BACKGROUND_CPS, 3600);
+    uint32_t was = dangers;
+    uint32_t d = detect_delay(warn_cps, false, 600);
+    early_danger += dangers - was;
+    missed += (d == 0) ? 1 : 0;
+    warn_sum += d;
+    warn_max = MAX(warn_max, d);
+
+    run_rate(BACKGROUND_CPS, 3600);
+    d = detect_delay(danger_cps, true, 600);
+    missed += (d == 0) ? 1 : 0;
+    danger_sum += d;
+    danger_max = MAX(danger_max, d);
+  }
+  double warn_mean = (double)warn_sum / trials;
+  double danger_mean = (double)danger_sum / trials;
+  printf("  %s warning at %.2f cps in %.1f s (max %u, window %.1f s), danger at %.2f cps in %.1f s (max %u, window %.1f s)\n",
+         TUBE, warn_cps, warn_mean, warn_max, window_delay(WARNING_CPS, warn_cps),
+         danger_cps, danger_mean, danger_max, window_delay(DANGER_CPS, danger_cps));
+  CHECK_EQ(missed, 0);
+  // a burst can sound danger below its rate, as window sum can exceed its threshold
+  printf("  danger instead of warning in %u of %u\n", early_danger, trials);
+  CHECK(early_danger <= trials / 10);
+  CHECK(warn_mean < window_delay(WARNING_CPS, warn_cps));
+  CHECK(danger_mean < window_delay(DANGER_CPS, danger_cps));
+  CHECK(warn_max < RPW_WINDOW_S);
+  CHECK(danger_max < RPW_WINDOW_S);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  RPW_Init();
+  RPW_Startup();
+
+  TEST_RUN(background);
+  TEST_RUN(step);
+  return TEST_RESULT();
+}
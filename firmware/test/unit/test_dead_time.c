@@ -0,0 +1,94 @@
+#include "sdk_common.h"
+#include "dead_time.h"
+#include "test.h"
+
+// Dead time correction: Poisson pulses are lost by the tube model of the build, corrected
+// counts give the true rate up to counting noise from background to the highest rates.
+// Without DEAD_TIME_CORRECTION counts are returned unchanged
+
+#ifdef J305
+#define TAU_S         (DEAD_TIME_J305_US * 1e-6)
+#else
+#define TAU_S         (DEAD_TIME_SBM20_US * 1e-6)
+#endif
+#define INTERVAL_MS   10000
+#define INTERVALS     50
+
+// pulses registered during interval from Poisson train of cps
+static uint32_t tube_count(double cps, double *p_dead_end)
+{
+  double t = 0;
+  uint32_t m = 0;
+  for (;;)
+  {
+    t += test_Exp(1.0 / cps);
+    if (t >= INTERVAL_MS / 1000.0)
+    {
+      break;
+    }
+    if (t >= *p_dead_end)
+    {
+      m++;
+      *p_dead_end = t + TAU_S;
+    }
+#if (DEAD_TIME_CORRECTION == 2)
+    else
+    {
+      *p_dead_end = t + TAU_S;     // paralyzable: lost particle prolongs dead time
+    }
+#endif
+  }
+  *p_dead_end -= INTERVAL_MS / 1000.0;
+  return m;
+}
+
+// ---------------------------------------------------------------------------
+static void rates(void)
+{
+  static const double cps_list[] = {0.3, 5, 100, 500, 1000, 2000, 3000};
+
+  for (uint32_t r = 0; r < ARRAY_SIZE(cps_list); r++)
+  {
+    double cps = cps_list[r];
+    double expected = cps * INTERVAL_MS / 1000;
+    double dead_end = 0;
+    double sum = 0, sum2 = 0, raw = 0;
+    for (uint32_t i = 0; i < INTERVALS; i++)
+    {
+      uint32_t m = tube_count(cps, &dead_end);
+      double n = DTC_Correct(m, INTERVAL_MS);
+      raw += m;
+      sum += n;
+      sum2 += n * n;
+    }
+    double mean = sum / INTERVALS;
+    double sd = sqrt(MAX(sum2 / INTERVALS - mean * mean, 0.0));
+    printf("  %7.1f cps: measured %8.1f, corrected %8.1f of %8.0f\n", cps, raw / INTERVALS, mean, expected);
+#if (DEAD_TIME_CORRECTION == 0)
+    (void)sd;
+    CHECK_NEAR(mean, raw / INTERVALS, 1e-9);
+#else
+    CHECK_NEAR(mean, expected, 4 * sd / sqrt(INTERVALS) + 0.005 * expected + 1);
+#endif
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void edges(void)
+{
+  CHECK_EQ(DTC_Correct(0, INTERVAL_MS), 0);
+  CHECK_EQ(DTC_Correct(1, INTERVAL_MS), 1);
+  // a rate above model limit is limited, not wrapped
+  uint32_t big = DTC_Correct(UINT32_MAX / 2, 1);
+  CHECK(big >= UINT32_MAX / 2);
+  CHECK(DTC_Correct(1000000, 1000) >= DTC_Correct(100000, 1000));
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(4);
+  TEST_RUN(rates);
+  TEST_RUN(edges);
+  return TEST_RESULT();
+}
@@ -0,0 +1,104 @@
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "energy_model.h"
+#include "sim.h"
+#include "test.h"
+
+// Energy model against hand-computed averages of a scripted hour with currents of
+// app_config.h: every second 1 CPU wakeup of 33 ticks, 10 HV cycles and a battery
+// measurement, 100 ms tone every minute, advertising at 1 s for the first half hour
+// and connection at 30 ms for the second one
+
+#define HOUR_S              3600
+#define HALF_S              (HOUR_S / 2)
+#define ADV_INTERVAL_US     1000000
+#define CONN_INTERVAL_US    30000
+#define CPU_TICKS           33
+#define HV_CYCLES           10
+#define TONE_MS             100
+
+// 5 uA
+#define REF_BASE_NA         5000
+// (3600 * 33 * 4400 * 1000 / 32768 + 3600 * 40) / 3600 = 4431 + 40
+#define REF_CPU_NA          4471
+// 1800 s / (1 s + 5 ms average advertising delay) = 1791 events * 12000 nC
+// + 1800 s / 30 ms = 60000 events * 5000 nC, all over 3600 s
+#define REF_RADIO_NA        89303
+// 10 * 800 nC per second
+#define REF_HV_NA           8000
+// 100 ms * 3000 uA per minute
+#define REF_SOUND_NA        5000
+// 50 nC per second
+#define REF_ADC_NA          50
+#define REF_TOTAL_NA        (REF_BASE_NA + REF_CPU_NA + REF_RADIO_NA + REF_HV_NA + REF_SOUND_NA + REF_ADC_NA)
+// truncation of integer accounting
+#define TOL_NA              2
+
+// ---------------------------------------------------------------------------
+static void run_second(uint32_t sec)
+{
+  ENRG_CPU_WORK(CPU_TICKS);
+  for (uint8_t i = 0; i < HV_CYCLES; i++)
+  {
+    ENRG_CHARGE(ENRG_HV, ENERGY_HV_CYCLE_NC);
+  }
+  ENRG_CHARGE(ENRG_ADC, ENERGY_ADC_NC);
+  if (sec % 60 == 0)
+  {
+    ENRG_CHARGE(ENRG_SOUND, TONE_MS * ENERGY_BUZZER_UA);
+  }
+  sim_Run(SIM_SEC(1));
+}
+
+// ---------------------------------------------------------------------------
+static void reference_hour(void)
+{
+  ENRG_RADIO_SET(ENRG_RADIO_ADV, ADV_INTERVAL_US);
+  for (uint32_t sec = 0; sec < HALF_S; sec++)
+  {
+    run_second(sec);
+  }
+  ENRG_RADIO_SET(ENRG_RADIO_CONN, CONN_INTERVAL_US);
+  for (uint32_t sec = HALF_S; sec < HOUR_S; sec++)
+  {
+    run_second(sec);
+  }
+
+  uint32_t total = ENRG_GetAverage(ENRG_CONSUMERS_TOTAL);
+  uint32_t uah_day = total * 24 / 1000;
+  printf("  base %u cpu %u radio %u hv %u sound %u adc %u nA\n",
+         ENRG_GetAverage(ENRG_BASE), ENRG_GetAverage(ENRG_CPU), ENRG_GetAverage(ENRG_RADIO),
+         ENRG_GetAverage(ENRG_HV), ENRG_GetAverage(ENRG_SOUND), ENRG_GetAverage(ENRG_ADC));
+  printf("  total %u nA, %u uAh/day, %u days of %u mAh\n",
+         total, uah_day, ENERGY_BATTERY_MAH * 1000 / uah_day, ENERGY_BATTERY_MAH);
+
+  CHECK_NEAR(ENRG_GetAverage(ENRG_BASE), REF_BASE_NA, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_CPU), REF_CPU_NA, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_RADIO), REF_RADIO_NA, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_HV), REF_HV_NA, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_SOUND), REF_SOUND_NA, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_ADC), REF_ADC_NA, TOL_NA);
+  CHECK_NEAR(total, REF_TOTAL_NA, 6 * TOL_NA);
+}
+
+// radio is not charged while idle, so its average halves in the next quiet hour
+static void idle_radio(void)
+{
+  ENRG_RADIO_SET(ENRG_RADIO_IDLE, 0);
+  sim_Run(SIM_SEC(HOUR_S));
+  CHECK_NEAR(ENRG_GetAverage(ENRG_RADIO), REF_RADIO_NA / 2, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_HV), REF_HV_NA / 2, TOL_NA);
+  CHECK_NEAR(ENRG_GetAverage(ENRG_BASE), REF_BASE_NA, TOL_NA);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  ENRG_Init();
+  ENRG_Startup();
+
+  TEST_RUN(reference_hour);
+  TEST_RUN(idle_radio);
+  return TEST_RESULT();
+}
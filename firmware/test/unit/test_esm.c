@@ -0,0 +1,154 @@
+#include "sdk_common.h"
+#include "esm_lib.h"
+#include "test.h"
+
+// State machine library: tables with a state without process function or with zero
+// signal are refused, signals move between states through jump functions, machine doesn't run
+// while disabled and disabling returns it to the first state
+
+enum { STATE_IDLE, STATE_PRESSED, STATE_DOUBLE, STATES_TOTAL };
+enum { SIG_NONE, SIG_PRESS, SIG_RELEASE, SIG_TIMEOUT };
+
+typedef struct
+{
+  uint16_t  signal;     // the next signal of process function
+  uint32_t  procs;
+  uint32_t  jumps;
+} script_t;
+
+// ---------------------------------------------------------------------------
+static uint16_t proc(void *user_ctx)
+{
+  script_t *p_script = user_ctx;
+  uint16_t signal = p_script->signal;
+  p_script->signal = SIG_NONE;
+  p_script->procs++;
+  return signal;
+}
+
+static void jump(void *user_ctx)
+{
+  ((script_t *)user_ctx)->jumps++;
+}
+
+static const ESM_t esm =
+{
+  ESM_DEF(STATES_TOTAL, "test")
+  {
+    {
+      ESM_STATE_DEF(STATE_IDLE, "IDLE", proc, 1)
+      {
+        {SIG_PRESS, STATE_PRESSED, jump},
+      }
+    },
+    {
+      ESM_STATE_DEF(STATE_PRESSED, "PRESSED", proc, 2)
+      {
+        {SIG_PRESS, STATE_DOUBLE, jump},
+        {SIG_TIMEOUT, STATE_IDLE, NULL},
+      }
+    },
+    {
+      ESM_STATE_DEF(STATE_DOUBLE, "DOUBLE", proc, 1)
+      {
+        {SIG_RELEASE, STATE_IDLE, jump},
+      }
+    },
+  }
+};
+
+static const ESM_t esm_no_proc =
+{
+  ESM_DEF(1, "no proc")
+  {
+    {
+      ESM_STATE_DEF(STATE_IDLE, "IDLE", NULL, 1)
+      {
+        {SIG_PRESS, STATE_IDLE, jump},
+      }
+    },
+  }
+};
+
+static const ESM_t esm_zero_signal =
+{
+  ESM_DEF(1, "zero signal")
+  {
+    {
+      ESM_STATE_DEF(STATE_IDLE, "IDLE", proc, 1)
+      {
+        {SIG_NONE, STATE_IDLE, jump},
+      }
+    },
+  }
+};
+
+// ---------------------------------------------------------------------------
+static void enable_checks(void)
+{
+  ESM_ctx_t ctx = { 0 };
+  CHECK_EQ(esmEnable(NULL, true, &ctx), NRF_ERROR_NULL);
+  CHECK_EQ(esmEnable(&esm, true, NULL), NRF_ERROR_NULL);
+  CHECK_EQ(esmEnable(&esm_no_proc, true, &ctx), NRF_ERROR_INVALID_DATA);
+  CHECK_EQ(esmEnable(&esm_zero_signal, true, &ctx), NRF_ERROR_NOT_FOUND);
+  CHECK(!ctx.isInit);
+  CHECK_EQ(esmEnable(&esm, true, &ctx), NRF_SUCCESS);
+  CHECK(ctx.isInit);
+}
+
+// ---------------------------------------------------------------------------
+static void transitions(void)
+{
+  static const struct
+  {
+    uint16_t  signal;
+    uint16_t  state;
+    bool      is_changed;
+  } steps[] =
+  {
+    {SIG_NONE, STATE_IDLE, false},
+    {SIG_PRESS, STATE_PRESSED, true},
+    {SIG_TIMEOUT, STATE_IDLE, true},
+    {SIG_PRESS, STATE_PRESSED, true},
+    {SIG_NONE, STATE_PRESSED, false},
+    {SIG_PRESS, STATE_DOUBLE, true},
+    {SIG_RELEASE, STATE_IDLE, true},
+  };
+  script_t script = { 0 };
+  ESM_ctx_t ctx = { .user_ctx = &script };
+  CHECK_EQ(esmEnable(&esm, true, &ctx), NRF_SUCCESS);
+
+  for (uint8_t i = 0; i < ARRAY_SIZE(steps); i++)
+  {
+    script.signal = steps[i].signal;
+    CHECK_EQ(esmProcess(&esm, &ctx), steps[i].is_changed);
+    CHECK_EQ(esmGetState(&ctx), steps[i].state);
+  }
+  CHECK_EQ(script.procs, ARRAY_SIZE(steps));
+  CHECK_EQ(script.jumps, 4);    // timeout has no jump function
+}
+
+// ---------------------------------------------------------------------------
+static void disabled(void)
+{
+  script_t script = { 0 };
+  ESM_ctx_t ctx = { .user_ctx = &script };
+  CHECK_EQ(esmEnable(&esm, true, &ctx), NRF_SUCCESS);
+  script.signal = SIG_PRESS;
+  CHECK(esmProcess(&esm, &ctx));
+
+  CHECK_EQ(esmEnable(&esm, false, &ctx), NRF_SUCCESS);
+  CHECK_EQ(esmGetState(&ctx), STATE_IDLE);
+  script.signal = SIG_PRESS;
+  CHECK(!esmProcess(&esm, &ctx));
+  CHECK_EQ(script.procs, 1);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  TEST_RUN(enable_checks);
+  TEST_RUN(transitions);
+  TEST_RUN(disabled);
+  return TEST_RESULT();
+}
@@ -0,0 +1,205 @@
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "varint.h"
+#include "particle_watcher.h"
+#include "event_queue.h"
+#include "sim.h"
+#include "test.h"
+
+// Event queue sync over a link which drops connection: client gets every record
+// with its value exactly once after duplicates are removed, records are lost only
+// when full queue throws out not acknowledged ones. Handler runs unlocked and
+// records coming meanwhile don't break sync
+
+#define BARS_PER_HOUR   (3600 / PWT_BAR_S)
+#define BATCH_LEN       12      // records bytes per notification, short to get many of them
+#define RECORDS_MAX     40000
+#define IN_FLIGHT_MAX   4       // notifications queued in SoftDevice
+
+typedef struct
+{
+  uint32_t  seq;
+  uint32_t  prev;
+  uint8_t   data[BATCH_LEN];
+  uint16_t  len;
+} pkt_t;
+
+static uint32_t truth[RECORDS_MAX];   // value of every record by seq
+static uint32_t produced;
+static uint32_t cli_next;             // client: the next expected seq
+static uint32_t cli_got[RECORDS_MAX];
+static uint32_t duplicates;
+static uint32_t lost;                 // thrown out by full queue before sent
+static uint32_t wrong;
+
+static pkt_t    in_flight[IN_FLIGHT_MAX];
+static uint8_t  in_flight_cnt;
+static uint32_t link_budget;          // notifications until connection is lost
+static uint32_t tick_in_handler;      // records to finish inside next handler call
+static uint32_t handler_locked;
+static uint32_t raced;                // batch records thrown out while handler sends them
+
+// ----------------------------------------------------------------------------
+uint32_t PWT_GetPending(void)
+{
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// hour of bars as RPW timer gives them, the record gets value
+static void record_produce(void)
+{
+  uint32_t value = 800 + test_Rand() % 1500;
+  if ((test_Rand() % 50) == 0)
+  {
+    value += 100000;    // rare jumps take long varints
+  }
+  ASSERT(produced < RECORDS_MAX);
+  truth[produced++] = value;
+  EVQ_Tick(value);
+  for (uint32_t i = 1; i < BARS_PER_HOUR; i++)
+  {
+    EVQ_Tick(0);
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void client_receive(const pkt_t *p)
+{
+  if ((int32_t)(p->seq - cli_next) > 0)
+  {
+    // gap is allowed only for records thrown out of queue
+    CHECK((int32_t)(EVQ_GetFirstSeq() - p->seq) >= 0);
+    lost += p->seq - cli_next;
+    cli_next = p->seq;
+  }
+
+  uint32_t seq = p->seq;
+  uint32_t value = p->prev;
+  uint16_t used = 0;
+  uint32_t zz;
+  uint8_t  vlen;
+  while ((vlen = varint_decode(&p->data[used], p->len - used, &zz)) > 0)
+  {
+    value += zigzag_decode(zz);
+    used += vlen;
+    if (value != truth[seq])
+    {
+      wrong++;
+    }
+    if (seq == cli_next)
+    {
+      cli_got[seq] = value;
+      cli_next++;
+    }
+    else
+    {
+      duplicates++;
+    }
+    seq++;
+  }
+  CHECK_EQ(used, p->len);
+}
+
+// ---------------------------------------------------------------------------
+static void link_flush(uint8_t n)
+{
+  n = MIN(n, in_flight_cnt);
+  for (uint8_t i = 0; i < n; i++)
+  {
+    client_receive(&in_flight[i]);
+  }
+  memmove(in_flight, &in_flight[n], (in_flight_cnt - n) * sizeof(pkt_t));
+  in_flight_cnt -= n;
+}
+
+// ---------------------------------------------------------------------------
+static bool on_batch(uint32_t seq, uint32_t prev, const uint8_t *p_data, uint16_t len, void *ctx)
+{
+  handler_locked += sim_IsCritical() ? 1 : 0;
+  // timer interrupt finishes records while notification is being built
+  for (; tick_in_handler; tick_in_handler--)
+  {
+    record_produce();
+  }
+  raced += ((int32_t)(EVQ_GetFirstSeq() - seq) > 0) ? 1 : 0;
+  if ((link_budget == 0) || (in_flight_cnt == IN_FLIGHT_MAX))
+  {
+    return false;
+  }
+  link_budget--;
+  pkt_t *p = &in_flight[in_flight_cnt++];
+  p->seq = seq;
+  p->prev = prev;
+  memcpy(p->data, p_data, len);
+  p->len = len;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// connection: sync from the oldest not acknowledged record until link is lost or all is sent
+static void session(uint32_t budget)
+{
+  link_budget = budget;
+  in_flight_cnt = 0;
+  EVQ_SyncStart();
+  while (EVQ_SyncGetSeq() != EVQ_GetNextSeq())
+  {
+    if (!EVQ_SyncPeek(BATCH_LEN, on_batch, NULL))
+    {
+      if (link_budget == 0)
+      {
+        in_flight_cnt = 0;    // connection is lost with queued notifications
+        return;
+      }
+      link_flush(1 + test_Rand() % IN_FLIGHT_MAX);   // TX complete
+      if ((test_Rand() % 4) == 0)
+      {
+        EVQ_Release(cli_next);
+      }
+    }
+  }
+  link_flush(IN_FLIGHT_MAX);
+  EVQ_Release(cli_next);
+}
+
+// ---------------------------------------------------------------------------
+static void lossy_sync(void)
+{
+  for (uint32_t round = 0; round < 400; round++)
+  {
+    uint32_t fresh = test_Rand() % 30;
+    if ((round % 50) == 49)
+    {
+      fresh = 2500;   // device was out of range long time, queue overflows
+    }
+    for (uint32_t i = 0; i < fresh; i++)
+    {
+      record_produce();
+    }
+    tick_in_handler = (test_Rand() % 3 == 0) ? 1 + test_Rand() % 3 : 0;
+    session(test_Rand() % 40);
+  }
+  tick_in_handler = 0;
+  session(UINT32_MAX);
+
+  printf("  %u records: %u duplicates, %u lost by overflow, %u batches thrown out while sent\n",
+         produced, duplicates, lost, raced);
+  CHECK_EQ(cli_next, produced);
+  CHECK_EQ(EVQ_GetNextSeq(), produced);
+  CHECK_EQ(EVQ_GetEventsAmount(), 0);
+  CHECK_EQ(wrong, 0);
+  CHECK_EQ(handler_locked, 0);
+  CHECK(raced > 0);
+  CHECK(lost > 0);
+  CHECK(lost < produced / 2);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  EVQ_Startup();
+  TEST_RUN(lossy_sync);
+  return TEST_RESULT();
+}
@@ -0,0 +1,294 @@
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "flash_log.h"
+#include "sim.h"
+#include "sim_flash.h"
+#include "test.h"
+
+// Flash log on NOR model: pending entries go by page programs, sectors wear equally,
+// reads wait for idle chip, power cut at any moment loses only not programmed entries.
+// Every case runs in a child process like firmware after reset, flash content is shared
+
+#define ENTRIES_PER_SECTOR  (EXT_FLASH_SECTOR_SIZE / 8 - 1)
+#define PAGE_ENTRIES        (EXT_FLASH_PAGE_SIZE / 8)
+
+static void main_loop(void *p_ctx)
+{
+  sched_Run();
+}
+
+// value is function of seq, so any read entry can be checked
+static uint32_t value_of(uint32_t seq)
+{
+  return (seq * 2654435761ul) & 0x00FFFFFFul;
+}
+
+// ---------------------------------------------------------------------------
+static void log_start(void)
+{
+  sched_Register(SCHED_FLOG, FLOG_Process);
+  sim_SetMainLoop(main_loop, NULL);
+  FLOG_Init();
+}
+
+// ---------------------------------------------------------------------------
+static void append(uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    FLOG_Append(value_of(FLOG_GetNextSeq()));
+  }
+  sched_Run();
+}
+
+// ---------------------------------------------------------------------------
+// run until page buffer is programmed and chip is idle
+static void flush(void)
+{
+  uint64_t limit = sim_GetUs() + SIM_SEC(10);
+  do
+  {
+    sim_Run(SIM_MS(1));
+  } while (FLOG_IsBusy() && (sim_GetUs() < limit));
+  CHECK(!FLOG_IsBusy());
+}
+
+// ---------------------------------------------------------------------------
+// reads whole log, checks order and values, returns amount of entries
+static uint32_t read_all(uint32_t *p_first, uint32_t *p_last)
+{
+  flog_cursor_t cursor;
+  uint32_t seq, value, n = 0;
+  FLOG_CursorInit(&cursor);
+  while (FLOG_Read(&cursor, &seq, &value))
+  {
+    CHECK_EQ(value, value_of(seq));
+    if (n == 0)
+    {
+      *p_first = seq;
+    }
+    else if (seq <= *p_last)
+    {
+      CHECK(seq > *p_last);
+      break;
+    }
+    *p_last = seq;
+    n++;
+  }
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+static void in_child(void (*fn)(void))
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    test_failed = 0;
+    fn();
+    fflush(stdout);
+    _exit(test_failed ? 1 : 0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+  {
+    test_failed++;
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void case_throughput(void)
+{
+  log_start();
+  uint32_t total = 4 * ENTRIES_PER_SECTOR;
+  uint64_t start = sim_GetUs();
+  for (uint32_t done = 0; done < total; done += PAGE_ENTRIES)
+  {
+    append(MIN(PAGE_ENTRIES, total - done));
+    flush();
+  }
+  double sec = (double)(sim_GetUs() - start) / SIM_US_PER_SEC;
+
+  const sim_flash_stat_t *p_stat = sim_flash_GetStat();
+  printf("  %u entries: %u programs, %u erases, %.0f entries/s\n",
+         total, p_stat->programs, p_stat->erases, total / sec);
+  // header shifts entries by slot, so a burst of page size takes two programs
+  CHECK(p_stat->programs <= 2 * (total / PAGE_ENTRIES + 1) + p_stat->erases);
+  CHECK_EQ(p_stat->erases, total / ENTRIES_PER_SECTOR);
+  CHECK(p_stat->program_bytes <= (total + p_stat->erases) * 8);
+  CHECK(total / sec > 1000);
+  CHECK_EQ(p_stat->violations, 0);
+
+  uint32_t first = 0, last = 0;
+  CHECK_EQ(read_all(&first, &last), total);
+  CHECK_EQ(first, 0);
+  CHECK_EQ(last, total - 1);
+}
+
+// ---------------------------------------------------------------------------
+static void case_wear(void)
+{
+  log_start();
+  uint32_t total = 3 * FLASH_LOG_SECTORS * ENTRIES_PER_SECTOR + 100;
+  for (uint32_t done = 0; done < total; done += PAGE_ENTRIES)
+  {
+    append(MIN(PAGE_ENTRIES, total - done));
+    flush();
+  }
+
+  const sim_flash_stat_t *p_stat = sim_flash_GetStat();
+  uint32_t min = UINT32_MAX, max = 0;
+  for (uint32_t s = 0; s < FLASH_LOG_SECTORS; s++)
+  {
+    min = MIN(min, p_stat->sector_erases[s]);
+    max = MAX(max, p_stat->sector_erases[s]);
+  }
+  printf("  %u erases, per sector %u..%u\n", p_stat->erases, min, max);
+  CHECK(max - min <= 1);
+  CHECK_EQ(p_stat->sector_erases[FLASH_LOG_SECTORS], 0);    // nothing outside log area
+  CHECK_EQ(p_stat->violations, 0);
+
+  // only the newest sectors are kept
+  uint32_t first = 0, last = 0;
+  uint32_t n = read_all(&first, &last);
+  CHECK_EQ(last, total - 1);
+  CHECK(n >= (FLASH_LOG_SECTORS - 1) * ENTRIES_PER_SECTOR);
+}
+
+// ---------------------------------------------------------------------------
+static void case_read_busy(void)
+{
+  log_start();
+  flog_cursor_t cursor;
+  uint32_t seq, value;
+
+  append(1);
+  CHECK(FLOG_IsBusy());
+  FLOG_CursorInit(&cursor);
+  flog_cursor_t before = cursor;
+  CHECK(!FLOG_Read(&cursor, &seq, &value));
+  CHECK(memcmp(&before, &cursor, sizeof(cursor)) == 0);
+  flush();
+
+  uint32_t first = 0, last = 0;
+  CHECK(read_all(&first, &last) > 0);
+  CHECK_EQ(last, FLOG_GetNextSeq() - 1);
+  CHECK_EQ(sim_flash_GetStat()->violations, 0);
+}
+
+// ---------------------------------------------------------------------------
+static void case_absent(void)
+{
+  sim_flash_Init(false);
+  log_start();
+  flog_cursor_t cursor;
+  uint32_t seq, value;
+
+  append(10);
+  flush();
+  CHECK_EQ(FLOG_GetNextSeq(), 0);
+  FLOG_CursorInit(&cursor);
+  CHECK(!FLOG_Read(&cursor, &seq, &value));
+}
+
+// ---------------------------------------------------------------------------
+// shared between children
+typedef struct
+{
+  uint32_t  durable;    // seq of entry known to be programmed before cut
+  uint32_t  torn;       // cuts in the middle of program or erase
+} cut_t;
+
+static cut_t *p_cut;
+
+static void case_cut(void)
+{
+  log_start();
+  uint32_t first = 0, last = 0;
+  uint32_t n = read_all(&first, &last);
+  if (p_cut->durable != UINT32_MAX)
+  {
+    CHECK(n > 0);
+    CHECK(last >= p_cut->durable);
+  }
+  // writing goes on after the last read entry
+  CHECK_EQ(FLOG_GetNextSeq(), (n > 0) ? last + 1 : 0);
+
+  // entries come by small bursts, cut happens in random moment
+  uint32_t bursts = 1 + test_Rand() % 40;
+  for (uint32_t b = 0; b < bursts; b++)
+  {
+    append(1 + test_Rand() % PAGE_ENTRIES);
+    flush();
+    p_cut->durable = FLOG_GetNextSeq() - 1;
+  }
+  append(1 + test_Rand() % PAGE_ENTRIES);
+  sim_Run(test_Rand() % ((test_Rand() & 1) ? SIM_MS(3) : SIM_MS(35)));
+  p_cut->torn += sim_flash_PowerCut() ? 1 : 0;
+}
+
+static void power_cut(void)
+{
+  sim_flash_Erase();
+  p_cut = mmap(NULL, sizeof(cut_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  p_cut->durable = UINT32_MAX;
+  p_cut->torn = 0;
+
+  for (uint32_t i = 0; i < 200; i++)
+  {
+    test_Seed(i + 1);
+    in_child(case_cut);
+  }
+  in_child(case_cut);
+  printf("  200 cuts, %u torn operations, %u erases, last durable entry %u\n",
+         p_cut->torn, sim_flash_GetStat()->erases, p_cut->durable);
+  CHECK(p_cut->torn > 40);
+  CHECK(sim_flash_GetStat()->erases > FLASH_LOG_SECTORS);   // log wrapped over
+  CHECK_EQ(sim_flash_GetStat()->violations, 0);
+}
+
+// ---------------------------------------------------------------------------
+static void throughput(void)
+{
+  sim_flash_Erase();
+  in_child(case_throughput);
+}
+
+static void wear(void)
+{
+  sim_flash_Erase();
+  in_child(case_wear);
+}
+
+static void read_busy(void)
+{
+  sim_flash_Erase();
+  in_child(case_read_busy);
+}
+
+static void absent(void)
+{
+  sim_flash_Erase();
+  in_child(case_absent);
+  sim_flash_Init(true);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sim_flash_Init(true);
+
+  TEST_RUN(throughput);
+  TEST_RUN(wear);
+  TEST_RUN(read_busy);
+  TEST_RUN(absent);
+  TEST_RUN(power_cut);
+  return TEST_RESULT();
+}
@@ -0,0 +1,153 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "nrf_timer.h"
+#include "app_time_lib.h"
+#include "HighVoltagePump.h"
+#include "sim.h"
+#include "sim_hw.h"
+#include "sim_hv.h"
+#include "test.h"
+
+// HV pump cycle in one wakeup (HV_PPI_CHAIN): order of pin edges against TIMER1 compares,
+// one wakeup per cycle, and recovery when cycle timer doesn't run to CC3
+
+#define CYCLES_MAX    256
+#define ON_US         15      // on phase, CC1 - CC0
+#define CC2_US        26
+#define CC3_US        27
+
+typedef struct
+{
+  uint64_t  rise;
+  uint64_t  fall;
+  uint64_t  drv_rise;
+  uint64_t  drv_fall;
+  uint64_t  dcrg_rise;
+  uint64_t  dcrg_fall;
+} cycle_t;
+
+static const sim_hv_cfg_t hv_cfg =
+{
+  .cycle_dv = 0.03,
+  .pulse_dv = 0.0005,
+  .tau_s    = 6000,
+};
+
+static cycle_t  cycles[CYCLES_MAX];
+static uint32_t cycle_cnt;
+static bool     is_fault_armed;
+
+// ---------------------------------------------------------------------------
+static void timer_stall(void *p_ctx)
+{
+  nrf_timer_task_trigger(NRF_TIMER1, NRF_TIMER_TASK_STOP);
+}
+
+static void on_pin(uint32_t pin, bool level)
+{
+  uint64_t now = sim_GetUs();
+  if ((pin == PUMP_HV_PIN) && level)
+  {
+    cycle_cnt++;
+    if (is_fault_armed)
+    {
+      is_fault_armed = false;
+      sim_At(now + 3, timer_stall, NULL);
+    }
+  }
+  if ((cycle_cnt == 0) || (cycle_cnt > CYCLES_MAX))
+  {
+    return;
+  }
+
+  cycle_t *p = &cycles[cycle_cnt - 1];
+  if (pin == PUMP_HV_PIN)
+  {
+    *(level ? &p->rise : &p->fall) = now;
+  }
+  else if (pin == PUMP_HV_PIN_DRV)
+  {
+    *(level ? &p->drv_rise : &p->drv_fall) = now;
+  }
+  else if (pin == DCRG)
+  {
+    *(level ? &p->dcrg_rise : &p->dcrg_fall) = now;
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void event_order(void)
+{
+  hv_report_t rep;
+  uint32_t wakeups = sim_GetWakeups();
+  sim_Run(SIM_SEC(61));
+  wakeups = sim_GetWakeups() - wakeups;
+  HV_GetReport(&rep);
+
+  uint32_t discharges = 0;
+  CHECK(cycle_cnt > 30);
+  for (uint32_t i = 0; i < cycle_cnt; i++)
+  {
+    cycle_t *p = &cycles[i];
+    CHECK_EQ(p->fall - p->rise, ON_US);
+    CHECK_EQ(p->drv_rise, p->rise);
+    CHECK_EQ(p->drv_fall, p->fall);
+    if (p->dcrg_rise)
+    {
+      // DCRG goes on after CC2 when comparator was up and off after CC3
+      discharges++;
+      CHECK(p->dcrg_rise >= p->rise - 1 + CC2_US);
+      CHECK(p->dcrg_fall >= p->rise - 1 + CC3_US);
+      CHECK(p->dcrg_fall <= p->rise - 1 + CC3_US + 2);
+    }
+  }
+  printf("  %u cycles, %u recharges, %u wakeups\n", cycle_cnt, rep.recharges, wakeups);
+  CHECK_EQ(discharges, rep.recharges);
+  CHECK(rep.recharges >= 6);                // 10 s steady pause
+  CHECK(wakeups <= cycle_cnt + 1);          // no TIMER1 and LPCOMP interrupts
+  CHECK(!sim_timer_IsRunning(1));
+  CHECK_EQ(sim_timer_Get(1), 0);
+  CHECK(!sim_gpio_Get(PUMP_HV_PIN) && !sim_gpio_Get(DCRG));
+}
+
+// ---------------------------------------------------------------------------
+static void stalled_timer(void)
+{
+  hv_report_t rep;
+  HV_GetReport(&rep);
+  uint32_t recharges = rep.recharges;
+  uint32_t from = cycle_cnt;
+
+  is_fault_armed = true;
+  sim_Run(SIM_SEC(11));                     // the next cycle is in steady pause
+  CHECK(cycle_cnt > from);
+
+  // polling gave up, mosfet is closed and timer is ready for the next cycle
+  cycle_t *p = &cycles[from];
+  CHECK(p->fall > p->rise);
+  CHECK(p->fall - p->rise < 2000);
+  CHECK_EQ(p->drv_fall, p->fall);
+  CHECK_EQ(p->dcrg_rise, 0);
+
+  sim_Run(SIM_SEC(30));
+  HV_GetReport(&rep);
+  CHECK(rep.recharges > recharges);
+  CHECK(sim_hv_GetV() >= 0.95);
+  CHECK_EQ(cycles[cycle_cnt - 1].fall - cycles[cycle_cnt - 1].rise, ON_US);
+  CHECK(!sim_timer_IsRunning(1));
+  CHECK_EQ(sim_timer_Get(1), 0);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sim_hv_Init(&hv_cfg);
+  sim_gpio_Observe(on_pin);
+  HV_pump_Init();
+  HV_pump_Startup();
+
+  TEST_RUN(event_order);
+  TEST_RUN(stalled_timer);
+  return TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "HighVoltagePump.h"
+#include "sim.h"
+#include "sim_hv.h"
+#include "test.h"
+
+// On phase tuning on converter model where cycle charge grows with on phase squared:
+// overdriven coil of fresh battery gets shorter on phase, sagged battery gets longer one,
+// both settle where recharge takes HV_TUNE_TARGET_CYCLES +-0.5 and stay there
+
+#define FRESH_DV          0.1
+#define SAGGED_DV         0.02
+#define SETTLE_S          3600
+#define MEASURE_S         3600
+// measure is not aligned to tuning windows
+#define CYCLES_TOL        0.05
+// one tuning window of recharges by steady pause
+#define WINDOW_S          (HV_TUNE_WINDOW * 10)
+
+static const sim_hv_cfg_t hv_cfg =
+{
+  .cycle_dv = FRESH_DV,
+  .pulse_dv = 0.0005,
+  .tau_s    = 100,
+};
+
+// ---------------------------------------------------------------------------
+typedef struct
+{
+  uint16_t  on_min;
+  uint16_t  on_max;
+  double    cycles;     // average per recharge
+} settle_t;
+
+// runs to steady state, then takes on phase spread and average cycles of recharge
+static settle_t settle(void)
+{
+  settle_t res = { .on_min = UINT16_MAX };
+  hv_report_t rep;
+  sim_Run(SIM_SEC(SETTLE_S));
+
+  HV_GetReport(&rep);
+  uint32_t recharges = rep.recharges;
+  uint32_t cycles = rep.cycles;
+  for (uint32_t t = 0; t < MEASURE_S; t += WINDOW_S)
+  {
+    sim_Run(SIM_SEC(WINDOW_S));
+    HV_GetReport(&rep);
+    res.on_min = MIN(res.on_min, rep.on_phase_ns);
+    res.on_max = MAX(res.on_max, rep.on_phase_ns);
+  }
+  res.cycles = (double)(rep.cycles - cycles) / (rep.recharges - recharges);
+  return res;
+}
+
+static settle_t fresh;
+
+// ---------------------------------------------------------------------------
+static void fresh_battery_shortens(void)
+{
+  fresh = settle();
+  printf("  fresh: on phase %u...%u ns, %.2f cycles per recharge\n", fresh.on_min, fresh.on_max, fresh.cycles);
+  CHECK(fresh.on_max < 15000);
+  CHECK(fresh.on_min >= HV_ON_PHASE_MIN_NS);
+  CHECK(fresh.on_max - fresh.on_min <= 2 * HV_ON_PHASE_STEP_NS);
+  CHECK(fresh.cycles >= HV_TUNE_TARGET_CYCLES - 0.5 - CYCLES_TOL);
+  CHECK(fresh.cycles <= HV_TUNE_TARGET_CYCLES + 0.5 + CYCLES_TOL);
+}
+
+// ---------------------------------------------------------------------------
+static void sagged_battery_lengthens(void)
+{
+  sim_hv_SetCycleDv(SAGGED_DV);
+  settle_t sagged = settle();
+  printf("  sagged: on phase %u...%u ns, %.2f cycles per recharge\n", sagged.on_min, sagged.on_max, sagged.cycles);
+  CHECK(sagged.on_min > 15000);
+  CHECK(sagged.on_max <= HV_ON_PHASE_MAX_NS);
+  CHECK(sagged.on_max - sagged.on_min <= 2 * HV_ON_PHASE_STEP_NS);
+  CHECK(sagged.cycles >= HV_TUNE_TARGET_CYCLES - 0.5 - CYCLES_TOL);
+  CHECK(sagged.cycles <= HV_TUNE_TARGET_CYCLES + 0.5 + CYCLES_TOL);
+
+  // charge per cycle of both is held in the band of target +-0.5 cycle
+  double fresh_k = fresh.on_max / 15000.0;
+  double sagged_k = sagged.on_max / 15000.0;
+  double gain = (FRESH_DV * fresh_k * fresh_k) / (SAGGED_DV * sagged_k * sagged_k);
+  printf("  charge per cycle fresh / sagged %.2f\n", gain);
+  CHECK(gain <= (2.0 * HV_TUNE_TARGET_CYCLES + 1) / (2.0 * HV_TUNE_TARGET_CYCLES - 1));
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sim_hv_Init(&hv_cfg);
+  HV_pump_Init();
+  HV_pump_Startup();
+
+  TEST_RUN(fresh_battery_shortens);
+  TEST_RUN(sagged_battery_lengthens);
+  return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "HighVoltagePump.h"
+#include "sim.h"
+#include "sim_hv.h"
+#include "test.h"
+
+// HV pump with adaptive pause on RC and droop model of converter: at background rate
+// the pause reaches maximum and kicks stop, at high rate kicks keep voltage up
+
+APP_TIMER_DEF(rate_tmr);
+
+static const sim_hv_cfg_t hv_cfg =
+{
+  .cycle_dv = 0.03,
+  .pulse_dv = 0.0005,
+  .tau_s    = 6000,
+};
+
+static uint32_t sec_pulses;
+
+// count rate feed as realtime_particle_watcher does every second
+static void on_rate_tmr(void *p_ctx)
+{
+  HV_RateUpdate(sec_pulses);
+  sec_pulses = 0;
+}
+
+// ---------------------------------------------------------------------------
+static void pulses_run(double cps, uint32_t seconds)
+{
+  uint64_t end = sim_GetUs() + SIM_SEC(seconds);
+  uint64_t t = sim_GetUs();
+  for (;;)
+  {
+    t += (uint64_t)test_Exp(SIM_US_PER_SEC / cps);
+    if (t >= end)
+    {
+      break;
+    }
+    sim_RunUntil(t);
+    sim_hv_Pulse();
+    sec_pulses++;
+  }
+  sim_RunUntil(end);
+}
+
+// ---------------------------------------------------------------------------
+static void background_reaches_max_pause(void)
+{
+  hv_report_t rep;
+  pulses_run(0.4, 3600);
+  (void)sim_hv_TakeMinV();
+
+  HV_GetReport(&rep);
+  uint32_t recharges = rep.recharges;
+  pulses_run(0.4, 900);
+  HV_GetReport(&rep);
+
+  printf("  pause %u ms, %u recharges in 15 min\n", rep.steady_pause_ms, rep.recharges - recharges);
+  CHECK_EQ(rep.steady_pause_ms, HV_STEADY_PAUSE_MAX_MS);
+  CHECK(rep.recharges - recharges <= 900 * 1000 / HV_STEADY_PAUSE_MAX_MS + 1);
+  CHECK(sim_hv_TakeMinV() >= 0.95);
+}
+
+// ---------------------------------------------------------------------------
+static void high_rate_holds_voltage(void)
+{
+  hv_report_t rep;
+  HV_GetReport(&rep);
+  uint32_t recharges = rep.recharges;
+  pulses_run(30, 120);      // budget adapts to the rate
+  (void)sim_hv_TakeMinV();
+  pulses_run(30, 600);
+  HV_GetReport(&rep);
+
+  double min_v = sim_hv_TakeMinV();
+  printf("  min %.3f, %u recharges in 12 min\n", min_v, rep.recharges - recharges);
+  CHECK(min_v >= 0.9);
+}
+
+// ---------------------------------------------------------------------------
+static void back_to_background(void)
+{
+  hv_report_t rep;
+  pulses_run(0.4, 3600);
+  HV_GetReport(&rep);
+  CHECK_EQ(rep.steady_pause_ms, HV_STEADY_PAUSE_MAX_MS);
+  CHECK(sim_hv_TakeMinV() >= 0.9);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(19);
+  app_time_Init();
+  sim_hv_Init(&hv_cfg);
+  HV_pump_Init();
+  HV_pump_Startup();
+  APP_ERROR_CHECK(app_timer_create(&rate_tmr, APP_TIMER_MODE_REPEATED, on_rate_tmr));
+  APP_ERROR_CHECK(app_timer_start(rate_tmr, MS_TO_TICK(1000), NULL));
+
+  TEST_RUN(background_reaches_max_pause);
+  TEST_RUN(high_rate_holds_voltage);
+  TEST_RUN(back_to_background);
+  return TEST_RESULT();
+}
@@ -0,0 +1,161 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "particle_cnt.h"
+#include "sim.h"
+#include "sim_hw.h"
+#include "test.h"
+
+// Pulse counter at 5 kHz with radio activity: interrupt per pulse merges pulses, hardware
+// counter doesn't lose any while the interrupt still resets tiristor. Sound module takes
+// the timer from app_timer interrupt and gives it back without lost counts
+
+#define RATE_CPS      5000
+#define RADIO_PERIOD  30000   // connection event every 30 ms
+#define RADIO_LEN     2500
+
+APP_TIMER_DEF(rate_tmr);
+APP_TIMER_DEF(sound_tmr);
+
+static uint32_t last_cnt;
+static uint32_t notified;
+
+void ble_ios_pulse_transfer(uint32_t pulse)
+{
+  notified++;
+}
+
+// rate feed as realtime_particle_watcher does every second
+static void on_rate_tmr(void *p_ctx)
+{
+  uint32_t cnt = particle_cnt_Get();
+  particle_cnt_RateUpdate(cnt - last_cnt);
+  last_cnt = cnt;
+}
+
+// melody start and end as sound module does
+static void on_sound_tmr(void *p_ctx)
+{
+  particle_cnt_HwCounterBlock((bool)(uintptr_t)p_ctx);
+}
+
+static void main_loop(void *p_ctx)
+{
+  sched_Run();
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t pulses_run(double cps, uint32_t ms)
+{
+  uint64_t end = sim_GetUs() + SIM_MS(ms);
+  uint64_t t = sim_GetUs();
+  uint32_t pulses = 0;
+  for (;;)
+  {
+    t += 1 + (uint64_t)test_Exp(SIM_US_PER_SEC / cps);
+    if (t >= end)
+    {
+      break;
+    }
+    sim_RunUntil(t);
+    sim_gpio_Pulse(PULSE_PIN);
+    pulses++;
+  }
+  sim_RunUntil(end);
+  return pulses;
+}
+
+// ---------------------------------------------------------------------------
+static void interrupt_counting_merges(void)
+{
+  uint32_t merged = sim_gpiote_GetMerged();
+  uint32_t cnt = particle_cnt_Get();
+  uint32_t pulses = pulses_run(RATE_CPS, 990);
+  cnt = particle_cnt_Get() - cnt;
+  merged = sim_gpiote_GetMerged() - merged;
+
+  printf("  %u of %u pulses counted by interrupt\n", cnt, pulses);
+  CHECK(merged > 0);
+  CHECK_EQ(cnt + merged, pulses);
+}
+
+// ---------------------------------------------------------------------------
+static void hw_counter_no_loss(void)
+{
+  (void)pulses_run(RATE_CPS, 100);          // rate update switches counter on
+  CHECK(sim_timer_IsRunning(2));
+
+  uint32_t irqs = sim_gpiote_GetIrqCnt();
+  uint32_t merged = sim_gpiote_GetMerged();
+  uint32_t runs = sched_GetRunCnt(SCHED_PULSE);
+  uint32_t cnt = particle_cnt_Get();
+  uint32_t pulses = pulses_run(RATE_CPS, 10000);
+  cnt = particle_cnt_Get() - cnt;
+
+  printf("  %u of %u pulses counted by timer, %u merged\n", cnt, pulses, sim_gpiote_GetMerged() - merged);
+  CHECK_EQ(cnt, pulses);
+  CHECK(sim_gpiote_GetMerged() > merged);                       // radio delayed interrupts
+  CHECK(sim_gpiote_GetIrqCnt() - irqs > pulses / 2);            // tiristor is reset per pulse
+  CHECK_EQ(sim_gpio_GetPull(PULSE_PIN), NRF_GPIO_PIN_PULLDOWN);
+  CHECK(sched_GetRunCnt(SCHED_PULSE) - runs <= 2 * 10 + 1);      // main loop isn't woken per pulse
+  CHECK(notified > 0);
+}
+
+// ---------------------------------------------------------------------------
+static void sound_takes_timer(void)
+{
+  CHECK(sim_timer_IsRunning(2));
+  uint32_t cnt = particle_cnt_Get();
+  uint32_t merged = sim_gpiote_GetMerged();
+  APP_ERROR_CHECK(app_timer_start(sound_tmr, MS_TO_TICK(500), (void *)true));
+  uint32_t pulses = pulses_run(RATE_CPS, 1000);
+  CHECK(!sim_timer_IsRunning(2));
+  pulses += pulses_run(RATE_CPS, 1000);
+
+  APP_ERROR_CHECK(app_timer_start(sound_tmr, MS_TO_TICK(100), (void *)false));
+  pulses += pulses_run(RATE_CPS, 1500);     // the next rate update takes timer back
+  CHECK(sim_timer_IsRunning(2));
+  pulses += pulses_run(RATE_CPS, 1000);
+
+  cnt = particle_cnt_Get() - cnt;
+  merged = sim_gpiote_GetMerged() - merged;
+  printf("  %u of %u pulses counted around melody, %u merged\n", cnt, pulses, merged);
+  // pulses are lost only by merged interrupts while the timer is borrowed
+  CHECK(cnt <= pulses);
+  CHECK(pulses - cnt > 0);
+  CHECK(pulses - cnt <= merged);
+}
+
+// ---------------------------------------------------------------------------
+static void back_to_interrupt(void)
+{
+  (void)pulses_run(10, 3000);
+  CHECK(!sim_timer_IsRunning(2));
+
+  uint32_t cnt = particle_cnt_Get();
+  uint32_t pulses = pulses_run(10, 5000);
+  CHECK_EQ(particle_cnt_Get() - cnt, pulses);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(3);
+  app_time_Init();
+  sched_Register(SCHED_PULSE, particle_cnt_Process);
+  sim_SetMainLoop(main_loop, NULL);
+  sim_SetRadioBlock(RADIO_PERIOD, RADIO_LEN);
+
+  particle_cnt_Init();
+  particle_cnt_Startup();
+  APP_ERROR_CHECK(app_timer_create(&rate_tmr, APP_TIMER_MODE_REPEATED, on_rate_tmr));
+  APP_ERROR_CHECK(app_timer_start(rate_tmr, MS_TO_TICK(1000), NULL));
+  APP_ERROR_CHECK(app_timer_create(&sound_tmr, APP_TIMER_MODE_SINGLE_SHOT, on_sound_tmr));
+
+  TEST_RUN(interrupt_counting_merges);
+  TEST_RUN(hw_counter_no_loss);
+  TEST_RUN(sound_takes_timer);
+  TEST_RUN(back_to_interrupt);
+  return TEST_RESULT();
+}
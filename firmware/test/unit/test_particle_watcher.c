@@ -0,0 +1,233 @@
+#include <time.h>
+#include "sdk_common.h"
+#include "scheduler.h"
+#include "dead_time.h"
+#include "particle_watcher.h"
+#include "test.h"
+
+// Particle watcher: bars finished in timer interrupt reach timeframes even if
+// main loop comes late, ring timeframes give the same bars as sums of full history
+// and the same bars and volumes as the previous shifting timeframes fed alike.
+// Benchmark of bar insert against the previous one
+
+#define OLD_S             (24 * 3600)
+#define BENCH_BARS        200000
+
+// ---------------------------------------------------------------------------
+// frame_serv of the previous particle_watcher.c: shift, full volume loop, recursion
+typedef struct
+{
+  uint32_t  *accum;
+  uint32_t  size;
+  uint32_t  volume;
+  uint8_t   shift_cnt;
+} old_frame_t;
+
+#define OLD_FRAME_DEF(_size)                  \
+{                                             \
+  .accum = (uint32_t*)&(uint32_t[_size]){0},  \
+  .size = _size,                              \
+  .volume = 0,                                \
+  .shift_cnt = 0,                             \
+ }
+
+static old_frame_t old_frames[PWT_TIMEFRAMES_TOTAL] =
+{
+  OLD_FRAME_DEF(4),
+  OLD_FRAME_DEF(6),
+  OLD_FRAME_DEF(5),
+  OLD_FRAME_DEF(6),
+  OLD_FRAME_DEF(4),
+};
+
+static void old_frame_serv(uint8_t fr_num, uint32_t val)
+{
+  if (fr_num < PWT_TIMEFRAMES_TOTAL)
+  {
+    old_frame_t *fr = &old_frames[fr_num];
+
+    fr->volume = 0;
+    for (uint8_t i=0; i<fr->size - 1; i++)
+    {
+      fr->accum[i] = fr->accum[i+1];
+      fr->volume +=  fr->accum[i];
+    }
+    fr->accum[fr->size - 1] = val;
+    fr->volume += val;
+
+    if (++fr->shift_cnt >= fr->size)
+    {
+      fr->shift_cnt = 0;
+      old_frame_serv(fr_num + 1, fr->volume); // recursive call
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t evq_bars;
+
+// every finished bar goes to the previous timeframes too
+void EVQ_Tick(uint32_t bar)
+{
+  evq_bars++;
+  old_frame_serv(0, DTC_Correct(bar, PWT_BAR_S * 1000));
+}
+
+// feeds one bar of PWT_BAR_S base ticks
+static void bar_feed(uint32_t bar)
+{
+  for (uint32_t t = 0; t < PWT_BAR_S; t++)
+  {
+    PWT_Tick(bar / PWT_BAR_S + ((t < bar % PWT_BAR_S) ? 1 : 0));
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void late_process(void)
+{
+  static const uint32_t bars[] = {1000, 2000, 3000};
+  uint32_t got[PWT_BARS_MAX];
+
+  for (uint32_t i = 0; i < ARRAY_SIZE(bars); i++)
+  {
+    bar_feed(bars[i]);
+  }
+  CHECK_EQ(evq_bars, ARRAY_SIZE(bars));
+  CHECK(sched_IsPending());
+  sched_Run();
+
+  uint8_t n = PWT_GetBars(0, got, ARRAY_SIZE(bars));
+  CHECK_EQ(n, ARRAY_SIZE(bars));
+  for (uint32_t i = 0; i < n; i++)
+  {
+    CHECK_EQ(got[i], DTC_Correct(bars[i], PWT_BAR_S * 1000));
+  }
+  CHECK_EQ(PWT_GetPending(), 0);
+}
+
+// ---------------------------------------------------------------------------
+// every bar of timeframe is sum of aligned group of the shorter timeframe bars
+static void rings_vs_naive(void)
+{
+  static const uint8_t sizes[PWT_TIMEFRAMES_TOTAL] = {4, 6, 5, 6, 4};
+  static uint32_t history[3 + 3 * 8 * 360];   // 10 s bars of late_process and 24 hours
+  uint32_t n = ARRAY_SIZE(history);
+  uint32_t mismatch = 0;
+
+  history[0] = DTC_Correct(1000, PWT_BAR_S * 1000);
+  history[1] = DTC_Correct(2000, PWT_BAR_S * 1000);
+  history[2] = DTC_Correct(3000, PWT_BAR_S * 1000);
+  for (uint32_t b = 3; b < n; b++)
+  {
+    uint32_t bar = 4 + test_Rand() % 50;
+    bar_feed(bar);
+    sched_Run();
+    history[b] = DTC_Correct(bar, PWT_BAR_S * 1000);
+
+    // at random moments and at the end
+    if ((b != n - 1) && (test_Rand() % 16))
+    {
+      continue;
+    }
+    uint32_t span = 1;      // 10 s bars in a bar of timeframe
+    for (uint8_t tf = 0; tf < PWT_TIMEFRAMES_TOTAL; tf++)
+    {
+      uint32_t got[PWT_BARS_MAX];
+      uint8_t cnt = PWT_GetBars(tf, got, PWT_BARS_MAX);
+      CHECK_EQ(cnt, sizes[tf]);
+
+      // the newest finished bar of timeframe ends at the last multiple of span
+      uint32_t end = (b + 1) - (b + 1) % span;
+      for (uint8_t i = 0; i < cnt; i++)
+      {
+        int64_t from = (int64_t)end - (int64_t)(cnt - i) * span;
+        uint32_t expected = 0;
+        for (int64_t k = MAX(from, 0); k < from + span; k++)
+        {
+          expected += history[k];     // rings start with zero bars
+        }
+        mismatch += (got[i] != expected) ? 1 : 0;
+      }
+      PWT_Set_active_tf(tf);
+      uint32_t vol = 0;
+      for (uint8_t i = 0; i < cnt; i++)
+      {
+        vol += got[i];
+      }
+      CHECK_EQ(PWT_GetBarVol(), vol);
+      span *= sizes[tf];
+    }
+  }
+  CHECK_EQ(mismatch, 0);
+}
+
+// ---------------------------------------------------------------------------
+// the previous timeframes have been fed with the same bars from start
+static void matches_old(void)
+{
+  uint32_t mismatch = 0;
+  for (uint32_t b = 0; b < OLD_S / PWT_BAR_S; b++)
+  {
+    uint32_t bar = (test_Rand() % 8) ? test_Rand() % 60 : test_Rand() % 5000;
+    bar_feed(bar);
+    sched_Run();
+    for (uint8_t tf = 0; tf < PWT_TIMEFRAMES_TOTAL; tf++)
+    {
+      uint32_t got[PWT_BARS_MAX];
+      uint8_t cnt = PWT_GetBars(tf, got, PWT_BARS_MAX);
+      mismatch += (cnt != old_frames[tf].size) ? 1 : 0;
+      for (uint8_t i = 0; i < cnt; i++)
+      {
+        mismatch += (got[i] != old_frames[tf].accum[i]) ? 1 : 0;
+      }
+      PWT_Set_active_tf(tf);
+      mismatch += (PWT_GetBarVol() != old_frames[tf].volume) ? 1 : 0;
+    }
+  }
+  CHECK_EQ(mismatch, 0);
+}
+
+// ---------------------------------------------------------------------------
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Previous bar path was timer event and frame_serv(), the present one is 10 base
+// ticks, bar queue and PWT_Process(). EVQ_Tick feeds the previous frames on the
+// present path too, so their time is taken off
+static void benchmark(void)
+{
+  double start = now_ns();
+  for (uint32_t b = 0; b < BENCH_BARS; b++)
+  {
+    old_frame_serv(0, b & 0xFF);
+  }
+  double old_ns = (now_ns() - start) / BENCH_BARS;
+
+  start = now_ns();
+  for (uint32_t b = 0; b < BENCH_BARS; b++)
+  {
+    for (uint32_t t = 0; t < PWT_BAR_S; t++)
+    {
+      PWT_Tick(b & 0x1F);
+    }
+    PWT_Process();
+  }
+  double new_ns = (now_ns() - start) / BENCH_BARS - old_ns;
+  printf("  bar insert: shifting frames %.1f ns, rings %.1f ns with 10 ticks and queue\n", old_ns, new_ns);
+  CHECK(evq_bars > BENCH_BARS);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  sched_Register(SCHED_PWT, PWT_Process);
+  TEST_RUN(late_process);
+  TEST_RUN(rings_vs_naive);
+  TEST_RUN(matches_old);
+  TEST_RUN(benchmark);
+  return TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "pulse_sim.h"
+#include "sim.h"
+#include "test.h"
+
+// Pulse simulator: mean rate of every phase is kept with merged pulses of short
+// intervals, counts per second are Poisson, the train is the same after every start
+
+#if (PULSE_SIM_MODE == 0)
+#define RUN_S         600
+#else
+#define RUN_S         36000
+#endif
+
+// simulator runs in child processes, so both runs start from reset state
+typedef struct
+{
+  uint32_t  injected;
+  uint32_t  generated;
+  uint32_t  sec_cnt[RUN_S + 1];   // pulses of every second
+} run_t;
+
+static run_t *runs;
+static run_t *p_run;
+
+// ----------------------------------------------------------------------------
+void particle_cnt_Inject(uint32_t pulses)
+{
+  p_run->injected += pulses;
+  p_run->sec_cnt[sim_GetUs() / SIM_US_PER_SEC] += pulses;
+}
+
+// ---------------------------------------------------------------------------
+// counts of seconds [from, to) of the train
+static void stat_get(uint32_t from, uint32_t to, double *p_mean, double *p_var)
+{
+  double sum = 0, sum2 = 0;
+  for (uint32_t s = from; s < to; s++)
+  {
+    sum += p_run->sec_cnt[s];
+    sum2 += (double)p_run->sec_cnt[s] * p_run->sec_cnt[s];
+  }
+  *p_mean = sum / (to - from);
+  *p_var = sum2 / (to - from) - *p_mean * *p_mean;
+}
+
+#if (PULSE_SIM_MODE == 0)
+// ---------------------------------------------------------------------------
+static void rate(void)
+{
+  double cps = PULSE_SIM_BASE_RATE_MCPS / 1000.0;
+  double mean, var;
+  stat_get(1, RUN_S, &mean, &var);
+  printf("  %.0f cps: %.1f per second, dispersion %.3f\n", cps, mean, var / mean);
+  CHECK_EQ(p_run->injected, p_run->generated);
+  CHECK_NEAR(mean, cps, 4 * sqrt(cps / RUN_S));
+  CHECK_NEAR(var / mean, 1.0, 0.1);
+}
+#else
+// ---------------------------------------------------------------------------
+// phase borders move by an interval to the pulse, a guard of seconds is skipped around them
+static void phases(void)
+{
+  const uint32_t base_s = PULSE_SIM_BASE_TIME_S;
+  const uint32_t high_s = PULSE_SIM_HIGH_TIME_MS / 1000;
+  const uint32_t guard = 10;
+  double base_sum = 0, high_sum = 0, high_var = 0;
+  uint32_t cycles = RUN_S / (base_s + high_s);
+
+  for (uint32_t c = 0; c < cycles; c++)
+  {
+    uint32_t start = c * (base_s + high_s);
+    double mean, var;
+    stat_get(start + guard, start + base_s - guard, &mean, &var);
+    base_sum += mean;
+    stat_get(start + base_s + guard, start + base_s + high_s - guard, &mean, &var);
+    high_sum += mean;
+    high_var += var;
+  }
+  double base = base_sum / cycles, high = high_sum / cycles;
+  printf("  %u cycles: base %.3f cps, high %.3f cps, high dispersion %.3f\n",
+         cycles, base, high, high_var / high_sum);
+  CHECK_EQ(p_run->injected, p_run->generated);
+  CHECK_NEAR(base, PULSE_SIM_BASE_RATE_MCPS / 1000.0, 0.1);
+  CHECK_NEAR(high, PULSE_SIM_HIGH_RATE_MCPS / 1000.0, 0.5);
+  CHECK_NEAR(high_var / high_sum, 1.0, 0.15);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+static void train_run(run_t *p)
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    p_run = p;
+    app_time_Init();
+    PSIM_Init();
+    PSIM_Startup();
+    sim_Run(SIM_SEC(RUN_S));
+    p->generated = PSIM_GetGenerated();
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+}
+
+// ---------------------------------------------------------------------------
+// the second start gives the same train
+static void determinism(void)
+{
+  CHECK(runs[0].generated > 0);
+  CHECK_EQ(runs[1].generated, runs[0].generated);
+  CHECK(memcmp(runs[0].sec_cnt, runs[1].sec_cnt, sizeof(runs[0].sec_cnt)) == 0);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  runs = mmap(NULL, 2 * sizeof(run_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  train_run(&runs[0]);
+  train_run(&runs[1]);
+  p_run = &runs[0];
+
+#if (PULSE_SIM_MODE == 0)
+  TEST_RUN(rate);
+#else
+  TEST_RUN(phases);
+#endif
+  TEST_RUN(determinism);
+  return TEST_RESULT();
+}
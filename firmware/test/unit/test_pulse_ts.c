@@ -0,0 +1,246 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "particle_cnt.h"
+#include "ble_main.h"
+#include "varint.h"
+#include "sim.h"
+#include "sim_hw.h"
+#include "test.h"
+
+// Per-pulse timestamp capture: notifications decoded like the phone does give the RTC
+// tick of every pulse, pulses which didn't fit the ring while TX was stopped come as
+// the lost count of the next packet, and the highest pulse rate sent without loss
+// is measured on the link model of app_config.h
+
+#define CONN_INTERVAL_MS  50      // one notification per connection event
+#define RADIO_LEN_US      2500    // interrupts wait up to 3 ms
+#define PULSES_MAX        40000
+#define EXACT_S           60
+#define EXACT_CPS         20
+#define SWEEP_S           60
+#define SWEEP_FROM_CPS    50
+#define SWEEP_STEP_CPS    25
+#define DOC_CPS           225     // sustainable rate of app_config.h
+
+APP_TIMER_DEF(conn_tmr);
+
+static uint32_t pulse_tick[PULSES_MAX];   // RTC tick of every generated pulse
+static uint32_t pulses;
+static uint32_t next;         // pulse the next decoded timestamp belongs to
+static uint32_t delivered;
+static uint32_t lost;
+static uint32_t packets;
+static uint32_t tick_wrong;
+static uint32_t latency_max;  // ticks from pulse to its capture
+static bool     tx_free;
+static bool     link_up = true;   // peer acknowledges packets
+
+// ---------------------------------------------------------------------------
+void ble_ios_pulse_transfer(uint32_t pulse)
+{
+}
+
+// decoded as the phone does. Timestamps are matched to pulses in order, lost count skips some
+bool ble_ios_pulse_ts_transfer(const void *p_data, uint16_t len)
+{
+  if (!tx_free)
+  {
+    return false;
+  }
+  tx_free = false;
+  packets++;
+
+  const uint8_t *p = p_data;
+  uint32_t tick;
+  memcpy(&tick, p, sizeof(tick));
+  lost += p[sizeof(tick)];
+  next += p[sizeof(tick)];
+  uint8_t offset = sizeof(tick) + sizeof(uint8_t);
+  for (;;)
+  {
+    uint32_t t = tick - pulse_tick[next];
+    tick_wrong += (next >= pulses) || (t > latency_max) ? 1 : 0;
+    next++;
+    delivered++;
+
+    uint32_t delta;
+    uint8_t size = varint_decode(&p[offset], (uint8_t)(len - offset), &delta);
+    if (size == 0)
+    {
+      break;
+    }
+    offset += size;
+    tick += delta;
+  }
+  CHECK_EQ(offset, len);
+  return true;
+}
+
+// TX buffer is sent by connection event, SoftDevice reports BLE_EVT_TX_COMPLETE
+static void on_conn_tmr(void *p_ctx)
+{
+  if (link_up && !tx_free)
+  {
+    tx_free = true;
+    sched_Post(SCHED_PULSE);
+  }
+}
+
+static void main_loop(void *p_ctx)
+{
+  sched_Run();
+}
+
+// ---------------------------------------------------------------------------
+// pulses are at least min_us apart, so interrupts aren't merged unless radio delays them
+static void pulses_run(double cps, uint32_t ms, uint32_t min_us)
+{
+  uint64_t end = sim_GetUs() + SIM_MS(ms);
+  uint64_t t = sim_GetUs();
+  for (;;)
+  {
+    t += min_us + (uint64_t)test_Exp(SIM_US_PER_SEC / cps);
+    if (t >= end)
+    {
+      break;
+    }
+    sim_RunUntil(t);
+    ASSERT(pulses < PULSES_MAX);
+    pulse_tick[pulses++] = (uint32_t)sim_GetTicks();
+    sim_gpio_Pulse(PULSE_PIN);
+  }
+  sim_RunUntil(end);
+}
+
+// TX buffer stays busy until link is up again
+static void link_set(bool is_up)
+{
+  link_up = is_up;
+  if (!is_up)
+  {
+    tx_free = false;
+  }
+}
+
+static void counters_reset(void)
+{
+  pulses = 0;
+  next = 0;
+  delivered = 0;
+  lost = 0;
+  packets = 0;
+  tick_wrong = 0;
+}
+
+// ---------------------------------------------------------------------------
+// without radio the interrupt comes in the tick of pulse or the next one
+static void capture_exact(void)
+{
+  latency_max = 1;
+  counters_reset();
+  pulses_run(EXACT_CPS, EXACT_S * 1000, 100);
+  sim_Run(SIM_SEC(1));      // the last ones are sent
+
+  printf("  %u pulses in %u packets\n", delivered, packets);
+  CHECK_EQ(sim_gpiote_GetMerged(), 0);
+  CHECK_EQ(lost, 0);
+  CHECK_EQ(tick_wrong, 0);
+  CHECK_EQ(delivered, pulses);
+  CHECK(packets < pulses);
+}
+
+// ---------------------------------------------------------------------------
+// link is stopped for longer than the ring lasts, the next packet starts after the gap
+static void lost_in_upper_byte(void)
+{
+  latency_max = 1;
+  counters_reset();
+  link_set(false);
+  pulses_run(100, 3000, 100);
+  uint32_t pulses_down = pulses;
+  CHECK(pulses_down > PULSE_TS_RING_SIZE + 100);
+  CHECK_EQ(packets, 0);
+
+  link_set(true);
+  sim_Run(SIM_SEC(2));      // ring is sent before the next pulse
+  pulses_run(100, 3000, 100);
+  sim_Run(SIM_SEC(2));
+
+  printf("  %u pulses, %u sent, %u reported lost\n", pulses, delivered, lost);
+  // the ring keeps the first pulses of the gap, the rest are reported
+  CHECK_EQ(lost, pulses_down - PULSE_TS_RING_SIZE);
+  CHECK_EQ(tick_wrong, 0);
+  CHECK_EQ(delivered + lost, pulses);
+}
+
+// lost count is saturated, the gap is reported as 255 pulses at least
+static void lost_saturates(void)
+{
+  latency_max = 1;
+  counters_reset();
+  link_set(false);
+  pulses_run(200, 5000, 100);
+  CHECK(pulses > PULSE_TS_RING_SIZE + UINT8_MAX);
+  link_set(true);
+  sim_Run(SIM_SEC(2));
+  pulses_run(200, 1000, 100);
+  sim_Run(SIM_SEC(2));
+
+  printf("  %u pulses, %u sent, %u reported lost\n", pulses, delivered, lost);
+  CHECK_EQ(lost, UINT8_MAX);
+  CHECK(delivered > PULSE_TS_RING_SIZE);
+  CHECK(delivered + lost < pulses);
+}
+
+// ---------------------------------------------------------------------------
+// Poisson pulses with radio events, interrupts merged by radio aren't captured
+static bool is_sustainable(double cps)
+{
+  latency_max = MS_TO_TICK(3);  // interrupt waits for radio event
+  counters_reset();
+  uint32_t merged = sim_gpiote_GetMerged();
+  pulses_run(cps, SWEEP_S * 1000, 0);
+  sim_Run(SIM_SEC(5));
+  merged = sim_gpiote_GetMerged() - merged;
+
+  printf("  %4.0f cps: %u pulses, %u packets, %u lost, %u merged\n", cps, pulses, packets, lost, merged);
+  CHECK_EQ(delivered + lost + merged, pulses);
+  return (lost == 0);
+}
+
+static void max_rate(void)
+{
+  sim_SetRadioBlock(SIM_MS(CONN_INTERVAL_MS), RADIO_LEN_US);
+  uint32_t cps = SWEEP_FROM_CPS;
+  while (is_sustainable(cps))
+  {
+    cps += SWEEP_STEP_CPS;
+  }
+  cps -= SWEEP_STEP_CPS;
+  sim_SetRadioBlock(0, 0);
+
+  printf("  sustainable up to %u cps\n", cps);
+  CHECK(cps >= DOC_CPS);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(12);
+  app_time_Init();
+  sched_Register(SCHED_PULSE, particle_cnt_Process);
+  sim_SetMainLoop(main_loop, NULL);
+
+  particle_cnt_Init();
+  particle_cnt_Startup();
+  APP_ERROR_CHECK(app_timer_create(&conn_tmr, APP_TIMER_MODE_REPEATED, on_conn_tmr));
+  APP_ERROR_CHECK(app_timer_start(conn_tmr, MS_TO_TICK(CONN_INTERVAL_MS), NULL));
+
+  TEST_RUN(capture_exact);
+  TEST_RUN(lost_in_upper_byte);
+  TEST_RUN(lost_saturates);
+  TEST_RUN(max_rate);
+  return TEST_RESULT();
+}
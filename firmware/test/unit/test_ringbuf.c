@@ -0,0 +1,464 @@
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "sdk_common.h"
+#include "ringbuf.h"
+#include "sim.h"
+#include "test.h"
+
+// Ring buffer: two segment direct read and write give the same bytes as copying
+// access at every position of buffer end, full and empty states stay apart.
+// SPSC ring buffer keeps order over buffer end and 32 bit index wrap, overflow is cut,
+// producer and consumer preempting each other at every barrier or on threads lose no byte.
+// Benchmark of event record traffic against the byte ring buffer
+
+#define RB_SIZE       16
+#define STRESS_SIZE   64
+#define STRESS_BYTES  20000000ull   // RINGBUF_STRESS_BYTES environment variable overrides
+#define PREEMPT_OPS   1000000
+#define BENCH_RECORDS 2000000
+#define RECORD_LEN    3             // event_queue record of one hour
+
+RING_BUF_DEF(m_rb, RB_SIZE);
+SPSC_RING_BUF_DEF(m_spsc, RB_SIZE);
+SPSC_RING_BUF_DEF(m_stress, STRESS_SIZE);
+RING_BUF_DEF(m_bench_rb, STRESS_SIZE);
+
+// fills buffer so the oldest byte is at start position
+static void rb_place(size_t start)
+{
+  uint8_t dummy[RB_SIZE];
+  size_t size = start;
+  ringbufReset(&m_rb);
+  ringbufPut(&m_rb, dummy, start);
+  ringbufGet(&m_rb, dummy, &size);
+}
+
+// ---------------------------------------------------------------------------
+static void read_seg(void)
+{
+  for (size_t start = 0; start < RB_SIZE; start++)
+  {
+    for (size_t len = 0; len <= RB_SIZE; len++)
+    {
+      uint8_t src[RB_SIZE];
+      for (size_t i = 0; i < len; i++)
+      {
+        src[i] = (uint8_t)(start * 31 + i);
+      }
+      rb_place(start);
+      CHECK_EQ(ringbufPut(&m_rb, src, len), len);
+
+      ringbuf_seg_t seg[2];
+      CHECK_EQ(ringbufOpenDirectReadSeg(&m_rb, seg), NRF_SUCCESS);
+      CHECK_EQ(seg[0].size + seg[1].size, len);
+      CHECK(seg[0].p_data == m_rb.p_buffer + start);
+      CHECK(seg[1].p_data == m_rb.p_buffer);
+      CHECK_EQ(seg[0].size, MIN(len, RB_SIZE - start));
+      CHECK(memcmp(seg[0].p_data, src, seg[0].size) == 0);
+      CHECK(memcmp(seg[1].p_data, src + seg[0].size, seg[1].size) == 0);
+
+      // second access and copying read wait for apply
+      ringbuf_seg_t again[2];
+      uint8_t dst[RB_SIZE];
+      size_t size = 1;
+      if (len)
+      {
+        CHECK_EQ(ringbufOpenDirectReadSeg(&m_rb, again), NRF_ERROR_BUSY);
+        CHECK_EQ(ringbufGet(&m_rb, dst, &size), NRF_ERROR_BUSY);
+      }
+
+      // partial release keeps the rest in order
+      size_t part = len / 2;
+      ringbufApplyRead(&m_rb, part);
+      CHECK_EQ(ringbufGetFull(&m_rb), len - part);
+      size = RB_SIZE;
+      CHECK_EQ(ringbufGet(&m_rb, dst, &size), NRF_SUCCESS);
+      CHECK_EQ(size, len - part);
+      CHECK(memcmp(dst, src + part, size) == 0);
+      CHECK_EQ(ringbufGetFree(&m_rb), RB_SIZE);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void write_seg(void)
+{
+  for (size_t start = 0; start < RB_SIZE; start++)
+  {
+    for (size_t len = 0; len <= RB_SIZE; len++)
+    {
+      rb_place(start);
+
+      ringbuf_seg_t seg[2];
+      CHECK_EQ(ringbufOpenDirectWriteSeg(&m_rb, seg), NRF_SUCCESS);
+      CHECK_EQ(seg[0].size + seg[1].size, RB_SIZE);
+      CHECK(seg[0].p_data == m_rb.p_buffer + start);
+      CHECK_EQ(seg[1].size, start);
+
+      // data is built in place across buffer end
+      for (size_t i = 0; i < len; i++)
+      {
+        uint8_t *p = (i < seg[0].size) ? &seg[0].p_data[i] : &seg[1].p_data[i - seg[0].size];
+        *p = (uint8_t)(start * 7 + i);
+      }
+      if (len)
+      {
+        uint8_t byte = 0;
+        CHECK_EQ(ringbufPut(&m_rb, &byte, 1), 0);     // writer is busy
+      }
+      ringbufApplyWrite(&m_rb, len);
+
+      CHECK_EQ(ringbufGetFull(&m_rb), len);
+      CHECK_EQ(ringbufGetFree(&m_rb), RB_SIZE - len);
+      uint8_t dst[RB_SIZE];
+      size_t size = RB_SIZE;
+      CHECK_EQ(ringbufGet(&m_rb, dst, &size), NRF_SUCCESS);
+      CHECK_EQ(size, len);
+      for (size_t i = 0; i < size; i++)
+      {
+        CHECK_EQ(dst[i], (uint8_t)(start * 7 + i));
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// apply of zero only closes access, head == tail of full buffer isn't taken as empty
+static void full_and_empty(void)
+{
+  uint8_t src[RB_SIZE] = {0};
+  ringbuf_seg_t seg[2];
+
+  rb_place(5);
+  ringbufPut(&m_rb, src, RB_SIZE);
+  CHECK_EQ(ringbufGetFull(&m_rb), RB_SIZE);
+  CHECK_EQ(ringbufOpenDirectWriteSeg(&m_rb, seg), NRF_SUCCESS);
+  CHECK_EQ(seg[0].size + seg[1].size, 0);
+  ringbufApplyWrite(&m_rb, 0);
+  CHECK_EQ(ringbufOpenDirectReadSeg(&m_rb, seg), NRF_SUCCESS);
+  ringbufApplyRead(&m_rb, 0);
+  CHECK_EQ(ringbufGetFull(&m_rb), RB_SIZE);
+  CHECK_EQ(ringbufOpenDirectReadSeg(&m_rb, seg), NRF_SUCCESS);
+  ringbufApplyRead(&m_rb, RB_SIZE);
+  CHECK_EQ(ringbufGetFull(&m_rb), 0);
+  CHECK_EQ(ringbufGetFree(&m_rb), RB_SIZE);
+}
+
+// ---------------------------------------------------------------------------
+// random puts, peeks and releases against a plain byte counter model
+static void spsc_model(uint32_t start)
+{
+  uint8_t  put_next = 0;    // the next byte producer writes
+  uint8_t  get_next = 0;    // the next byte consumer expects
+  uint32_t stored = 0;
+  uint32_t errors = 0;
+
+  spscRingbufInit(&m_spsc);
+  m_spsc.data->wr = m_spsc.data->rd = start;
+  for (uint32_t op = 0; op < 200000; op++)
+  {
+    uint8_t buf[2 * RB_SIZE];
+    size_t len = test_Rand() % (RB_SIZE + 4);
+    if (test_Rand() & 1)
+    {
+      for (size_t i = 0; i < len; i++)
+      {
+        buf[i] = (uint8_t)(put_next + i);
+      }
+      size_t put = spscRingbufPut(&m_spsc, buf, len);
+      errors += (put != MIN(len, RB_SIZE - stored)) ? 1 : 0;   // overflow is cut, not wrapped
+      put_next += put;
+      stored += put;
+    }
+    else
+    {
+      size_t offset = (stored && (test_Rand() & 1)) ? test_Rand() % stored : 0;
+      size_t got = spscRingbufPeek(&m_spsc, offset, buf, len);
+      errors += (got != ((offset < stored) ? MIN(len, stored - offset) : 0)) ? 1 : 0;
+      for (size_t i = 0; i < got; i++)
+      {
+        errors += (buf[i] != (uint8_t)(get_next + offset + i)) ? 1 : 0;
+      }
+      if (offset == 0)
+      {
+        spscRingbufRelease(&m_spsc, got);
+        get_next += got;
+        stored -= got;
+      }
+    }
+    errors += (spscRingbufGetFull(&m_spsc) != stored) ? 1 : 0;
+    errors += (spscRingbufGetFree(&m_spsc) != RB_SIZE - stored) ? 1 : 0;
+  }
+  CHECK_EQ(errors, 0);
+}
+
+static void spsc_wrap(void)
+{
+  spsc_model(0);
+  spsc_model(UINT32_MAX - RB_SIZE / 2);    // indexes wrap soon
+  spsc_model(UINT32_MAX - 3 * RB_SIZE - 1);
+}
+
+// ---------------------------------------------------------------------------
+static void spsc_overflow(void)
+{
+  uint8_t src[RB_SIZE + 5], dst[RB_SIZE + 5];
+  for (size_t i = 0; i < sizeof(src); i++)
+  {
+    src[i] = (uint8_t)(i + 1);
+  }
+  spscRingbufInit(&m_spsc);
+  m_spsc.data->wr = m_spsc.data->rd = UINT32_MAX - 2;
+
+  CHECK_EQ(spscRingbufPut(&m_spsc, src, sizeof(src)), RB_SIZE);
+  CHECK_EQ(spscRingbufGetFree(&m_spsc), 0);
+  CHECK_EQ(spscRingbufPut(&m_spsc, src, 1), 0);
+  CHECK_EQ(spscRingbufPeek(&m_spsc, RB_SIZE, dst, 1), 0);
+
+  CHECK_EQ(spscRingbufGet(&m_spsc, dst, sizeof(dst)), RB_SIZE);
+  CHECK(memcmp(dst, src, RB_SIZE) == 0);
+  CHECK_EQ(spscRingbufGetFull(&m_spsc), 0);
+  CHECK_EQ(spscRingbufGet(&m_spsc, dst, sizeof(dst)), 0);
+}
+
+// ---------------------------------------------------------------------------
+// byte of position in stream, period isn't a power of two to catch lost and doubled chunks
+static uint8_t stream_byte(uint64_t pos)
+{
+  return (uint8_t)(pos % 251);
+}
+
+// ---------------------------------------------------------------------------
+// Both sides run on one thread, one preempts the other inside its put or get at
+// every barrier, the place where memory order of lock-free code matters
+typedef struct
+{
+  uint64_t  put_pos;
+  uint64_t  get_pos;
+  uint64_t  errors;
+  bool      is_producer;    // side which runs now
+} preempt_t;
+
+static void producer_step(preempt_t *p)
+{
+  uint8_t chunk[STRESS_SIZE / 2];
+  size_t len = 1 + test_Rand() % sizeof(chunk);
+  for (size_t i = 0; i < len; i++)
+  {
+    chunk[i] = stream_byte(p->put_pos + i);
+  }
+  p->put_pos += spscRingbufPut(&m_stress, chunk, len);
+}
+
+static void consumer_step(preempt_t *p)
+{
+  uint8_t buf[STRESS_SIZE];
+  size_t got;
+  if (test_Rand() & 1)
+  {
+    got = spscRingbufGet(&m_stress, buf, 1 + test_Rand() % sizeof(buf));
+  }
+  else
+  {
+    got = spscRingbufPeek(&m_stress, 0, buf, sizeof(buf));
+    spscRingbufRelease(&m_stress, got);
+  }
+  for (size_t i = 0; i < got; i++)
+  {
+    p->errors += (buf[i] != stream_byte(p->get_pos + i)) ? 1 : 0;
+  }
+  p->get_pos += got;
+}
+
+static void run_side(preempt_t *p, bool is_producer)
+{
+  bool was_producer = p->is_producer;
+  p->is_producer = is_producer;
+  if (is_producer)
+  {
+    producer_step(p);
+  }
+  else
+  {
+    consumer_step(p);
+  }
+  p->is_producer = was_producer;
+}
+
+static void on_barrier(void *p_ctx)
+{
+  preempt_t *p = p_ctx;
+  if (test_Rand() & 1)
+  {
+    run_side(p, !p->is_producer);
+  }
+}
+
+static void spsc_preempt(void)
+{
+  preempt_t state = { 0 };
+  spscRingbufInit(&m_stress);
+  m_stress.data->wr = m_stress.data->rd = UINT32_MAX - 1000;
+  sim_SetBarrierHook(on_barrier, &state);
+  for (uint32_t op = 0; op < PREEMPT_OPS; op++)
+  {
+    run_side(&state, test_Rand() & 1);
+  }
+  sim_SetBarrierHook(NULL, NULL);
+  printf("  %llu bytes, %llu wrong\n", (unsigned long long)state.get_pos, (unsigned long long)state.errors);
+  CHECK_EQ(state.errors, 0);
+  CHECK_EQ(state.put_pos - state.get_pos, spscRingbufGetFull(&m_stress));
+}
+
+// ---------------------------------------------------------------------------
+// Two threads for hosts with several cores, there they run really in parallel
+static uint64_t stress_bytes;
+
+// interrupt-like producer: chunks of random length, no wait but yield when full
+static void *producer(void *p_arg)
+{
+  uint64_t pos = 0;
+  uint32_t seed = 12345;
+  while (pos < stress_bytes)
+  {
+    uint8_t chunk[STRESS_SIZE / 2];
+    seed = seed * 1103515245 + 12345;
+    size_t len = 1 + (seed >> 16) % sizeof(chunk);
+    len = (size_t)MIN(len, stress_bytes - pos);
+    for (size_t i = 0; i < len; i++)
+    {
+      chunk[i] = stream_byte(pos + i);
+    }
+    size_t put = spscRingbufPut(&m_stress, chunk, len);
+    pos += put;
+    if (put < len)
+    {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+// main loop consumer: copying get and peek with late release by turns
+static void spsc_threads(void)
+{
+  const char *p_env = getenv("RINGBUF_STRESS_BYTES");
+  stress_bytes = p_env ? strtoull(p_env, NULL, 0) : STRESS_BYTES;
+  spscRingbufInit(&m_stress);
+  m_stress.data->wr = m_stress.data->rd = UINT32_MAX - 1000;   // indexes wrap on the way
+
+  pthread_t thread;
+  CHECK_EQ(pthread_create(&thread, NULL, producer, NULL), 0);
+  uint64_t pos = 0;
+  uint64_t errors = 0;
+  uint32_t turn = 0;
+  while (pos < stress_bytes)
+  {
+    uint8_t buf[STRESS_SIZE];
+    size_t got;
+    turn++;
+    if (turn & 1)
+    {
+      got = spscRingbufGet(&m_stress, buf, 1 + turn % sizeof(buf));
+    }
+    else
+    {
+      got = spscRingbufPeek(&m_stress, 0, buf, sizeof(buf));
+      spscRingbufRelease(&m_stress, got);
+    }
+    for (size_t i = 0; i < got; i++)
+    {
+      errors += (buf[i] != stream_byte(pos + i)) ? 1 : 0;
+    }
+    pos += got;
+    if (got == 0)
+    {
+      sched_yield();
+    }
+  }
+  pthread_join(thread, NULL);
+  printf("  %llu bytes, %llu wrong\n", (unsigned long long)pos, (unsigned long long)errors);
+  CHECK_EQ(errors, 0);
+  CHECK_EQ(pos, stress_bytes);
+  CHECK_EQ(spscRingbufGetFull(&m_stress), 0);
+}
+
+// ---------------------------------------------------------------------------
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// put and get of a record per turn with a few records stored, like event queue does
+static void benchmark(void)
+{
+  uint8_t rec[RECORD_LEN] = {1, 2, 3};
+  uint8_t dst[RECORD_LEN];
+  uint32_t sum_rb = 0;
+  uint32_t sum_spsc = 0;
+
+  ringbufInit(&m_bench_rb);
+  double start = now_ns();
+  for (uint32_t i = 0; i < BENCH_RECORDS; i++)
+  {
+    rec[0] = (uint8_t)i;
+    ringbufPut(&m_bench_rb, rec, RECORD_LEN);
+    if (i >= 4)
+    {
+      size_t size = RECORD_LEN;
+      ringbufGet(&m_bench_rb, dst, &size);
+      sum_rb += dst[0];
+    }
+  }
+  double rb_ns = (now_ns() - start) / BENCH_RECORDS;
+
+  spscRingbufInit(&m_stress);
+  start = now_ns();
+  for (uint32_t i = 0; i < BENCH_RECORDS; i++)
+  {
+    rec[0] = (uint8_t)i;
+    spscRingbufPut(&m_stress, rec, RECORD_LEN);
+    if (i >= 4)
+    {
+      spscRingbufGet(&m_stress, dst, RECORD_LEN);
+      sum_spsc += dst[0];
+    }
+  }
+  double spsc_ns = (now_ns() - start) / BENCH_RECORDS;
+
+  start = now_ns();
+  for (uint32_t i = 0; i < BENCH_RECORDS; i++)
+  {
+    __DMB();
+    __DMB();
+    __DMB();
+    __DMB();
+  }
+  double dmb_ns = (now_ns() - start) / BENCH_RECORDS;
+
+  // Host time only compares the two. SPSC put and get take 4 barriers, they are full
+  // fences of some ns on host and DMB of a few cycles on Cortex-M0. Critical regions
+  // ringbuf users need around it aren't counted
+  printf("  put + get of %u byte record: ringbuf %.1f ns, spsc %.1f ns, %.1f ns of it are 4 barriers\n",
+         RECORD_LEN, rb_ns, spsc_ns, dmb_ns);
+  CHECK_EQ(sum_rb, sum_spsc);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  ringbufInit(&m_rb);
+  TEST_RUN(read_seg);
+  TEST_RUN(write_seg);
+  TEST_RUN(full_and_empty);
+  TEST_RUN(spsc_wrap);
+  TEST_RUN(spsc_overflow);
+  TEST_RUN(spsc_preempt);
+  TEST_RUN(spsc_threads);
+  TEST_RUN(benchmark);
+  return TEST_RESULT();
+}
@@ -0,0 +1,257 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "particle_watcher.h"
+#include "event_queue.h"
+#include "sim.h"
+#include "test.h"
+
+// Staged aggregation from base tick to hourly record: record is the sum of 360 bars of
+// PWT_BAR_S with every pulse of its hour, not finished hour read at any second is
+// pulses since the last record, and 2 h timeframe bars are sums of hourly records.
+// Dead time correction is off in the default build, so bars are raw pulses.
+// Outputs are also compared every second with the old roll-up running alongside on
+// the same pulses: 10 s app_timer sampling the pulse counter into shifting timeframes
+// and 1 h app_timer sampling it into hourly records, as particle_watcher.c and
+// event_queue.c did before the RPW tick drove them
+
+#define HOURS             8
+#define BARS_PER_HOUR     (3600 / PWT_BAR_S)
+#define UTC_START         1500000000ull
+
+static uint32_t hour_sum[HOURS];
+static uint32_t total;      // pulse counter the old roll-up samples
+
+// ----------------------------------------------------------------------------
+//    OLD ROLL-UP
+// ----------------------------------------------------------------------------
+#define OLD_FRAME_DEF(_size)                  \
+{                                             \
+  .accum = (uint32_t*)&(uint32_t[_size]){0},  \
+  .size = _size,                              \
+}
+
+typedef struct
+{
+  uint32_t  *accum;
+  uint32_t  size;
+  uint32_t  volume;
+  uint8_t   shift_cnt;
+} old_frame_t;
+
+static old_frame_t old_frames[PWT_TIMEFRAMES_TOTAL] =
+{
+  OLD_FRAME_DEF(40 / 10),
+  OLD_FRAME_DEF(240 / 40),
+  OLD_FRAME_DEF(1200 / 240),
+  OLD_FRAME_DEF(7200 / 1200),
+  OLD_FRAME_DEF(8 * 3600 / 7200),
+};
+
+APP_TIMER_DEF(old_pwt_tmr);
+static bool     old_is_timer_evt;
+static uint32_t old_pr;
+static uint32_t old_cnt_prev;
+static uint32_t old_records[HOURS];
+static uint32_t old_records_cnt;
+
+static void old_frame_serv(uint8_t fr_num, uint32_t val)
+{
+  if (fr_num < PWT_TIMEFRAMES_TOTAL)
+  {
+    old_frame_t *fr = &old_frames[fr_num];
+    fr->volume = 0;
+    for (uint8_t i = 0; i < fr->size - 1; i++)
+    {
+      fr->accum[i] = fr->accum[i + 1];
+      fr->volume += fr->accum[i];
+    }
+    fr->accum[fr->size - 1] = val;
+    fr->volume += val;
+    if (++fr->shift_cnt >= fr->size)
+    {
+      fr->shift_cnt = 0;
+      old_frame_serv(fr_num + 1, fr->volume);
+    }
+  }
+}
+
+// PWT: timer interrupt wakes main loop, bar is the counter delta since the previous one
+static void old_pwt_on_tmr(void *p_ctx)
+{
+  old_is_timer_evt = true;
+}
+
+static void old_main_loop(void *p_ctx)
+{
+  if (old_is_timer_evt)
+  {
+    old_is_timer_evt = false;
+    uint32_t pr_new = total;
+    uint16_t delta = pr_new - old_pr;
+    old_pr = pr_new;
+    old_frame_serv(0, delta);
+  }
+}
+
+// EVQ: hour record is the counter delta taken in timer interrupt, 24 bit are stored.
+// 1 h is over RTC1 range of the simulated app_timer, so the timer is a simulator event
+static void old_evq_on_tmr(void *p_ctx)
+{
+  ASSERT(old_records_cnt < HOURS);
+  old_records[old_records_cnt++] = (total - old_cnt_prev) & 0x00FFFFFF;
+  old_cnt_prev = total;
+  sim_At(sim_GetUs() + SIM_SEC(3600), old_evq_on_tmr, NULL);
+}
+
+static uint32_t old_uncomplete(void)
+{
+  return (total - old_cnt_prev) | 0x80000000;
+}
+
+static void old_start(void)
+{
+  APP_ERROR_CHECK(app_timer_create(&old_pwt_tmr, APP_TIMER_MODE_REPEATED, old_pwt_on_tmr));
+  APP_ERROR_CHECK(app_timer_start(old_pwt_tmr, MS_TO_TICK(10 * 1000), NULL));
+  sim_At(sim_GetUs() + SIM_SEC(3600), old_evq_on_tmr, NULL);
+  sim_SetMainLoop(old_main_loop, NULL);
+}
+
+// every bar of all timeframes and volume of the active one
+static uint32_t old_frames_mismatch(void)
+{
+  uint32_t mismatch = 0;
+  uint8_t tf_active = PWT_Get_active_tf();
+  for (uint8_t tf = 0; tf < PWT_TIMEFRAMES_TOTAL; tf++)
+  {
+    uint32_t got[PWT_BARS_MAX];
+    uint8_t n = PWT_GetBars(tf, got, PWT_BARS_MAX);
+    mismatch += (n != old_frames[tf].size) ? 1 : 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+      mismatch += (got[i] != old_frames[tf].accum[i]) ? 1 : 0;
+    }
+    PWT_Set_active_tf(tf);
+    mismatch += (PWT_GetBarVol() != old_frames[tf].volume) ? 1 : 0;
+  }
+  PWT_Set_active_tf(tf_active);
+  return mismatch;
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t second_cnt(void)
+{
+  uint32_t cnt = test_Rand() % 40;
+  if ((test_Rand() % 200) == 0)
+  {
+    cnt += 5000;      // burst
+  }
+  return cnt;
+}
+
+// one base tick as RPW timer gives it, PWT_Process runs in main loop.
+// Pulses come in the middle of second, so old timers on whole seconds see the same ones
+static void tick(uint32_t cnt)
+{
+  sim_Run(SIM_MS(500));
+  total += cnt;
+  sim_Run(SIM_MS(500));
+  PWT_Tick(cnt);
+  sched_Run();
+}
+
+// ---------------------------------------------------------------------------
+static void hour_records(void)
+{
+  uint32_t uncomplete_wrong = 0;
+  uint32_t record_wrong = 0;
+  for (uint32_t h = 0; h < HOURS; h++)
+  {
+    uint32_t sum = 0;
+    for (uint32_t sec = 0; sec < 3600; sec++)
+    {
+      uint32_t cnt = second_cnt();
+      tick(cnt);
+      sum += cnt;
+      // the last tick of hour makes the record, the next hour is empty yet
+      uint32_t expected = (sec == 3600 - 1) ? 0 : sum;
+      uncomplete_wrong += (EVQ_GetUncomplete() != (expected | 0x80000000)) ? 1 : 0;
+    }
+    hour_sum[h] = sum;
+    CHECK_EQ(EVQ_GetEventsAmount(), 1);
+    CHECK_EQ(EVQ_GetNextSeq(), h + 1);
+    record_wrong += (EVQ_GetEvt() != sum) ? 1 : 0;
+  }
+  CHECK_EQ(uncomplete_wrong, 0);
+  CHECK_EQ(record_wrong, 0);
+}
+
+// 2 h timeframe and 20 min one covering the last 2 h roll up the same pulses
+static void timeframes_match_records(void)
+{
+  uint32_t got[PWT_BARS_MAX];
+  uint8_t n = PWT_GetBars(PWT_TIMEFRAMES_TOTAL - 1, got, PWT_BARS_MAX);
+  CHECK_EQ(n, HOURS / 2);
+  for (uint8_t i = 0; i < n; i++)
+  {
+    CHECK_EQ(got[i], hour_sum[2 * i] + hour_sum[2 * i + 1]);
+  }
+
+  n = PWT_GetBars(PWT_TIMEFRAMES_TOTAL - 2, got, PWT_BARS_MAX);
+  uint32_t vol = 0;
+  for (uint8_t i = 0; i < n; i++)
+  {
+    vol += got[i];
+  }
+  CHECK_EQ(vol, hour_sum[HOURS - 2] + hour_sum[HOURS - 1]);
+}
+
+// ---------------------------------------------------------------------------
+// the old roll-up has run alongside since start, the next hours are compared every second
+static void matches_old(void)
+{
+  uint32_t records = EVQ_GetNextSeq();
+  uint32_t uncomplete_wrong = 0;
+  uint32_t frames_wrong = 0;
+  uint32_t record_wrong = 0;
+  CHECK_EQ(old_records_cnt, records);
+  for (uint32_t h = 0; h < records; h++)
+  {
+    record_wrong += (old_records[h] != hour_sum[h]) ? 1 : 0;
+  }
+
+  old_records_cnt = 0;
+  for (uint32_t sec = 0; sec < HOURS * 3600; sec++)
+  {
+    tick(second_cnt());
+    uncomplete_wrong += (EVQ_GetUncomplete() != old_uncomplete()) ? 1 : 0;
+    frames_wrong += old_frames_mismatch();
+    if (EVQ_GetEventsAmount() != 0)
+    {
+      CHECK_EQ(old_records_cnt, EVQ_GetNextSeq() - records);
+      record_wrong += (EVQ_GetEvt() != old_records[old_records_cnt - 1]) ? 1 : 0;
+    }
+  }
+  printf("  %u hourly records, the last %u hours compared every second\n", records + HOURS, HOURS);
+  CHECK_EQ(old_records_cnt, HOURS);
+  CHECK_EQ(uncomplete_wrong, 0);
+  CHECK_EQ(frames_wrong, 0);
+  CHECK_EQ(record_wrong, 0);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(24);
+  app_time_Init();
+  app_time_Set_UTC(UTC_START);
+  sched_Register(SCHED_PWT, PWT_Process);
+  EVQ_Startup();
+  old_start();
+
+  TEST_RUN(hour_records);
+  TEST_RUN(timeframes_match_records);
+  TEST_RUN(matches_old);
+  return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+#include <time.h>
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "realtime_particle_watcher.h"
+#include "sim.h"
+#include "test.h"
+
+// Running window sum of instant value against the previous implementation: every
+// second loop over slide_array of 8-bit buckets clamped to 255. Both give the same
+// value while seconds hold 255 pulses at most, above it only the running sum gives
+// the true window sum. Per tick cost of both for the window of this build
+
+#define EQUAL_S           20000
+#define WIDE_S            (3 * RPW_WINDOW_S)
+#define BENCH_S           200000
+#define BENCH_LOOPS       2000000
+
+static uint32_t pulses;
+
+// ----------------------------------------------------------------------------
+uint32_t particle_cnt_Get(void)
+{
+  return pulses;
+}
+
+void sound_alarm(void)
+{
+}
+
+void sound_danger(void)
+{
+}
+
+void HV_instantKick(void)
+{
+}
+
+void PWT_Tick(uint32_t cnt)
+{
+}
+
+// ---------------------------------------------------------------------------
+// OnTmr of the previous realtime_particle_watcher.c
+static uint8_t  old_slide_array[RPW_WINDOW_S];
+static uint8_t  old_pointer;
+static uint16_t old_summ;
+
+static void old_tick(uint32_t diff)
+{
+  diff = (diff > UINT8_MAX) ? UINT8_MAX : diff;
+  old_slide_array[old_pointer] = (uint8_t)diff;
+  old_pointer = (old_pointer + 1) % RPW_WINDOW_S;
+  old_summ = 0;
+  for (uint8_t i = 0; i < RPW_WINDOW_S; i++)
+  {
+    old_summ += old_slide_array[i];
+  }
+}
+
+// true sum of the newest seconds
+static uint32_t history[RPW_WINDOW_S];
+static uint32_t ticks;
+
+static uint32_t true_sum(void)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < RPW_WINDOW_S; i++)
+  {
+    sum += history[i];
+  }
+  return sum;
+}
+
+// pulses of the second come before RPW tick
+static void second(uint32_t cnt)
+{
+  pulses += cnt;
+  history[ticks++ % RPW_WINDOW_S] = cnt;
+  old_tick(cnt);
+  sim_Run(SIM_SEC(1));
+}
+
+// ---------------------------------------------------------------------------
+static void matches_old(void)
+{
+  uint32_t mismatch = 0;
+  uint32_t sec = 0;
+  while (sec < EQUAL_S)
+  {
+    uint32_t max = 1 + test_Rand() % 256;       // rate changes by spans
+    uint32_t span = 1 + test_Rand() % (2 * RPW_WINDOW_S);
+    for (uint32_t i = 0; (i < span) && (sec < EQUAL_S); i++, sec++)
+    {
+      second(test_Rand() % max);
+      mismatch += (RPW_GetInstant() != old_summ) ? 1 : 0;
+    }
+  }
+  CHECK_EQ(mismatch, 0);
+}
+
+// ---------------------------------------------------------------------------
+static void wide_buckets(void)
+{
+  uint32_t wrong = 0;
+  for (uint32_t sec = 0; sec < WIDE_S; sec++)
+  {
+    second(256 + test_Rand() % 1000);
+    uint32_t sum = true_sum();
+    wrong += (RPW_GetInstant() != MIN(sum, UINT16_MAX)) ? 1 : 0;
+  }
+  printf("  %u pulses in window, previous implementation gave %u\n", true_sum(), old_summ);
+  CHECK_EQ(wrong, 0);
+  CHECK_EQ(old_summ, UINT8_MAX * RPW_WINDOW_S);
+}
+
+// ---------------------------------------------------------------------------
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The running sum tick is timed with its simulated timer dispatch, the timer cost
+// is taken from the same run of ticks. Builds of 10, 40 and 120 s windows compare
+static void benchmark(void)
+{
+  double start = now_ns();
+  for (uint32_t i = 0; i < BENCH_LOOPS; i++)
+  {
+    old_tick(i & 0xFF);
+  }
+  double old_ns = (now_ns() - start) / BENCH_LOOPS;
+
+  start = now_ns();
+  for (uint32_t i = 0; i < BENCH_S; i++)
+  {
+    pulses += i & 0xFF;
+    sim_Run(SIM_SEC(1));
+  }
+  double new_ns = (now_ns() - start) / BENCH_S;
+  printf("  window %u s: loop sum %.1f ns per tick, running sum with timer dispatch %.1f ns\n",
+         RPW_WINDOW_S, old_ns, new_ns);
+  CHECK(old_summ <= UINT8_MAX * RPW_WINDOW_S);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(5);
+  app_time_Init();
+  RPW_Init();
+  RPW_Startup();
+
+  TEST_RUN(matches_old);
+  TEST_RUN(wide_buckets);
+  TEST_RUN(benchmark);
+  return TEST_RESULT();
+}
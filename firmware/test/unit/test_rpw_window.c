@@ -0,0 +1,206 @@
+#include <math.h>
+#include "sdk_common.h"
+#include "app_time_lib.h"
+#include "realtime_particle_watcher.h"
+#include "sim.h"
+#include "test.h"
+
+// Adaptive window of instant value: error of estimate against the true rate stays in
+// RPW_TARGET_ERR_PM wherever the rate gives enough pulses in RPW_WINDOW_S, reported
+// error matches the real one, and a step of rate is followed in seconds. Running
+// window sum gives the same estimate as the shortest window searched every second
+
+#define MEASURE_S         2000
+#define STEP_CPS          50.0
+#define STEP_ERR          0.2     // estimate is taken as converged within 20 %
+#define TARGET_CNT        (1000000ul / (RPW_TARGET_ERR_PM * RPW_TARGET_ERR_PM))
+#define NAIVE_S           5000
+
+static uint32_t pulses;
+static uint32_t history[RPW_WINDOW_S];  // pulses of the newest seconds by tick number
+static uint32_t ticks;
+
+// ----------------------------------------------------------------------------
+uint32_t particle_cnt_Get(void)
+{
+  return pulses;
+}
+
+void sound_alarm(void)
+{
+}
+
+void sound_danger(void)
+{
+}
+
+void HV_instantKick(void)
+{
+}
+
+void PWT_Tick(uint32_t cnt)
+{
+}
+
+// ---------------------------------------------------------------------------
+static uint32_t poisson(double mean)
+{
+  uint32_t n = 0;
+  double t = test_Exp(1.0 / mean);
+  while (t < 1.0)
+  {
+    n++;
+    t += test_Exp(1.0 / mean);
+  }
+  return n;
+}
+
+// pulses of every second come before the RPW tick
+static void run_rate(double cps, uint32_t sec)
+{
+  for (uint32_t i = 0; i < sec; i++)
+  {
+    uint32_t cnt = poisson(cps);
+    pulses += cnt;
+    history[ticks++ % RPW_WINDOW_S] = cnt;
+    sim_Run(SIM_SEC(1));
+  }
+}
+
+// ---------------------------------------------------------------------------
+typedef struct
+{
+  double    rms_err;      // real relative error of value
+  double    reported;     // mean of reported error
+  uint8_t   window_max;
+} error_t;
+
+static error_t error_at(double cps)
+{
+  error_t res = { 0 };
+  double truth = cps * RPW_WINDOW_S;
+  double sq_sum = 0;
+  double rep_sum = 0;
+  run_rate(cps, RPW_WINDOW_S);          // window is filled with the rate
+
+  for (uint32_t sec = 0; sec < MEASURE_S; sec++)
+  {
+    rpw_estimate_t est;
+    run_rate(cps, 1);
+    RPW_GetEstimate(&est);
+    double err = (est.value - truth) / truth;
+    sq_sum += err * err;
+    rep_sum += est.rel_err_pm / 1000.0;
+    res.window_max = MAX(res.window_max, est.window_s);
+  }
+  res.rms_err = sqrt(sq_sum / MEASURE_S);
+  res.reported = rep_sum / MEASURE_S;
+  printf("  %6.1f cps: window up to %2u s, error %.3f, reported %.3f\n",
+         cps, res.window_max, res.rms_err, res.reported);
+  return res;
+}
+
+// ---------------------------------------------------------------------------
+static void error_bound(void)
+{
+  static const double rates[] = { 5, 20, 50, 200, 1000 };
+  double target = RPW_TARGET_ERR_PM / 1000.0;
+  for (uint8_t i = 0; i < ARRAY_SIZE(rates); i++)
+  {
+    error_t e = error_at(rates[i]);
+    CHECK(e.window_max < RPW_WINDOW_S);
+    CHECK(e.rms_err <= target * 1.15);
+    CHECK(e.reported <= target);
+    CHECK_NEAR(e.rms_err, e.reported, e.reported * 0.25);
+  }
+}
+
+// too few pulses for target error: the whole window is used and error is reported as is
+static void background_full_window(void)
+{
+  error_t e = error_at(0.4);
+  CHECK_EQ(e.window_max, RPW_WINDOW_S);
+  CHECK(e.reported > RPW_TARGET_ERR_PM / 1000.0);
+  CHECK_NEAR(e.rms_err, e.reported, e.reported * 0.25);
+}
+
+// ---------------------------------------------------------------------------
+static void step_convergence(void)
+{
+  uint32_t trials = 50;
+  uint32_t delay_sum = 0;
+  uint32_t delay_max = 0;
+  double truth = STEP_CPS * RPW_WINDOW_S;
+  for (uint32_t i = 0; i < trials; i++)
+  {
+    run_rate(0.4, 2 * RPW_WINDOW_S);
+    uint32_t sec = 0;
+    rpw_estimate_t est;
+    do
+    {
+      run_rate(STEP_CPS, 1);
+      sec++;
+      RPW_GetEstimate(&est);
+    } while ((fabs(est.value - truth) > truth * STEP_ERR) && (sec < RPW_WINDOW_S));
+    delay_sum += sec;
+    delay_max = MAX(delay_max, sec);
+  }
+  printf("  step to %.0f cps is followed in %.1f s (max %u), fixed window takes about %.0f s\n",
+         STEP_CPS, (double)delay_sum / trials, delay_max, RPW_WINDOW_S * (1 - STEP_ERR));
+  // enough pulses for the target error come in the second of step
+  CHECK(delay_max <= (uint32_t)ceil(1000000.0 / (RPW_TARGET_ERR_PM * RPW_TARGET_ERR_PM) / STEP_CPS) + 2);
+}
+
+// ---------------------------------------------------------------------------
+// the shortest span of the newest seconds holding TARGET_CNT, searched from the newest one
+static void naive_estimate(rpw_estimate_t *p_est)
+{
+  uint32_t filled = MIN(ticks, RPW_WINDOW_S);
+  uint32_t sum = 0;
+  uint32_t window = 0;
+  while ((window < filled) && (sum < TARGET_CNT))
+  {
+    sum += history[(ticks - 1 - window) % RPW_WINDOW_S];
+    window++;
+  }
+  uint32_t value = sum * RPW_WINDOW_S / window;
+  p_est->value = (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+  p_est->window_s = (uint8_t)window;
+}
+
+static void matches_naive(void)
+{
+  static const double rates[] = { 0, 0.5, 3, 20, 150, 2000 };
+  uint32_t mismatch = 0;
+  uint32_t sec = 0;
+  while (sec < NAIVE_S)
+  {
+    double cps = rates[test_Rand() % ARRAY_SIZE(rates)];
+    uint32_t span = 1 + test_Rand() % 30;
+    for (uint32_t i = 0; i < span; i++, sec++)
+    {
+      rpw_estimate_t est;
+      rpw_estimate_t naive;
+      run_rate(cps, 1);
+      RPW_GetEstimate(&est);
+      naive_estimate(&naive);
+      mismatch += ((est.value != naive.value) || (est.window_s != naive.window_s)) ? 1 : 0;
+    }
+  }
+  CHECK_EQ(mismatch, 0);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  test_Seed(23);
+  app_time_Init();
+  RPW_Init();
+  RPW_Startup();
+
+  TEST_RUN(matches_naive);
+  TEST_RUN(error_bound);
+  TEST_RUN(background_full_window);
+  TEST_RUN(step_convergence);
+  return TEST_RESULT();
+}
@@ -0,0 +1,245 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "sim.h"
+#include "test.h"
+
+// Run to completion scheduler: the most urgent posted task runs first, a post during
+// run isn't lost and a task posting itself gives way to more urgent ones. Loop
+// iterations and dispatches of a simulated hour against the polled loop it replaced
+
+#define HOUR_S        3600
+#define PULSE_CPS     5.0       // pulse interrupt posts particle_cnt task
+#define PWT_MS        10000     // bar timer posts PWT task
+#define BAT_MS        60000     // battery timer posts its task
+#define RPW_MS        1000      // RPW tick posts nothing
+#define POLLED_TASKS  4         // batMea, button, particle_cnt and BLE Process of polled loop
+
+APP_TIMER_DEF(rpw_tmr);
+APP_TIMER_DEF(pwt_tmr);
+APP_TIMER_DEF(bat_tmr);
+
+static sched_task_t order[16];
+static uint8_t      order_len;
+static uint8_t      self_posts;
+
+// ---------------------------------------------------------------------------
+static void log_run(sched_task_t task)
+{
+  if (order_len < ARRAY_SIZE(order))
+  {
+    order[order_len] = task;
+  }
+  order_len++;
+}
+
+static void pulse_task(void)
+{
+  log_run(SCHED_PULSE);
+}
+
+static void button_task(void)
+{
+  log_run(SCHED_BUTTON);
+}
+
+// posts more urgent task and itself
+static void ble_task(void)
+{
+  log_run(SCHED_BLE);
+  if (self_posts > 0)
+  {
+    self_posts--;
+    sched_Post(SCHED_PULSE);
+    sched_Post(SCHED_BLE);
+  }
+}
+
+static void pwt_task(void)
+{
+  log_run(SCHED_PWT);
+}
+
+static void bat_task(void)
+{
+  log_run(SCHED_BAT);
+}
+
+// ---------------------------------------------------------------------------
+static void priority_order(void)
+{
+  order_len = 0;
+  sched_Post(SCHED_BAT);
+  sched_Post(SCHED_PWT);
+  sched_Post(SCHED_BUTTON);
+  sched_Post(SCHED_BAT);        // posted twice before run: runs once
+  CHECK_EQ(sched_GetPending(), (1ul << SCHED_BAT) | (1ul << SCHED_PWT) | (1ul << SCHED_BUTTON));
+  sched_Run();
+  CHECK(!sched_IsPending());
+  CHECK_EQ(order_len, 3);
+  CHECK_EQ(order[0], SCHED_BUTTON);
+  CHECK_EQ(order[1], SCHED_PWT);
+  CHECK_EQ(order[2], SCHED_BAT);
+}
+
+// ---------------------------------------------------------------------------
+static void post_during_run(void)
+{
+  order_len = 0;
+  self_posts = 2;
+  uint32_t ble_runs = sched_GetRunCnt(SCHED_BLE);
+  sched_Post(SCHED_BLE);
+  sched_Post(SCHED_BAT);
+  sched_Run();
+  CHECK_EQ(sched_GetRunCnt(SCHED_BLE) - ble_runs, 3);
+  static const sched_task_t expected[] = {SCHED_BLE, SCHED_PULSE, SCHED_BLE, SCHED_PULSE, SCHED_BLE, SCHED_BAT};
+  CHECK_EQ(order_len, ARRAY_SIZE(expected));
+  for (uint8_t i = 0; i < ARRAY_SIZE(expected); i++)
+  {
+    CHECK_EQ(order[i], expected[i]);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Polled loop of the previous main(): every iteration calls all Process functions,
+// interrupt setting a module flag locks sleep for one more iteration
+typedef struct
+{
+  uint32_t  iterations;
+  uint32_t  dispatches;
+  uint32_t  posts;
+} loop_cnt_t;
+
+static bool       is_polled;
+static bool       sleep_lock;
+static loop_cnt_t cnt;
+
+static void post(sched_task_t task)
+{
+  cnt.posts++;
+  if (is_polled)
+  {
+    sleep_lock = true;
+  }
+  else
+  {
+    sched_Post(task);
+  }
+}
+
+static void main_loop(void *p_ctx)
+{
+  if (is_polled)
+  {
+    bool is_locked;
+    do
+    {
+      cnt.iterations++;
+      cnt.dispatches += POLLED_TASKS;
+      is_locked = sleep_lock;         // sleepLock_check() of the previous main()
+      sleep_lock = false;
+    } while (is_locked);
+    return;
+  }
+
+  uint32_t runs = 0;
+  for (uint8_t i = 0; i < SCHED_TASKS_TOTAL; i++)
+  {
+    runs -= sched_GetRunCnt((sched_task_t)i);
+  }
+  sched_Run();
+  for (uint8_t i = 0; i < SCHED_TASKS_TOTAL; i++)
+  {
+    runs += sched_GetRunCnt((sched_task_t)i);
+  }
+  cnt.iterations++;
+  cnt.dispatches += runs;
+}
+
+static void pulse_isr(void *p_ctx)
+{
+  post(SCHED_PULSE);
+}
+
+static void pulse_evt(void *p_ctx)
+{
+  sim_IrqPend(SIM_IRQ_GPIOTE);
+  sim_At(sim_GetUs() + (uint64_t)(test_Exp(1.0 / PULSE_CPS) * SIM_US_PER_SEC) + 1, pulse_evt, NULL);
+}
+
+static void on_rpw(void *p_ctx)
+{
+}
+
+static void on_pwt(void *p_ctx)
+{
+  post(SCHED_PWT);
+}
+
+static void on_bat(void *p_ctx)
+{
+  post(SCHED_BAT);
+}
+
+static loop_cnt_t run_hour(bool polled)
+{
+  test_Seed(16);
+  is_polled = polled;
+  cnt = (loop_cnt_t){ 0 };
+  APP_ERROR_CHECK(app_timer_start(rpw_tmr, MS_TO_TICK(RPW_MS), NULL));
+  APP_ERROR_CHECK(app_timer_start(pwt_tmr, MS_TO_TICK(PWT_MS), NULL));
+  APP_ERROR_CHECK(app_timer_start(bat_tmr, MS_TO_TICK(BAT_MS), NULL));
+  int evt = sim_At(sim_GetUs() + 1, pulse_evt, NULL);
+  sim_Run(SIM_SEC(HOUR_S));
+  sim_Cancel(evt);
+  APP_ERROR_CHECK(app_timer_stop(rpw_tmr));
+  APP_ERROR_CHECK(app_timer_stop(pwt_tmr));
+  APP_ERROR_CHECK(app_timer_stop(bat_tmr));
+  return cnt;
+}
+
+static void dispatches_per_hour(void)
+{
+  uint32_t wakeups = sim_GetWakeups();
+  loop_cnt_t polled = run_hour(true);
+  uint32_t polled_wakeups = sim_GetWakeups() - wakeups;
+  wakeups = sim_GetWakeups();
+  loop_cnt_t sched = run_hour(false);
+  wakeups = sim_GetWakeups() - wakeups;
+  printf("  %u wakeups, %u events\n", wakeups, sched.posts);
+  printf("  polled loop: %u iterations, %u dispatches\n", polled.iterations, polled.dispatches);
+  printf("  scheduler:   %u iterations, %u dispatches\n", sched.iterations, sched.dispatches);
+
+  // the same load: pulses are seeded alike, timers give the same wakeups
+  CHECK_EQ(wakeups, polled_wakeups);
+  CHECK_EQ(sched.posts, polled.posts);
+  CHECK(sched.posts >= HOUR_S * PULSE_CPS * 0.95);
+  // an iteration per wakeup, and only posted tasks run: none after RPW tick
+  CHECK_EQ(sched.iterations, wakeups);
+  CHECK_EQ(sched.dispatches, sched.posts);
+  CHECK(polled.iterations > wakeups);
+  CHECK_EQ(polled.dispatches, polled.iterations * POLLED_TASKS);
+  CHECK(sched.dispatches * POLLED_TASKS * 2 <= polled.dispatches);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sched_Register(SCHED_PULSE, pulse_task);
+  sched_Register(SCHED_BUTTON, button_task);
+  sched_Register(SCHED_BLE, ble_task);
+  sched_Register(SCHED_PWT, pwt_task);
+  sched_Register(SCHED_BAT, bat_task);
+  sim_IrqConnect(SIM_IRQ_GPIOTE, pulse_isr, NULL, 0);
+  APP_ERROR_CHECK(app_timer_create(&rpw_tmr, APP_TIMER_MODE_REPEATED, on_rpw));
+  APP_ERROR_CHECK(app_timer_create(&pwt_tmr, APP_TIMER_MODE_REPEATED, on_pwt));
+  APP_ERROR_CHECK(app_timer_create(&bat_tmr, APP_TIMER_MODE_REPEATED, on_bat));
+
+  TEST_RUN(priority_order);
+  TEST_RUN(post_during_run);
+  sim_SetMainLoop(main_loop, NULL);
+  TEST_RUN(dispatches_per_hour);
+  return TEST_RESULT();
+}
@@ -0,0 +1,122 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "scheduler.h"
+#include "sim.h"
+#include "test.h"
+
+// Harness self-check: app_timer semantics on virtual clock, wakeup accounting and
+// 64-bit system time of app_time_lib over RTC 24-bit wraps
+
+APP_TIMER_DEF(tmr_a);
+APP_TIMER_DEF(tmr_b);
+
+static uint64_t a_hits[8];
+static uint32_t a_cnt;
+static uint32_t b_cnt;
+static uint32_t task_cnt;
+
+static void on_a(void *p_ctx)
+{
+  if (a_cnt < 8)
+  {
+    a_hits[a_cnt] = app_time_Get_sys_time();
+  }
+  a_cnt++;
+}
+
+static void on_b(void *p_ctx)
+{
+  b_cnt++;
+  sched_Post(SCHED_PWT);
+}
+
+static void pwt_task(void)
+{
+  task_cnt++;
+}
+
+static void main_loop(void *p_ctx)
+{
+  sched_Run();
+}
+
+// ---------------------------------------------------------------------------
+static void repeated_period(void)
+{
+  APP_ERROR_CHECK(app_timer_create(&tmr_a, APP_TIMER_MODE_REPEATED, on_a));
+  uint64_t start = app_time_Get_sys_time();
+  APP_ERROR_CHECK(app_timer_start(tmr_a, 100, NULL));
+  CHECK_EQ(app_timer_start(tmr_a, 7, NULL), NRF_SUCCESS);   // running timer keeps its expiry
+  sim_Run(sim_TicksToUs(1000) + 10);
+  CHECK_EQ(a_cnt, 10);
+  for (int i = 0; i < 8; i++)
+  {
+    CHECK_EQ(a_hits[i] - start, 100 * (i + 1));
+  }
+  APP_ERROR_CHECK(app_timer_stop(tmr_a));
+  sim_Run(SIM_SEC(1));
+  CHECK_EQ(a_cnt, 10);
+  CHECK_EQ(app_timer_start(tmr_a, 4, NULL), NRF_ERROR_INVALID_PARAM);
+}
+
+// ---------------------------------------------------------------------------
+static void batch_is_one_wakeup(void)
+{
+  APP_ERROR_CHECK(app_timer_create(&tmr_b, APP_TIMER_MODE_SINGLE_SHOT, on_b));
+  a_cnt = 0;
+  APP_ERROR_CHECK(app_timer_start(tmr_a, 50, NULL));
+  APP_ERROR_CHECK(app_timer_start(tmr_b, 50, NULL));
+  uint32_t wakeups = sim_GetWakeups();
+  sim_Run(sim_TicksToUs(50) + 10);
+  CHECK_EQ(a_cnt, 1);
+  CHECK_EQ(b_cnt, 1);
+  CHECK_EQ(sim_GetWakeups() - wakeups, 1);
+  CHECK_EQ(task_cnt, 1);            // posted task ran after the wakeup
+  CHECK(!sched_IsPending());
+  APP_ERROR_CHECK(app_timer_stop(tmr_a));
+}
+
+// ---------------------------------------------------------------------------
+static void radio_delays_timer(void)
+{
+  sim_SetRadioBlock(10000, 3000);
+  sim_RunUntil((sim_GetUs() / 10000 + 1) * 10000 - 100);   // just before radio event
+  b_cnt = 0;
+  uint64_t start = sim_GetUs();
+  APP_ERROR_CHECK(app_timer_start(tmr_b, 5, NULL));      // expires inside radio event
+  sim_Run(SIM_MS(5));
+  CHECK_EQ(b_cnt, 1);
+  CHECK((a_cnt == 1) && (sim_GetUs() - start >= SIM_MS(5)));
+  sim_SetRadioBlock(0, 0);
+}
+
+// ---------------------------------------------------------------------------
+static void sys_time_over_rtc_wrap(void)
+{
+  // 24-bit RTC wraps every 512 s, system time must go on monotonously
+  uint64_t prev = app_time_Get_sys_time();
+  for (int i = 0; i < 40; i++)
+  {
+    sim_Run(SIM_SEC(97));
+    uint64_t now = app_time_Get_sys_time();
+    CHECK_EQ(now, sim_GetTicks());
+    CHECK(now > prev);
+    prev = now;
+  }
+  CHECK(sim_GetTicks() > 4 * (SIM_RTC_MASK + 1ull));
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  sched_Register(SCHED_PWT, pwt_task);
+  sim_SetMainLoop(main_loop, NULL);
+
+  TEST_RUN(repeated_period);
+  TEST_RUN(batch_is_one_wakeup);
+  TEST_RUN(radio_delays_timer);
+  TEST_RUN(sys_time_over_rtc_wrap);
+  return TEST_RESULT();
+}
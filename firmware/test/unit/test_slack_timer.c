@@ -0,0 +1,292 @@
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "app_time_lib.h"
+#include "slack_timer.h"
+#include "sim.h"
+#include "test.h"
+
+// Slack timers: periodic timers with slack share wakeups, every expiry stays inside
+// [due, due + slack], nominal period doesn't drift, re-create doesn't break the list,
+// restarts that don't move the nearest deadline don't queue app_timer operations.
+// Wakeups per hour of firmware load with app_timers against slack timers
+
+#define TICKS(ms)   MS_TO_TICK(ms)
+#define BURST       10
+#define HOUR_S      3600
+#define HV_WORK_MS  20      // pump cycle pause on precise app_timer
+#define HV_WORKS    3       // pump cycles of recharge
+
+typedef struct
+{
+  uint32_t  period_ms;
+  uint32_t  slack_ms;
+  uint32_t  cnt;
+  uint64_t  start;
+  uint64_t  late_max;     // ticks after nominal expiry
+  bool      is_early;
+} probe_t;
+
+SLACK_TIMER_DEF(tmr_rpw);
+SLACK_TIMER_DEF(tmr_enrg);
+SLACK_TIMER_DEF(tmr_cpu);
+
+static probe_t probes[3] =
+{
+  {.period_ms = 1000, .slack_ms = 0},       // RPW tick, no slack
+  {.period_ms = 3000, .slack_ms = 1000},    // energy report
+  {.period_ms = 2500, .slack_ms = 900},     // CPU usage report
+};
+
+static void on_tmr(void *p_ctx)
+{
+  probe_t *p = p_ctx;
+  p->cnt++;
+  uint64_t due = p->start + (uint64_t)p->cnt * TICKS(p->period_ms);
+  uint64_t now = app_time_Get_sys_time();
+  if (now < due)
+  {
+    p->is_early = true;
+  }
+  else
+  {
+    p->late_max = MAX(p->late_max, now - due);
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void shared_wakeups(void)
+{
+  slack_timer_id_t ids[3] = {tmr_rpw, tmr_enrg, tmr_cpu};
+  for (int i = 0; i < 3; i++)
+  {
+    APP_ERROR_CHECK(slack_timer_create(&ids[i], APP_TIMER_MODE_REPEATED, on_tmr, TICKS(probes[i].slack_ms)));
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    probes[i].start = app_time_Get_sys_time();
+    APP_ERROR_CHECK(slack_timer_start(ids[i], TICKS(probes[i].period_ms), &probes[i]));
+  }
+
+  uint32_t wakeups = sim_GetWakeups();
+  sim_Run(SIM_SEC(600) + SIM_MS(100));
+  wakeups = sim_GetWakeups() - wakeups;
+
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK_EQ(probes[i].cnt, 600000 / probes[i].period_ms);
+    CHECK(!probes[i].is_early);
+    CHECK(probes[i].late_max <= TICKS(probes[i].slack_ms) + 1);
+  }
+  // 600 + 200 + 240 expirations, report ones ride on RPW ticks
+  printf("  wakeups %u of %u expirations\n", wakeups, probes[0].cnt + probes[1].cnt + probes[2].cnt);
+  CHECK(wakeups <= 600 + 600 / 100);    // RTC half range timer of app_time_lib wakes too
+}
+
+// ---------------------------------------------------------------------------
+static void recreate_keeps_list(void)
+{
+  CHECK_EQ(slack_timer_create(&tmr_cpu, APP_TIMER_MODE_REPEATED, on_tmr, 0), NRF_ERROR_INVALID_STATE);
+  APP_ERROR_CHECK(slack_timer_stop(tmr_cpu));
+  APP_ERROR_CHECK(slack_timer_create(&tmr_cpu, APP_TIMER_MODE_SINGLE_SHOT, on_tmr, 0));
+
+  probe_t *p = &probes[2];
+  p->cnt = 0;
+  p->start = app_time_Get_sys_time();
+  APP_ERROR_CHECK(slack_timer_start(tmr_cpu, TICKS(p->period_ms), p));
+  sim_Run(SIM_SEC(10));
+  CHECK_EQ(p->cnt, 1);
+  CHECK(!p->is_early);
+
+  // list walk ends, so other timers go on
+  uint32_t rpw_cnt = probes[0].cnt;
+  sim_Run(SIM_SEC(5));
+  CHECK_EQ(probes[0].cnt - rpw_cnt, 5);
+}
+
+// ---------------------------------------------------------------------------
+static void start_from_interrupt(void *p_ctx)
+{
+  probe_t *p = p_ctx;
+  p->cnt = 0;
+  p->start = app_time_Get_sys_time();
+  APP_ERROR_CHECK(slack_timer_start(tmr_cpu, TICKS(p->period_ms), p));
+}
+
+static void sys_time_is_guarded(void)
+{
+  uint32_t critical = sim_GetCriticalCnt();
+  (void)app_time_Get_sys_time();
+  CHECK(sim_GetCriticalCnt() > critical);     // 64-bit refresh is shared with interrupts
+
+  sim_At(sim_GetUs() + 1234, start_from_interrupt, &probes[2]);
+  sim_Run(SIM_SEC(3));
+  CHECK_EQ(probes[2].cnt, 1);
+  CHECK(!probes[2].is_early);
+}
+
+// ---------------------------------------------------------------------------
+// interrupt restarts report timers, their deadlines are later than RPW tick
+static void restart_burst(void *p_ctx)
+{
+  (void)p_ctx;
+  for (int i = 0; i < BURST; i++)
+  {
+    probes[1].start = app_time_Get_sys_time();
+    probes[1].cnt = 0;
+    APP_ERROR_CHECK(slack_timer_stop(tmr_enrg));
+    APP_ERROR_CHECK(slack_timer_start(tmr_enrg, TICKS(probes[1].period_ms), &probes[1]));
+  }
+}
+
+static void burst_keeps_op_queue(void)
+{
+  sim_IrqConnect(SIM_IRQ_GPIOTE, restart_burst, NULL, 0);
+  sim_Run(SIM_MS(300));
+  (void)sim_GetTimerOpsMax();
+  sim_IrqPend(SIM_IRQ_GPIOTE);
+  sim_Run(SIM_MS(10));
+  CHECK_EQ(sim_GetTimerOpsMax(), 0);
+
+  // the nearest deadline moves once per wakeup
+  uint32_t rpw_cnt = probes[0].cnt;
+  sim_Run(SIM_SEC(10));
+  CHECK_EQ(probes[0].cnt - rpw_cnt, 10);
+  CHECK(sim_GetTimerOpsMax() <= 2);
+  CHECK(!probes[1].is_early);
+}
+
+// ---------------------------------------------------------------------------
+// Firmware load: RPW tick, CPU usage report, energy report and HV pump steady pause
+// followed by pump cycles on app_timer. Timers start at different moments like they do
+typedef struct
+{
+  uint32_t  period_ms;
+  uint32_t  slack_ms;
+  uint32_t  phase_ms;
+} load_t;
+
+enum {LOAD_RPW, LOAD_CPU, LOAD_ENRG, LOAD_HV, LOAD_TOTAL};
+
+static load_t load[LOAD_TOTAL] =
+{
+  [LOAD_RPW]  = {.period_ms = 1000,  .slack_ms = 0,    .phase_ms = 0},
+  [LOAD_CPU]  = {.period_ms = 1000,  .slack_ms = 1000, .phase_ms = 130},
+  [LOAD_ENRG] = {.period_ms = 60000, .slack_ms = 1000, .phase_ms = 270},
+  [LOAD_HV]   = {.period_ms = 10000, .slack_ms = 1000, .phase_ms = 410},
+};
+
+APP_TIMER_DEF(plain_rpw);
+APP_TIMER_DEF(plain_cpu);
+APP_TIMER_DEF(plain_enrg);
+APP_TIMER_DEF(plain_hv);
+APP_TIMER_DEF(hv_work_tmr);
+SLACK_TIMER_DEF(slack_cpu);
+SLACK_TIMER_DEF(slack_hv);
+
+static bool     is_slack;
+static uint32_t hv_works;
+static uint32_t hv_recharges;
+
+static void on_load(void *p_ctx)
+{
+  (void)p_ctx;
+}
+
+static void on_hv_steady(void *p_ctx)
+{
+  (void)p_ctx;
+  hv_recharges++;
+  hv_works = 0;
+  APP_ERROR_CHECK(app_timer_start(hv_work_tmr, TICKS(HV_WORK_MS), NULL));
+}
+
+static void on_hv_work(void *p_ctx)
+{
+  (void)p_ctx;
+  if (++hv_works < HV_WORKS)
+  {
+    APP_ERROR_CHECK(app_timer_start(hv_work_tmr, TICKS(HV_WORK_MS), NULL));
+  }
+  else if (is_slack)
+  {
+    APP_ERROR_CHECK(slack_timer_start(slack_hv, TICKS(load[LOAD_HV].period_ms), NULL));
+  }
+  else
+  {
+    APP_ERROR_CHECK(app_timer_start(plain_hv, TICKS(load[LOAD_HV].period_ms), NULL));
+  }
+}
+
+static uint32_t wakeups_of_hour(void)
+{
+  APP_ERROR_CHECK(slack_timer_create(&tmr_rpw, APP_TIMER_MODE_REPEATED, on_load, 0));
+  APP_ERROR_CHECK(slack_timer_create(&tmr_enrg, APP_TIMER_MODE_REPEATED, on_load, TICKS(load[LOAD_ENRG].slack_ms)));
+  APP_ERROR_CHECK(slack_timer_create(&slack_cpu, APP_TIMER_MODE_REPEATED, on_load, TICKS(load[LOAD_CPU].slack_ms)));
+  APP_ERROR_CHECK(slack_timer_create(&slack_hv, APP_TIMER_MODE_SINGLE_SHOT, on_hv_steady, TICKS(load[LOAD_HV].slack_ms)));
+  APP_ERROR_CHECK(app_timer_create(&plain_rpw, APP_TIMER_MODE_REPEATED, on_load));
+  APP_ERROR_CHECK(app_timer_create(&plain_cpu, APP_TIMER_MODE_REPEATED, on_load));
+  APP_ERROR_CHECK(app_timer_create(&plain_enrg, APP_TIMER_MODE_REPEATED, on_load));
+  APP_ERROR_CHECK(app_timer_create(&plain_hv, APP_TIMER_MODE_SINGLE_SHOT, on_hv_steady));
+  APP_ERROR_CHECK(app_timer_create(&hv_work_tmr, APP_TIMER_MODE_SINGLE_SHOT, on_hv_work));
+
+  slack_timer_id_t slack_ids[LOAD_TOTAL] = {tmr_rpw, slack_cpu, tmr_enrg, slack_hv};
+  app_timer_id_t plain_ids[LOAD_TOTAL] = {plain_rpw, plain_cpu, plain_enrg, plain_hv};
+  uint32_t phase_ms = 0;
+  for (int i = 0; i < LOAD_TOTAL; i++)
+  {
+    sim_Run(SIM_MS(load[i].phase_ms - phase_ms));
+    phase_ms = load[i].phase_ms;
+    uint32_t ticks = TICKS(load[i].period_ms);
+    APP_ERROR_CHECK(is_slack ? slack_timer_start(slack_ids[i], ticks, NULL) : app_timer_start(plain_ids[i], ticks, NULL));
+  }
+
+  hv_recharges = 0;
+  uint32_t wakeups = sim_GetWakeups();
+  sim_Run(SIM_SEC(HOUR_S));
+  wakeups = sim_GetWakeups() - wakeups;
+
+  for (int i = 0; i < LOAD_TOTAL; i++)
+  {
+    APP_ERROR_CHECK(slack_timer_stop(slack_ids[i]));
+    APP_ERROR_CHECK(app_timer_stop(plain_ids[i]));
+  }
+  APP_ERROR_CHECK(app_timer_stop(hv_work_tmr));
+  sim_Run(SIM_SEC(2));
+  return wakeups;
+}
+
+static void wakeups_per_hour(void)
+{
+  APP_ERROR_CHECK(slack_timer_stop(tmr_rpw));
+  APP_ERROR_CHECK(slack_timer_stop(tmr_enrg));
+  APP_ERROR_CHECK(slack_timer_stop(tmr_cpu));
+  is_slack = false;
+  uint32_t before = wakeups_of_hour();
+  uint32_t before_recharges = hv_recharges;
+  is_slack = true;
+  (void)sim_GetTimerOpsMax();
+  uint32_t after = wakeups_of_hour();
+  printf("  app_timer %u, slack timer %u wakeups per hour, %u ops per interrupt at most\n",
+         before, after, sim_GetTimerOpsMax());
+
+  // every expiration of app_timer load wakes by itself, each second tick but the first
+  // one of steady pause has to be merged with RPW one
+  uint32_t pump_wakeups = hv_recharges * HV_WORKS;
+  CHECK(before >= HOUR_S * 2 + HOUR_S / 60 + before_recharges * (HV_WORKS + 1) - 2);
+  CHECK(after <= HOUR_S + pump_wakeups + HOUR_S / 256 + 1);
+  CHECK(hv_recharges * 11 >= before_recharges * 10);   // pause is longer by slack at most
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  app_time_Init();
+  slack_timer_Init();
+
+  TEST_RUN(shared_wakeups);
+  TEST_RUN(recreate_keeps_list);
+  TEST_RUN(sys_time_is_guarded);
+  TEST_RUN(burst_keeps_op_queue);
+  TEST_RUN(wakeups_per_hour);
+  return TEST_RESULT();
+}
@@ -0,0 +1,156 @@
+#include "sdk_common.h"
+#include "typed_queue.h"
+#include "sim.h"
+#include "test.h"
+
+// Typed queue: empty queue gives nothing, full one refuses push or throws out the
+// oldest element by overwrite, order is kept over the buffer end, batch pop crosses it
+
+#define CAPACITY    5
+
+typedef struct
+{
+  uint16_t  cnt;
+  uint8_t   tag;
+} rec_t;
+
+TQUEUE_DEF(q, rec_t, CAPACITY);
+
+static uint16_t next_in;    // cnt of the next pushed record
+static uint16_t next_out;   // cnt of the next expected one
+
+static bool push(void)
+{
+  rec_t rec = {.cnt = next_in, .tag = (uint8_t)(next_in * 7)};
+  bool is_stored = q_push(&rec);
+  next_in += is_stored ? 1 : 0;
+  return is_stored;
+}
+
+static bool pop_expected(void)
+{
+  rec_t rec;
+  if (!q_pop(&rec))
+  {
+    return false;
+  }
+  bool is_right = (rec.cnt == next_out) && (rec.tag == (uint8_t)(next_out * 7));
+  next_out++;
+  return is_right;
+}
+
+// ---------------------------------------------------------------------------
+static void empty(void)
+{
+  rec_t rec = {.cnt = 0xAAAA};
+  rec_t batch[CAPACITY];
+  CHECK_EQ(q_count(), 0);
+  CHECK(!q_pop(&rec));
+  CHECK(!q_peek(&rec));
+  CHECK_EQ(rec.cnt, 0xAAAA);                  // nothing is written
+  CHECK_EQ(q_pop_batch(batch, CAPACITY), 0);
+
+  // emptied after use
+  CHECK(push());
+  CHECK(pop_expected());
+  CHECK_EQ(q_count(), 0);
+  CHECK(!q_pop(&rec));
+}
+
+// ---------------------------------------------------------------------------
+static void full(void)
+{
+  for (int i = 0; i < CAPACITY; i++)
+  {
+    CHECK(push());
+  }
+  CHECK_EQ(q_count(), CAPACITY);
+  CHECK(!push());                             // refused, queue is intact
+  CHECK_EQ(q_count(), CAPACITY);
+
+  rec_t rec;
+  CHECK(q_peek(&rec));
+  CHECK_EQ(rec.cnt, next_out);
+
+  // overwrite throws out the oldest one
+  rec_t newest = {.cnt = next_in, .tag = (uint8_t)(next_in * 7)};
+  CHECK(q_push_overwrite(&newest));
+  next_in++;
+  next_out++;
+  CHECK_EQ(q_count(), CAPACITY);
+  for (int i = 0; i < CAPACITY; i++)
+  {
+    CHECK(pop_expected());
+  }
+  CHECK_EQ(q_count(), 0);
+
+  // not full: nothing is dropped
+  CHECK(!q_push_overwrite(&newest));
+  CHECK_EQ(q_count(), 1);
+  q_reset();
+  CHECK_EQ(q_count(), 0);
+  next_out = next_in;
+}
+
+// ---------------------------------------------------------------------------
+static void wrap(void)
+{
+  uint32_t wrong = 0;
+  // every fill level over many turns of the buffer
+  for (int turn = 0; turn < 100; turn++)
+  {
+    int level = 1 + turn % CAPACITY;
+    for (int i = 0; i < level; i++)
+    {
+      wrong += push() ? 0 : 1;
+    }
+    for (int i = 0; i < level; i++)
+    {
+      wrong += pop_expected() ? 0 : 1;
+    }
+  }
+  CHECK_EQ(wrong, 0);
+
+  // batch pop across the buffer end, smaller array takes a part
+  q_reset();
+  next_out = next_in;
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK(push());
+    CHECK(pop_expected());
+  }
+  for (int i = 0; i < CAPACITY; i++)
+  {
+    CHECK(push());
+  }
+  rec_t batch[CAPACITY];
+  CHECK_EQ(q_pop_batch(batch, 4), 4);
+  CHECK_EQ(q_count(), 1);
+  for (int i = 0; i < 4; i++)
+  {
+    CHECK_EQ(batch[i].cnt, next_out + i);
+  }
+  next_out += 4;
+  CHECK(pop_expected());
+}
+
+// ---------------------------------------------------------------------------
+// producer of an interrupt and consumer of main loop share it
+static void critical_region(void)
+{
+  uint32_t critical = sim_GetCriticalCnt();
+  CHECK(push());
+  CHECK(pop_expected());
+  CHECK_EQ(sim_GetCriticalCnt() - critical, 2);
+  CHECK(!sim_IsCritical());
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  TEST_RUN(empty);
+  TEST_RUN(full);
+  TEST_RUN(wrap);
+  TEST_RUN(critical_region);
+  return TEST_RESULT();
+}
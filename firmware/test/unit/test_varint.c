@@ -0,0 +1,110 @@
+#include "sdk_common.h"
+#include "varint.h"
+#include "test.h"
+
+// Varint and zig-zag codec: every value survives round trip with the expected length,
+// truncated or too long input isn't decoded
+
+// ---------------------------------------------------------------------------
+static void zigzag(void)
+{
+  static const int32_t map[][2] = {{0, 0}, {-1, 1}, {1, 2}, {-2, 3}, {2, 4}, {INT32_MAX, 0xFFFFFFFE}, {INT32_MIN, 0xFFFFFFFF}};
+  for (uint32_t i = 0; i < ARRAY_SIZE(map); i++)
+  {
+    CHECK_EQ(zigzag_encode(map[i][0]), (uint32_t)map[i][1]);
+    CHECK_EQ(zigzag_decode((uint32_t)map[i][1]), map[i][0]);
+  }
+  for (uint32_t i = 0; i < 100000; i++)
+  {
+    int32_t v = (int32_t)test_Rand() >> (test_Rand() % 32);
+    uint32_t zz = zigzag_encode(v);
+    CHECK_EQ(zigzag_decode(zz), v);
+    CHECK((uint64_t)zz <= 2 * (uint64_t)(v < 0 ? -(int64_t)v : v));    // magnitude stays small
+  }
+}
+
+// ---------------------------------------------------------------------------
+static void round_trip(void)
+{
+  static const struct
+  {
+    uint32_t  v;
+    uint8_t   len;
+  } borders[] =
+  {
+    {0, 1}, {127, 1}, {128, 2}, {16383, 2}, {16384, 3},
+    {2097151, 3}, {2097152, 4}, {268435455, 4}, {268435456, 5}, {UINT32_MAX, 5},
+  };
+  uint8_t buf[VARINT_MAX_LEN + 1];
+  uint32_t v;
+
+  for (uint32_t i = 0; i < ARRAY_SIZE(borders); i++)
+  {
+    CHECK_EQ(varint_encode(borders[i].v, buf), borders[i].len);
+    CHECK_EQ(varint_decode(buf, sizeof(buf), &v), borders[i].len);
+    CHECK_EQ(v, borders[i].v);
+    // one byte less is not a whole value
+    CHECK_EQ(varint_decode(buf, borders[i].len - 1, &v), 0);
+  }
+  for (uint32_t i = 0; i < 100000; i++)
+  {
+    uint32_t x = test_Rand() >> (test_Rand() % 32);
+    uint8_t len = varint_encode(x, buf);
+    CHECK(len <= VARINT_MAX_LEN);
+    CHECK_EQ(varint_decode(buf, len, &v), len);
+    CHECK_EQ(v, x);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// deltas of a record stream as event queue keeps them
+static void stream(void)
+{
+  static uint8_t buf[1000 * VARINT_MAX_LEN];
+  static uint32_t values[1000];
+  uint32_t prev = 0;
+  size_t len = 0;
+
+  for (uint32_t i = 0; i < ARRAY_SIZE(values); i++)
+  {
+    values[i] = (i % 100 == 99) ? test_Rand() : 1500 + test_Rand() % 200;
+    len += varint_encode(zigzag_encode((int32_t)(values[i] - prev)), &buf[len]);
+    prev = values[i];
+  }
+
+  size_t used = 0;
+  uint32_t value = 0, zz, n = 0;
+  uint8_t vlen;
+  while ((used < len) && ((vlen = varint_decode(&buf[used], (uint8_t)MIN(len - used, 255), &zz)) > 0))
+  {
+    value += zigzag_decode(zz);
+    CHECK_EQ(value, values[n]);
+    used += vlen;
+    n++;
+  }
+  CHECK_EQ(n, ARRAY_SIZE(values));
+  CHECK_EQ(used, len);
+  printf("  %u records in %u bytes\n", n, (unsigned)len);
+}
+
+// ---------------------------------------------------------------------------
+static void malformed(void)
+{
+  // continuation flag on all bytes: value is longer than uint32_t
+  uint8_t buf[VARINT_MAX_LEN + 2];
+  uint32_t v = 0x12345678;
+  memset(buf, 0xFF, sizeof(buf));
+  CHECK_EQ(varint_decode(buf, sizeof(buf), &v), 0);
+  CHECK_EQ(v, 0x12345678);    // output isn't touched
+  CHECK_EQ(varint_decode(buf, 0, &v), 0);
+}
+
+// ---------------------------------------------------------------------------
+int main(void)
+{
+  TEST_RUN(zigzag);
+  TEST_RUN(round_trip);
+  TEST_RUN(stream);
+  TEST_RUN(malformed);
+  return TEST_RESULT();
+}